@@ -0,0 +1,138 @@
+#include "batch/BatchRunner.h"
+#include "batch/LockstepEngine.h"
+#include "batch/ScalarEngine.h"
+#include "util/Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace batch {
+	BatchRunner::Config::Config() :
+		numMachines(64),
+		engine(Engine::Scalar),
+		numThreads(0),
+		grainSize(8)
+	{
+
+	}
+
+	BatchRunner::Metrics::Metrics() :
+		numFrames(0),
+		seconds(0.0),
+		framesPerSecond(0.0),
+		lastFramesPerSecond(0.0),
+		numSteals(0),
+		stepsPerDispatch(0.0)
+	{
+
+	}
+
+	BatchRunner::BatchRunner() :
+		numStealsAtReset(0),
+		numStepsAtReset(0),
+		numDispatchesAtReset(0)
+	{
+
+	}
+
+	bool BatchRunner::init(const char* romFilename, const Config& inConfig) {
+		config = inConfig;
+
+		// load the ROM once, and share it between every machine in the batch
+		std::vector<uint8_t> rom;
+		if (!util::readFile(romFilename, rom)) {
+			return false;
+		}
+
+		if (rom.empty() || (rom.size() > 0x10000 - machine::Snapshot::kSizeRam)) {
+			printf("BatchRunner - unexpected ROM size %zu\n", rom.size());
+			return false;
+		}
+
+		switch (config.engine) {
+		case Engine::Scalar:
+			engine.reset(new ScalarEngine());
+			break;
+		case Engine::Lockstep:
+			engine.reset(new LockstepEngine());
+			break;
+		}
+
+		if (!engine->init(rom.data(), uint16_t(rom.size()), config.numMachines)) {
+			return false;
+		}
+
+		threadPool.reset(new util::ThreadPool(config.numThreads));
+
+		resetMetrics();
+
+		return true;
+	}
+
+	size_t BatchRunner::size() const {
+		return config.numMachines;
+	}
+
+	void BatchRunner::runFrame() {
+		assert(threadPool);
+
+		auto start = std::chrono::steady_clock::now();
+
+		// grain size is in machines, and the engine splits work into blocks of machines
+		const size_t blocksPerChunk = std::max<size_t>(1, config.grainSize / engine->getBlockSize());
+
+		threadPool->parallelFor(engine->getNumBlocks(), blocksPerChunk, [this](size_t begin, size_t end) {
+			engine->runFrame(begin, end);
+		});
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		metrics.numFrames += config.numMachines;
+		metrics.seconds += seconds;
+		metrics.framesPerSecond = (metrics.seconds > 0.0) ? (double(metrics.numFrames) / metrics.seconds) : 0.0;
+		metrics.lastFramesPerSecond = (seconds > 0.0) ? (double(config.numMachines) / seconds) : 0.0;
+		metrics.numSteals = threadPool->getNumSteals() - numStealsAtReset;
+
+		const uint64_t numDispatches = engine->getNumDispatches() - numDispatchesAtReset;
+		metrics.stepsPerDispatch = (numDispatches > 0) ? (double(engine->getNumSteps() - numStepsAtReset) / double(numDispatches)) : 0.0;
+	}
+
+	void BatchRunner::setInputPort(size_t index, uint8_t port, uint8_t value) {
+		assert(index < config.numMachines);
+		engine->setInputPort(index, port, value);
+	}
+
+	void BatchRunner::snapshot(size_t index, machine::Snapshot& outSnapshot) const {
+		assert(index < config.numMachines);
+		engine->snapshot(index, outSnapshot);
+	}
+
+	void BatchRunner::restore(size_t index, const machine::Snapshot& snapshot) {
+		assert(index < config.numMachines);
+		engine->restore(index, snapshot);
+	}
+
+	uint64_t BatchRunner::hashRam(size_t index) const {
+		assert(index < config.numMachines);
+		return engine->hashRam(index);
+	}
+
+	void BatchRunner::readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const {
+		assert(index < config.numMachines);
+		engine->readRam(index, address, size, outData);
+	}
+
+	const BatchRunner::Metrics& BatchRunner::getMetrics() const {
+		return metrics;
+	}
+
+	void BatchRunner::resetMetrics() {
+		metrics = Metrics();
+		numStealsAtReset = threadPool ? threadPool->getNumSteals() : 0;
+		numStepsAtReset = engine ? engine->getNumSteps() : 0;
+		numDispatchesAtReset = engine ? engine->getNumDispatches() : 0;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "batch/IEngine.h"
+#include "util/ThreadPool.h"
+
+namespace batch {
+
+	/// @class BatchRunner
+	/// @brief Run a batch of independent Space Invaders machines, one emulated frame at a time
+	/// @note machines are emulated by an engine (see IEngine), in blocks that are split between the workers
+	///       of a work-stealing thread pool. Each machine has its own CPU, memory, shift register and input
+	///       ports - set input ports between calls to runFrame().
+	class BatchRunner {
+	public:
+		enum class Engine {
+			Scalar,		// one machine::Machine per machine
+			Lockstep	// groups of machines run in lockstep by a SIMD friendly interpreter
+		};
+
+		/// @struct Config
+		/// @brief Size of the batch, and how it is split between threads
+		struct Config {
+			Config();
+
+			size_t numMachines;
+
+			Engine engine;
+
+			// number of worker threads - 0 uses one thread per hardware thread
+			size_t numThreads;
+
+			// number of machines in each chunk of work handed to a worker
+			size_t grainSize;
+		};
+
+		/// @struct Metrics
+		/// @brief Aggregate throughput of the batch
+		struct Metrics {
+			Metrics();
+
+			// total frames run, summed over all machines
+			uint64_t numFrames;
+			double seconds;
+
+			// aggregate frames per second, over all calls to runFrame() and for the most recent call
+			double framesPerSecond;
+			double lastFramesPerSecond;
+
+			// chunks of machines stolen by idle workers
+			uint64_t numSteals;
+
+			// average number of machines that executed each decoded instruction (1 for the scalar engine)
+			double stepsPerDispatch;
+		};
+
+		BatchRunner();
+
+		// create config.numMachines machines, all running the ROM loaded from romFilename
+		bool init(const char* romFilename, const Config& config);
+
+		size_t size() const;
+
+		// run one frame on every machine in the batch
+		void runFrame();
+
+		// latch the value of input port 0, 1 or 2 for a machine
+		void setInputPort(size_t index, uint8_t port, uint8_t value);
+
+		// capture / restore the complete state of a machine
+		void snapshot(size_t index, machine::Snapshot& outSnapshot) const;
+		void restore(size_t index, const machine::Snapshot& snapshot);
+
+		// hash the contents of RAM (including video RAM) of a machine
+		uint64_t hashRam(size_t index) const;
+
+		// copy size bytes of RAM of a machine, starting at address in the memory map (i.e. 0x2400 for video RAM)
+		void readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const;
+
+		const Metrics& getMetrics() const;
+		void resetMetrics();
+
+	private:
+		Config config;
+
+		std::unique_ptr<IEngine> engine;
+		std::unique_ptr<util::ThreadPool> threadPool;
+
+		Metrics metrics;
+		uint64_t numStealsAtReset;
+		uint64_t numStepsAtReset;
+		uint64_t numDispatchesAtReset;
+	};
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "machine/Snapshot.h"
+
+namespace batch {
+
+	/// @class IEngine
+	/// @brief Emulate a batch of independent Space Invaders machines
+	/// @note machines are split into blocks that can be run on different threads at the same time.
+	///       All other functions must not be called while a frame is running.
+	class IEngine {
+	public:
+		virtual ~IEngine() {};
+
+		// create numMachines machines, all running the same ROM
+		virtual bool init(const uint8_t* rom, uint16_t sizeRom, size_t numMachines) = 0;
+
+		// number of machines in the batch
+		virtual size_t size() const = 0;
+
+		// number of blocks, and number of machines in each block
+		virtual size_t getNumBlocks() const = 0;
+		virtual size_t getBlockSize() const = 0;
+
+		// run one frame on every machine in blocks [blockBegin, blockEnd)
+		virtual void runFrame(size_t blockBegin, size_t blockEnd) = 0;
+
+		// latch the value of input port 0, 1 or 2 for a machine
+		virtual void setInputPort(size_t index, uint8_t port, uint8_t value) = 0;
+
+		// capture / restore the complete state of a machine
+		virtual void snapshot(size_t index, machine::Snapshot& outSnapshot) const = 0;
+		virtual void restore(size_t index, const machine::Snapshot& snapshot) = 0;
+
+		// hash the contents of RAM (including video RAM) of a machine
+		virtual uint64_t hashRam(size_t index) const = 0;
+
+		// copy size bytes of RAM of a machine, starting at address in the memory map (i.e. 0x2400 for video RAM)
+		virtual void readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const = 0;
+
+		// number of instructions stepped over all machines, and number of times an instruction was
+		// decoded + executed (once per instruction for a scalar engine, once per group of lanes for SIMD)
+		virtual uint64_t getNumSteps() const = 0;
+		virtual uint64_t getNumDispatches() const = 0;
+	};
+}
@@ -0,0 +1,170 @@
+#include "batch/LockstepAvx2.h"
+
+// everything in this file is built for AVX2 - by EnableEnhancedInstructionSet on this file in the projects, or the
+// pragma below with gcc - so it must only hold code that is called after the CPU has been checked
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2")
+#endif
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace batch {
+	namespace avx2 {
+		namespace {
+			// bits of cpu::ConditionCodes::all, as in LockstepEngine
+			const uint8_t kFlagZ = 0x01;
+			const uint8_t kFlagS = 0x02;
+			const uint8_t kFlagP = 0x04;
+			const uint8_t kFlagCY = 0x08;
+			const uint8_t kFlagsZSP = kFlagZ | kFlagS | kFlagP;
+
+			inline __m128i load(const uint8_t* values) {
+				return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+			}
+
+			inline void store(uint8_t* values, __m128i value) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(values), value);
+			}
+
+			// 4 lanes of bytes, from which to widen
+			inline __m128i load4(const uint8_t* values) {
+				int32_t value;
+				memcpy(&value, values, sizeof(value));
+				return _mm_cvtsi32_si128(value);
+			}
+
+			// 16 lanes of 16 bit values, back to bytes - every value must be 0 - 0xff
+			inline __m128i pack(__m256i values) {
+				return _mm_packus_epi16(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+			}
+
+			// Z, S + P flags for 16 byte results
+			inline __m128i flagsZSP(__m128i value) {
+				// kFlagP for each nibble with an odd number of bits set - two odd nibbles make an even byte
+				const __m128i kOddNibbles = _mm_setr_epi8(0, kFlagP, kFlagP, 0, kFlagP, 0, 0, kFlagP, kFlagP, 0, 0, kFlagP, 0, kFlagP, kFlagP, 0);
+				const __m128i kNibbleMask = _mm_set1_epi8(0x0f);
+				const __m128i zero = _mm_setzero_si128();
+
+				const __m128i lo = _mm_shuffle_epi8(kOddNibbles, _mm_and_si128(value, kNibbleMask));
+				const __m128i hi = _mm_shuffle_epi8(kOddNibbles, _mm_and_si128(_mm_srli_epi16(value, 4), kNibbleMask));
+				const __m128i p = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_set1_epi8(kFlagP));
+				const __m128i z = _mm_and_si128(_mm_cmpeq_epi8(value, zero), _mm_set1_epi8(kFlagZ));
+				const __m128i s = _mm_and_si128(_mm_cmplt_epi8(value, zero), _mm_set1_epi8(kFlagS));
+
+				return _mm_or_si128(_mm_or_si128(z, s), p);
+			}
+		}
+
+		bool findLeader(const uint16_t* pc, const uint8_t* isRunning, size_t& outLeader, uint8_t* outMask) {
+			const __m128i isStopped = _mm_cmpeq_epi8(load(isRunning), _mm_setzero_si128());
+			if (_mm_movemask_epi8(isStopped) == 0xffff) {
+				return false;
+			}
+
+			// stopped lanes are moved to 0xFFFF, so they are never below a running lane
+			const __m256i pcs = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pc)), _mm256_cvtepi8_epi16(isStopped));
+			const __m128i minPc = _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(pcs), _mm256_extracti128_si256(pcs, 1)));
+			const __m256i isAtMin = _mm256_cmpeq_epi16(pcs, _mm256_broadcastw_epi16(minPc));
+
+			const __m128i mask = _mm_andnot_si128(isStopped, _mm_packs_epi16(_mm256_castsi256_si128(isAtMin), _mm256_extracti128_si256(isAtMin, 1)));
+			store(outMask, mask);
+
+			// the first lane at the lowest PC leads, as in LockstepEngine::runGroupFrame
+			uint32_t lanes = uint32_t(_mm_movemask_epi8(mask));
+			size_t leader = 0;
+			while ((lanes & 1) == 0) {
+				lanes >>= 1;
+				leader++;
+			}
+
+			outLeader = leader;
+			return true;
+		}
+
+		uint32_t retire(const uint8_t* mask, const uint8_t* isTaken, uint16_t opcodeSize, uint64_t cycles, uint64_t cyclesTaken,
+			uint64_t* numSteps, uint64_t* numCycles, uint16_t* pc, const uint64_t* nextInterruptCycle) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i isRun = load(mask);
+			const __m128i isJump = _mm_cmpgt_epi8(load(isTaken), zero);
+
+			__m256i* pcs = reinterpret_cast<__m256i*>(pc);
+			const __m256i isNext = _mm256_cvtepi8_epi16(_mm_andnot_si128(isJump, isRun));
+			_mm256_storeu_si256(pcs, _mm256_add_epi16(_mm256_loadu_si256(pcs), _mm256_and_si256(isNext, _mm256_set1_epi16(short(opcodeSize)))));
+
+			const __m256i cyclesNotTaken = _mm256_set1_epi64x(int64_t(cycles));
+			const __m256i cyclesIfTaken = _mm256_set1_epi64x(int64_t(cyclesTaken));
+			uint32_t isInterruptDue = 0;
+
+			// 64 bit counters, 4 lanes at a time
+			for (size_t i = 0; i < kNumLanes; i += 4) {
+				const __m256i isRun64 = _mm256_cvtepi8_epi64(load4(mask + i));
+				const __m256i isJump64 = _mm256_cmpgt_epi64(_mm256_cvtepu8_epi64(load4(isTaken + i)), _mm256_setzero_si256());
+
+				__m256i* steps = reinterpret_cast<__m256i*>(numSteps + i);
+				_mm256_storeu_si256(steps, _mm256_sub_epi64(_mm256_loadu_si256(steps), isRun64));
+
+				__m256i* laneCycles = reinterpret_cast<__m256i*>(numCycles + i);
+				const __m256i elapsed = _mm256_and_si256(isRun64, _mm256_blendv_epi8(cyclesNotTaken, cyclesIfTaken, isJump64));
+				const __m256i total = _mm256_add_epi64(_mm256_loadu_si256(laneCycles), elapsed);
+				_mm256_storeu_si256(laneCycles, total);
+
+				// counts stay far below 2^63, so a signed compare will do
+				const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nextInterruptCycle + i));
+				const __m256i isDue = _mm256_andnot_si256(_mm256_cmpgt_epi64(next, total), isRun64);
+				isInterruptDue |= uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(isDue))) << i;
+			}
+
+			return isInterruptDue;
+		}
+
+		void alu(const uint8_t* mask, int op, uint8_t* a, uint8_t* cc, const uint8_t* values) {
+			const __m128i isRun = load(mask);
+			const __m128i a8 = load(a);
+			const __m128i cc8 = load(cc);
+
+			// results are calculated as 16bit, carry is set if > 0xff
+			const __m256i a16 = _mm256_cvtepu8_epi16(a8);
+			const __m256i value = _mm256_cvtepu8_epi16(load(values));
+			const __m256i carry = _mm256_and_si256(_mm256_srli_epi16(_mm256_cvtepu8_epi16(cc8), 3), _mm256_set1_epi16(1));
+
+			__m256i answer = _mm256_setzero_si256();
+			switch (op) {
+			case 0: answer = _mm256_add_epi16(a16, value); break;
+			case 1: answer = _mm256_add_epi16(_mm256_add_epi16(a16, value), carry); break;
+			case 2: answer = _mm256_sub_epi16(a16, value); break;
+			case 3: answer = _mm256_sub_epi16(_mm256_sub_epi16(a16, value), carry); break;
+			case 4: answer = _mm256_and_si256(a16, value); break;
+			case 5: answer = _mm256_xor_si256(a16, value); break;
+			case 6: answer = _mm256_or_si256(a16, value); break;
+			case 7: answer = _mm256_sub_epi16(a16, value); break;
+			}
+
+			const __m128i result = pack(_mm256_and_si256(answer, _mm256_set1_epi16(0xff)));
+			const __m128i isCarry = _mm_cmpeq_epi8(pack(_mm256_srli_epi16(answer, 8)), _mm_setzero_si128());
+			const __m128i cy = _mm_andnot_si128(isCarry, _mm_set1_epi8(kFlagCY));
+			const __m128i flags = _mm_or_si128(_mm_andnot_si128(_mm_set1_epi8(kFlagsZSP | kFlagCY), cc8), _mm_or_si128(flagsZSP(result), cy));
+
+			if (op != 7) {
+				store(a, _mm_blendv_epi8(a8, result, isRun));
+			}
+			store(cc, _mm_blendv_epi8(cc8, flags, isRun));
+		}
+
+		void move(const uint8_t* mask, uint8_t* dst, const uint8_t* src) {
+			store(dst, _mm_blendv_epi8(load(dst), load(src), load(mask)));
+		}
+
+		void increment(const uint8_t* mask, uint8_t* values, uint8_t* cc, uint8_t delta) {
+			const __m128i isRun = load(mask);
+			const __m128i before = load(values);
+			const __m128i cc8 = load(cc);
+
+			const __m128i value = _mm_add_epi8(before, _mm_set1_epi8(char(delta)));
+			const __m128i flags = _mm_or_si128(_mm_andnot_si128(_mm_set1_epi8(kFlagsZSP), cc8), flagsZSP(value));
+
+			store(values, _mm_blendv_epi8(before, value, isRun));
+			store(cc, _mm_blendv_epi8(cc8, flags, isRun));
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace batch {
+
+	// AVX2 lane loops for LockstepEngine, over a group of 16 lanes - a lane mask is 0xff for lanes that run, 0x00 otherwise
+	// - compiled for AVX2 (see LockstepAvx2.cpp), so only call these once LockstepEngine has checked the CPU supports it
+	namespace avx2 {
+		const size_t kNumLanes = 16;
+
+		// find the lowest PC of the running lanes, and the first lane at it (outLeader) - outMask is set for every
+		// running lane at that PC. Returns false if no lane is running.
+		bool findLeader(const uint16_t* pc, const uint8_t* isRunning, size_t& outLeader, uint8_t* outMask);
+
+		// count a step + its cycles for lanes in mask, and move PC on for the lanes that did not change it (isTaken)
+		// - returns a bit per lane in mask that has reached its next interrupt
+		uint32_t retire(const uint8_t* mask, const uint8_t* isTaken, uint16_t opcodeSize, uint64_t cycles, uint64_t cyclesTaken,
+			uint64_t* numSteps, uint64_t* numCycles, uint16_t* pc, const uint64_t* nextInterruptCycle);
+
+		// ADD, ADC, SUB, SBB, ANA, XRA, ORA, CMP (op 0 - 7) of values into a, setting Z, S, P + CY
+		void alu(const uint8_t* mask, int op, uint8_t* a, uint8_t* cc, const uint8_t* values);
+
+		// MOV r, r
+		void move(const uint8_t* mask, uint8_t* dst, const uint8_t* src);
+
+		// INR / DCR of a register, setting Z, S + P
+		void increment(const uint8_t* mask, uint8_t* values, uint8_t* cc, uint8_t delta);
+	}
+}
@@ -0,0 +1,1000 @@
+#include "batch/LockstepEngine.h"
+#include "batch/LockstepAvx2.h"
+
+#include "cpu/CPU.h"
+#include "cpu/Opcodes.h"
+#include "machine/Machine.h"
+#include "util/Utils.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace batch {
+	namespace {
+		const size_t kNumLanes = LockstepEngine::kNumLanes;
+
+		// Space Invaders memory map - 8KB ROM, followed by 8KB RAM mirrored through the rest of the address space
+		const uint16_t kSizeRom = 0x2000;
+		const uint16_t kRamMask = machine::Snapshot::kSizeRam - 1;
+
+		const int kNumInputPorts = 3;
+
+		// bits of cpu::ConditionCodes::all
+		const uint8_t kFlagZ = 0x01;
+		const uint8_t kFlagS = 0x02;
+		const uint8_t kFlagP = 0x04;
+		const uint8_t kFlagCY = 0x08;
+		const uint8_t kFlagsZSP = kFlagZ | kFlagS | kFlagP;
+
+		// Z, S + P flags for a byte result - calculated rather than looked up, so that lane loops vectorize
+		inline uint8_t flagsZSP(uint8_t value) {
+			uint8_t parity = value ^ (value >> 4);
+			parity ^= parity >> 2;
+			parity ^= parity >> 1;
+
+			return uint8_t((value == 0 ? kFlagZ : 0) | ((value >> 7) << 1) | (((~parity) & 1) << 2));
+		}
+
+		// true if the condition (NZ, Z, NC, C, PO, PE, P, M) of a conditional opcode is met
+		inline bool isConditionMet(uint8_t opcode, uint8_t cc) {
+			static const uint8_t kConditionFlags[4] = { kFlagZ, kFlagCY, kFlagP, kFlagS };
+
+			const uint8_t condition = (opcode >> 3) & 0x7;
+			const bool isSet = (cc & kConditionFlags[condition >> 1]) != 0;
+
+			return (condition & 1) ? isSet : !isSet;
+		}
+
+		static_assert(avx2::kNumLanes == kNumLanes, "AVX2 lane loops assume a different group size");
+	}
+
+	/// @struct Group
+	/// @brief State of kNumLanes machines, one array element per lane
+	struct alignas(64) LockstepEngine::Group {
+		uint8_t a[kNumLanes];
+		uint8_t b[kNumLanes];
+		uint8_t c[kNumLanes];
+		uint8_t d[kNumLanes];
+		uint8_t e[kNumLanes];
+		uint8_t h[kNumLanes];
+		uint8_t l[kNumLanes];
+		uint8_t cc[kNumLanes];
+		uint8_t interruptsEnabled[kNumLanes];
+		uint16_t sp[kNumLanes];
+		uint16_t pc[kNumLanes];
+
+		uint64_t numSteps[kNumLanes];
+		uint64_t numCycles[kNumLanes];
+
+		uint16_t shiftRegister[kNumLanes];
+		uint8_t shiftRegisterResultOffset[kNumLanes];
+		uint8_t inputPorts[kNumInputPorts][kNumLanes];
+
+		uint8_t interruptNum[kNumLanes];
+		uint64_t numInterrupts[kNumLanes];
+		uint64_t nextInterruptCycle[kNumLanes];
+		uint64_t frameStartCycle[kNumLanes];
+
+		// lanes past the end of the batch (in the last group) are never run
+		uint8_t isUsed[kNumLanes];
+
+		// run the hot lane loops with the AVX2 versions in LockstepAvx2.cpp
+		bool isAvx2;
+
+		// totals for this group, written only by the thread running it
+		uint64_t numLaneSteps;
+		uint64_t numDispatches;
+
+		// RAM is interleaved by lane, so that lanes reading the same address read contiguous bytes
+		uint8_t ram[machine::Snapshot::kSizeRam][kNumLanes];
+
+		// ROM shared by every group
+		const uint8_t* rom;
+
+		uint8_t read(uint16_t address, size_t lane) const {
+			return (address < kSizeRom) ? rom[address] : ram[address & kRamMask][lane];
+		}
+
+		void write(uint16_t address, uint8_t value, size_t lane) {
+			// writes to ROM are ignored, as memory::Memory does in release builds
+			if (address >= kSizeRom) {
+				ram[address & kRamMask][lane] = value;
+			}
+		}
+
+		uint16_t getHL(size_t lane) const {
+			return util::makeWord(h[lane], l[lane]);
+		}
+
+		// register for 3 bit index used by opcodes - B, C, D, E, H, L, (M), A
+		uint8_t* getRegister(int index) {
+			uint8_t* registers[8] = { b, c, d, e, h, l, nullptr, a };
+			return registers[index];
+		}
+
+		// high + low registers of pair for 2 bit index used by opcodes - BC, DE, HL (SP handled separately)
+		void getRegisterPair(int index, uint8_t*& outHi, uint8_t*& outLo) {
+			uint8_t* his[3] = { b, d, h };
+			uint8_t* los[3] = { c, e, l };
+			outHi = his[index];
+			outLo = los[index];
+		}
+
+		bool findLeader(const uint8_t* isRunning, size_t& outLeader, uint8_t* outMask) const;
+
+		// returns a bit per lane in mask that has reached its next interrupt
+		uint32_t step(const uint8_t* mask, size_t leader);
+		void interrupt(size_t lane);
+
+		void move(const uint8_t* mask, int dst, int src);
+		void alu(const uint8_t* mask, int op, const uint8_t* values);
+		template <int kOp> void aluLanes(const uint8_t* mask, const uint8_t* values);
+		void incrementRegister(const uint8_t* mask, int index, uint8_t delta);
+		void incrementRegisterPair(const uint8_t* mask, int index, uint16_t delta);
+		void push(size_t lane, uint8_t hi, uint8_t lo);
+		uint16_t pop(size_t lane);
+	};
+
+	void LockstepEngine::Group::move(const uint8_t* mask, int dst, int src) {
+		if (src == 6) {
+			// MOV r, M
+			uint8_t* values = getRegister(dst);
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i]) {
+					values[i] = read(getHL(i), i);
+				}
+			}
+		}
+		else if (dst == 6) {
+			// MOV M, r
+			const uint8_t* values = getRegister(src);
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i]) {
+					write(getHL(i), values[i], i);
+				}
+			}
+		}
+		else if (isAvx2) {
+			avx2::move(mask, getRegister(dst), getRegister(src));
+		}
+		else {
+			uint8_t* dstValues = getRegister(dst);
+			const uint8_t* srcValues = getRegister(src);
+			for (size_t i = 0; i < kNumLanes; i++) {
+				dstValues[i] = mask[i] ? srcValues[i] : dstValues[i];
+			}
+		}
+	}
+
+	template <int kOp>
+	void LockstepEngine::Group::aluLanes(const uint8_t* mask, const uint8_t* values) {
+		// ADD, ADC, SUB, SBB, ANA, XRA, ORA, CMP - results are calculated as 16bit, carry is set if > 0xff
+		for (size_t i = 0; i < kNumLanes; i++) {
+			const uint16_t value = values[i];
+			const uint16_t carry = (cc[i] & kFlagCY) ? 1 : 0;
+			uint16_t answer = 0;
+
+			switch (kOp) {
+			case 0: answer = uint16_t(a[i] + value); break;
+			case 1: answer = uint16_t(a[i] + value + carry); break;
+			case 2: answer = uint16_t(a[i] - value); break;
+			case 3: answer = uint16_t(a[i] - value - carry); break;
+			case 4: answer = uint16_t(a[i] & value); break;
+			case 5: answer = uint16_t(a[i] ^ value); break;
+			case 6: answer = uint16_t(a[i] | value); break;
+			case 7: answer = uint16_t(a[i] - value); break;
+			}
+
+			const uint8_t flags = uint8_t((cc[i] & ~(kFlagsZSP | kFlagCY)) | flagsZSP(uint8_t(answer)) | ((answer > 0xff) ? kFlagCY : 0));
+
+			if (kOp != 7) {
+				a[i] = mask[i] ? uint8_t(answer) : a[i];
+			}
+			cc[i] = mask[i] ? flags : cc[i];
+		}
+	}
+
+	void LockstepEngine::Group::alu(const uint8_t* mask, int op, const uint8_t* values) {
+		if (isAvx2) {
+			avx2::alu(mask, op, a, cc, values);
+			return;
+		}
+
+		switch (op) {
+		case 0: aluLanes<0>(mask, values); break;
+		case 1: aluLanes<1>(mask, values); break;
+		case 2: aluLanes<2>(mask, values); break;
+		case 3: aluLanes<3>(mask, values); break;
+		case 4: aluLanes<4>(mask, values); break;
+		case 5: aluLanes<5>(mask, values); break;
+		case 6: aluLanes<6>(mask, values); break;
+		case 7: aluLanes<7>(mask, values); break;
+		}
+	}
+
+	void LockstepEngine::Group::incrementRegister(const uint8_t* mask, int index, uint8_t delta) {
+		// INR / DCR - Z, S + P only
+		if (index == 6) {
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i]) {
+					const uint16_t address = getHL(i);
+					const uint8_t value = uint8_t(read(address, i) + delta);
+					cc[i] = uint8_t((cc[i] & ~kFlagsZSP) | flagsZSP(value));
+					write(address, value, i);
+				}
+			}
+		}
+		else if (isAvx2) {
+			avx2::increment(mask, getRegister(index), cc, delta);
+		}
+		else {
+			uint8_t* values = getRegister(index);
+			for (size_t i = 0; i < kNumLanes; i++) {
+				const uint8_t value = uint8_t(values[i] + delta);
+				const uint8_t flags = uint8_t((cc[i] & ~kFlagsZSP) | flagsZSP(value));
+				values[i] = mask[i] ? value : values[i];
+				cc[i] = mask[i] ? flags : cc[i];
+			}
+		}
+	}
+
+	void LockstepEngine::Group::incrementRegisterPair(const uint8_t* mask, int index, uint16_t delta) {
+		// INX / DCX - no flags
+		if (index == 3) {
+			for (size_t i = 0; i < kNumLanes; i++) {
+				sp[i] = mask[i] ? uint16_t(sp[i] + delta) : sp[i];
+			}
+		}
+		else {
+			uint8_t* hi;
+			uint8_t* lo;
+			getRegisterPair(index, hi, lo);
+
+			for (size_t i = 0; i < kNumLanes; i++) {
+				const uint16_t value = uint16_t(util::makeWord(hi[i], lo[i]) + delta);
+				hi[i] = mask[i] ? uint8_t(value >> 8) : hi[i];
+				lo[i] = mask[i] ? uint8_t(value & 0xff) : lo[i];
+			}
+		}
+	}
+
+	void LockstepEngine::Group::push(size_t lane, uint8_t hi, uint8_t lo) {
+		write(uint16_t(sp[lane] - 1), hi, lane);
+		write(uint16_t(sp[lane] - 2), lo, lane);
+		sp[lane] -= 2;
+	}
+
+	uint16_t LockstepEngine::Group::pop(size_t lane) {
+		const uint8_t lo = read(sp[lane], lane);
+		const uint8_t hi = read(uint16_t(sp[lane] + 1), lane);
+		sp[lane] += 2;
+
+		return util::makeWord(hi, lo);
+	}
+
+	bool LockstepEngine::Group::findLeader(const uint8_t* isRunning, size_t& outLeader, uint8_t* outMask) const {
+		// the lane at the lowest PC leads - lanes that have branched ahead wait at a higher PC until
+		// the others catch up, so diverged lanes reconverge (i.e. at the end of a loop)
+		if (isAvx2) {
+			if (!avx2::findLeader(pc, isRunning, outLeader, outMask)) {
+				return false;
+			}
+		}
+		else {
+			size_t leader = kNumLanes;
+			uint32_t minPc = 0x10000;
+
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (isRunning[i] && (pc[i] < minPc)) {
+					minPc = pc[i];
+					leader = i;
+				}
+			}
+
+			if (leader == kNumLanes) {
+				return false;
+			}
+
+			for (size_t i = 0; i < kNumLanes; i++) {
+				outMask[i] = (isRunning[i] && (pc[i] == minPc)) ? 0xff : 0x00;
+			}
+
+			outLeader = leader;
+		}
+
+		if (pc[outLeader] >= kSizeRom) {
+			// code in RAM may differ between lanes, so run the leader on its own
+			memset(outMask, 0, kNumLanes);
+			outMask[outLeader] = 0xff;
+		}
+
+		return true;
+	}
+
+	uint32_t LockstepEngine::Group::step(const uint8_t* mask, size_t leader) {
+		// every lane in mask is at the same PC - opcode + data are read once, from the leader
+		const uint16_t pcLeader = pc[leader];
+		const uint8_t opcode = read(pcLeader, leader);
+		const uint8_t data8 = read(uint16_t(pcLeader + 1), leader);
+		const uint16_t data16 = util::makeWord(read(uint16_t(pcLeader + 2), leader), data8);
+
+		// lanes where the opcode changed PC directly (see cpu::CPU::step)
+		uint8_t isTaken[kNumLanes] = {};
+		const cpu::OpcodeInfo& info = cpu::opcodes::kTable[opcode];
+
+		uint8_t values[kNumLanes];
+
+		const int dst = (opcode >> 3) & 0x7;
+		const int src = opcode & 0x7;
+		const int pairIndex = (opcode >> 4) & 0x3;
+
+		if ((opcode >= 0x40) && (opcode < 0x80)) {
+			// MOV - MOV r, r + HLT are not implemented by cpu::CPU, so run as NOP
+			if ((dst != src) && (opcode != 0x76)) {
+				move(mask, dst, src);
+			}
+		}
+		else if ((opcode >= 0x80) && (opcode < 0xc0)) {
+			// ADD, ADC, SUB, SBB, ANA, XRA, ORA, CMP
+			if (src == 6) {
+				for (size_t i = 0; i < kNumLanes; i++) {
+					values[i] = mask[i] ? read(getHL(i), i) : 0;
+				}
+			}
+			else {
+				memcpy(values, getRegister(src), kNumLanes);
+			}
+
+			alu(mask, dst, values);
+		}
+		else if ((opcode & 0xc7) == 0x04) {
+			// INR
+			incrementRegister(mask, dst, 1);
+		}
+		else if ((opcode & 0xc7) == 0x05) {
+			// DCR
+			incrementRegister(mask, dst, 0xff);
+		}
+		else if ((opcode & 0xc7) == 0x06) {
+			// MVI
+			if (dst == 6) {
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						write(getHL(i), data8, i);
+					}
+				}
+			}
+			else {
+				uint8_t* registerValues = getRegister(dst);
+				for (size_t i = 0; i < kNumLanes; i++) {
+					registerValues[i] = mask[i] ? data8 : registerValues[i];
+				}
+			}
+		}
+		else if ((opcode & 0xcf) == 0x01) {
+			// LXI
+			if (pairIndex == 3) {
+				for (size_t i = 0; i < kNumLanes; i++) {
+					sp[i] = mask[i] ? data16 : sp[i];
+				}
+			}
+			else {
+				uint8_t* hi;
+				uint8_t* lo;
+				getRegisterPair(pairIndex, hi, lo);
+
+				for (size_t i = 0; i < kNumLanes; i++) {
+					hi[i] = mask[i] ? uint8_t(data16 >> 8) : hi[i];
+					lo[i] = mask[i] ? data8 : lo[i];
+				}
+			}
+		}
+		else if ((opcode & 0xcf) == 0x03) {
+			// INX
+			incrementRegisterPair(mask, pairIndex, 1);
+		}
+		else if ((opcode & 0xcf) == 0x0b) {
+			// DCX
+			incrementRegisterPair(mask, pairIndex, 0xffff);
+		}
+		else if ((opcode & 0xcf) == 0x09) {
+			// DAD
+			for (size_t i = 0; i < kNumLanes; i++) {
+				uint32_t value = 0;
+				switch (pairIndex) {
+				case 0: value = util::makeWord(b[i], c[i]); break;
+				case 1: value = util::makeWord(d[i], e[i]); break;
+				case 2: value = util::makeWord(h[i], l[i]); break;
+				case 3: value = sp[i]; break;
+				}
+
+				const uint32_t answer = uint32_t(util::makeWord(h[i], l[i])) + value;
+				const uint8_t flags = uint8_t((cc[i] & ~kFlagCY) | ((answer > 0xffff) ? kFlagCY : 0));
+
+				h[i] = mask[i] ? uint8_t((answer >> 8) & 0xff) : h[i];
+				l[i] = mask[i] ? uint8_t(answer & 0xff) : l[i];
+				cc[i] = mask[i] ? flags : cc[i];
+			}
+		}
+		else if ((opcode & 0xc7) == 0xc0) {
+			// Rcc
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i] && isConditionMet(opcode, cc[i])) {
+					pc[i] = pop(i);
+					isTaken[i] = 1;
+				}
+			}
+		}
+		else if ((opcode & 0xc7) == 0xc2) {
+			// Jcc
+			for (size_t i = 0; i < kNumLanes; i++) {
+				const uint8_t isJump = (mask[i] && isConditionMet(opcode, cc[i])) ? 1 : 0;
+				pc[i] = isJump ? data16 : pc[i];
+				isTaken[i] = isJump;
+			}
+		}
+		else if ((opcode & 0xc7) == 0xc4) {
+			// Ccc
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i] && isConditionMet(opcode, cc[i])) {
+					const uint16_t returnAddress = uint16_t(pc[i] + 3);
+					push(i, uint8_t(returnAddress >> 8), uint8_t(returnAddress & 0xff));
+					pc[i] = data16;
+					isTaken[i] = 1;
+				}
+			}
+		}
+		else if ((opcode & 0xc7) == 0xc6) {
+			// ADI, ACI, SUI, SBI, ANI, XRI, ORI, CPI
+			memset(values, data8, kNumLanes);
+			alu(mask, dst, values);
+		}
+		else if ((opcode & 0xcf) == 0xc1) {
+			// POP
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i]) {
+					const uint16_t value = pop(i);
+					switch (pairIndex) {
+					case 0: b[i] = uint8_t(value >> 8); c[i] = uint8_t(value & 0xff); break;
+					case 1: d[i] = uint8_t(value >> 8); e[i] = uint8_t(value & 0xff); break;
+					case 2: h[i] = uint8_t(value >> 8); l[i] = uint8_t(value & 0xff); break;
+					case 3: a[i] = uint8_t(value >> 8); cc[i] = uint8_t(value & 0xff); break;
+					}
+				}
+			}
+		}
+		else if ((opcode & 0xcf) == 0xc5) {
+			// PUSH
+			for (size_t i = 0; i < kNumLanes; i++) {
+				if (mask[i]) {
+					switch (pairIndex) {
+					case 0: push(i, b[i], c[i]); break;
+					case 1: push(i, d[i], e[i]); break;
+					case 2: push(i, h[i], l[i]); break;
+					case 3: push(i, a[i], cc[i]); break;
+					}
+				}
+			}
+		}
+		else {
+			switch (opcode) {
+			case 0x02:						// STAX B
+			case 0x12:						// STAX D
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						const uint16_t address = (opcode == 0x02) ? util::makeWord(b[i], c[i]) : util::makeWord(d[i], e[i]);
+						write(address, a[i], i);
+					}
+				}
+				break;
+			case 0x0a:						// LDAX B
+			case 0x1a:						// LDAX D
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						const uint16_t address = (opcode == 0x0a) ? util::makeWord(b[i], c[i]) : util::makeWord(d[i], e[i]);
+						a[i] = read(address, i);
+					}
+				}
+				break;
+			case 0x07:						// RLC
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t bit7 = a[i] >> 7;
+					const uint8_t flags = uint8_t((cc[i] & ~kFlagCY) | (bit7 ? kFlagCY : 0));
+					a[i] = mask[i] ? uint8_t((a[i] << 1) | bit7) : a[i];
+					cc[i] = mask[i] ? flags : cc[i];
+				}
+				break;
+			case 0x0f:						// RRC
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t bit0 = a[i] & 0x01;
+					const uint8_t flags = uint8_t((cc[i] & ~kFlagCY) | (bit0 ? kFlagCY : 0));
+					a[i] = mask[i] ? uint8_t((a[i] >> 1) | (bit0 << 7)) : a[i];
+					cc[i] = mask[i] ? flags : cc[i];
+				}
+				break;
+			case 0x17:						// RAL
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t bit7 = a[i] >> 7;
+					const uint8_t bit0 = (cc[i] & kFlagCY) ? 1 : 0;
+					const uint8_t flags = uint8_t((cc[i] & ~kFlagCY) | (bit7 ? kFlagCY : 0));
+					a[i] = mask[i] ? uint8_t((a[i] << 1) | bit0) : a[i];
+					cc[i] = mask[i] ? flags : cc[i];
+				}
+				break;
+			case 0x1f:						// RAR
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t bit0 = a[i] & 0x01;
+					const uint8_t bit7 = (cc[i] & kFlagCY) ? 1 : 0;
+					const uint8_t flags = uint8_t((cc[i] & ~kFlagCY) | (bit0 ? kFlagCY : 0));
+					a[i] = mask[i] ? uint8_t((a[i] >> 1) | (bit7 << 7)) : a[i];
+					cc[i] = mask[i] ? flags : cc[i];
+				}
+				break;
+			case 0x22:						// SHLD
+				if (data16 >= kSizeRom) {
+					uint8_t* row0 = ram[data16 & kRamMask];
+					for (size_t i = 0; i < kNumLanes; i++) {
+						row0[i] = mask[i] ? l[i] : row0[i];
+					}
+				}
+				if (uint16_t(data16 + 1) >= kSizeRom) {
+					uint8_t* row1 = ram[uint16_t(data16 + 1) & kRamMask];
+					for (size_t i = 0; i < kNumLanes; i++) {
+						row1[i] = mask[i] ? h[i] : row1[i];
+					}
+				}
+				break;
+			case 0x2a:						// LHLD
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						l[i] = read(data16, i);
+						h[i] = read(uint16_t(data16 + 1), i);
+					}
+				}
+				break;
+			case 0x27:						// DAA - matches cpu::CPU, which ignores the auxiliary carry flag
+				for (size_t i = 0; i < kNumLanes; i++) {
+					uint8_t value = a[i];
+					uint8_t flags = cc[i];
+
+					if ((value & 0x0f) > 9) {
+						value += 6;
+					}
+
+					if ((flags & kFlagCY) || ((value & 0xf0) > 0x90)) {
+						value += 0x60;
+						flags = uint8_t((flags & ~kFlagsZSP) | kFlagCY | flagsZSP(value));
+					}
+
+					a[i] = mask[i] ? value : a[i];
+					cc[i] = mask[i] ? flags : cc[i];
+				}
+				break;
+			case 0x2f:						// CMA
+				for (size_t i = 0; i < kNumLanes; i++) {
+					a[i] = mask[i] ? uint8_t(~a[i]) : a[i];
+				}
+				break;
+			case 0x32:						// STA
+				if (data16 >= kSizeRom) {
+					uint8_t* row = ram[data16 & kRamMask];
+					for (size_t i = 0; i < kNumLanes; i++) {
+						row[i] = mask[i] ? a[i] : row[i];
+					}
+				}
+				break;
+			case 0x3a:						// LDA
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t value = (data16 >= kSizeRom) ? ram[data16 & kRamMask][i] : rom[data16];
+					a[i] = mask[i] ? value : a[i];
+				}
+				break;
+			case 0x37:						// STC
+				for (size_t i = 0; i < kNumLanes; i++) {
+					cc[i] = mask[i] ? uint8_t(cc[i] | kFlagCY) : cc[i];
+				}
+				break;
+			case 0x3f:						// CMC
+				for (size_t i = 0; i < kNumLanes; i++) {
+					cc[i] = mask[i] ? uint8_t(cc[i] ^ kFlagCY) : cc[i];
+				}
+				break;
+			case 0xc3:						// JMP
+				for (size_t i = 0; i < kNumLanes; i++) {
+					pc[i] = mask[i] ? data16 : pc[i];
+					isTaken[i] = mask[i] ? 1 : 0;
+				}
+				break;
+			case 0xc9:						// RET
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						pc[i] = pop(i);
+						isTaken[i] = 1;
+					}
+				}
+				break;
+			case 0xcd:						// CALL
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						const uint16_t returnAddress = uint16_t(pc[i] + 3);
+						push(i, uint8_t(returnAddress >> 8), uint8_t(returnAddress & 0xff));
+						pc[i] = data16;
+						isTaken[i] = 1;
+					}
+				}
+				break;
+			case 0xd3:						// OUT
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						if (data8 == 2) {
+							shiftRegisterResultOffset[i] = a[i] & 0x7;
+						}
+						else if (data8 == 4) {
+							shiftRegister[i] = uint16_t((shiftRegister[i] >> 8) | (uint16_t(a[i]) << 8));
+						}
+					}
+				}
+				break;
+			case 0xdb:						// IN
+				for (size_t i = 0; i < kNumLanes; i++) {
+					uint8_t value = 0;
+					if (data8 < kNumInputPorts) {
+						value = inputPorts[data8][i];
+					}
+					else if (data8 == 3) {
+						value = uint8_t((shiftRegister[i] >> (8 - shiftRegisterResultOffset[i])) & 0xff);
+					}
+					a[i] = mask[i] ? value : a[i];
+				}
+				break;
+			case 0xe3:						// XTHL
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (mask[i]) {
+						const uint8_t valueL = l[i];
+						const uint8_t valueH = h[i];
+						l[i] = read(sp[i], i);
+						h[i] = read(uint16_t(sp[i] + 1), i);
+						write(sp[i], valueL, i);
+						write(uint16_t(sp[i] + 1), valueH, i);
+					}
+				}
+				break;
+			case 0xe9:						// PCHL
+				for (size_t i = 0; i < kNumLanes; i++) {
+					pc[i] = mask[i] ? util::makeWord(h[i], l[i]) : pc[i];
+					isTaken[i] = mask[i] ? 1 : 0;
+				}
+				break;
+			case 0xeb:						// XCHG
+				for (size_t i = 0; i < kNumLanes; i++) {
+					const uint8_t valueH = h[i];
+					const uint8_t valueL = l[i];
+					h[i] = mask[i] ? d[i] : h[i];
+					l[i] = mask[i] ? e[i] : l[i];
+					d[i] = mask[i] ? valueH : d[i];
+					e[i] = mask[i] ? valueL : e[i];
+				}
+				break;
+			case 0xf9:						// SPHL
+				for (size_t i = 0; i < kNumLanes; i++) {
+					sp[i] = mask[i] ? util::makeWord(h[i], l[i]) : sp[i];
+				}
+				break;
+			case 0xfb:						// EI
+				for (size_t i = 0; i < kNumLanes; i++) {
+					interruptsEnabled[i] = mask[i] ? 1 : interruptsEnabled[i];
+				}
+				break;
+			default:
+				// NOP, plus the opcodes that cpu::CPU does not implement (i.e. RST, DI) - all are skipped, as cpu::CPU skips them
+				break;
+			}
+		}
+
+		const uint64_t cycles = info.cycles;
+		const uint64_t cyclesTaken = info.cyclesTaken;
+		const uint16_t opcodeSize = info.size;
+
+		if (isAvx2) {
+			return avx2::retire(mask, isTaken, opcodeSize, cycles, cyclesTaken, numSteps, numCycles, pc, nextInterruptCycle);
+		}
+
+		// bit per lane that has reached its next interrupt
+		uint32_t isInterruptDue = 0;
+
+		for (size_t i = 0; i < kNumLanes; i++) {
+			numSteps[i] += mask[i] ? 1 : 0;
+			numCycles[i] += mask[i] ? (isTaken[i] ? cyclesTaken : cycles) : 0;
+			pc[i] += (mask[i] && !isTaken[i]) ? opcodeSize : 0;
+			isInterruptDue |= (mask[i] && (numCycles[i] >= nextInterruptCycle[i])) ? (1u << i) : 0;
+		}
+
+		return isInterruptDue;
+	}
+
+	void LockstepEngine::Group::interrupt(size_t lane) {
+		// see machine::Machine::interrupt + cpu::CPU::interrupt
+		const bool isFrameComplete = (interruptNum[lane] == 2);
+
+		if (interruptsEnabled[lane]) {
+			interruptsEnabled[lane] = 0;
+
+			push(lane, uint8_t(pc[lane] >> 8), uint8_t(pc[lane] & 0xff));
+			pc[lane] = uint16_t(8 * interruptNum[lane]);
+
+			numCycles[lane] += cpu::CPU::getInterruptCycles();
+		}
+
+		interruptNum[lane] = (interruptNum[lane] == 1) ? 2 : 1;
+		numInterrupts[lane] += 1;
+		nextInterruptCycle[lane] += machine::Machine::kCyclesPerHalfFrame;
+
+		if (isFrameComplete) {
+			frameStartCycle[lane] = numCycles[lane];
+		}
+	}
+
+	bool LockstepEngine::isAvx2Supported() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+
+		// AVX + OSXSAVE, and the OS saves the upper halves of the ymm registers
+		__cpuid(info, 1);
+		const int kAvxOsxsave = (1 << 27) | (1 << 28);
+		if (((info[2] & kAvxOsxsave) != kAvxOsxsave) || ((_xgetbv(0) & 0x6) != 0x6)) {
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	LockstepEngine::LockstepEngine() :
+		numMachines(0),
+		numGroups(0)
+	{
+
+	}
+
+	LockstepEngine::~LockstepEngine() {
+
+	}
+
+	bool LockstepEngine::init(const uint8_t* inRom, uint16_t sizeRom, size_t inNumMachines) {
+		if (sizeRom != kSizeRom) {
+			printf("LockstepEngine - ROM must be %u bytes (not %u)\n", kSizeRom, sizeRom);
+			return false;
+		}
+
+		rom.assign(inRom, inRom + sizeRom);
+
+		numMachines = inNumMachines;
+		numGroups = (numMachines + kNumLanes - 1) / kNumLanes;
+
+		groups.reset(new Group[numGroups]);
+
+		const bool isAvx2 = isAvx2Supported();
+
+		for (size_t i = 0; i < numGroups; i++) {
+			memset(&groups[i], 0, sizeof(Group));
+			groups[i].rom = rom.data();
+			groups[i].isAvx2 = isAvx2;
+		}
+
+		// every machine starts from the same power-on state as machine::Machine
+		machine::Machine powerOn;
+		if (!powerOn.init(rom.data(), sizeRom)) {
+			return false;
+		}
+
+		machine::Snapshot snapshot;
+		powerOn.snapshot(snapshot);
+
+		for (size_t i = 0; i < numMachines; i++) {
+			groups[i / kNumLanes].isUsed[i % kNumLanes] = 1;
+			restore(i, snapshot);
+		}
+
+		return true;
+	}
+
+	size_t LockstepEngine::size() const {
+		return numMachines;
+	}
+
+	size_t LockstepEngine::getNumBlocks() const {
+		return numGroups;
+	}
+
+	size_t LockstepEngine::getBlockSize() const {
+		return kNumLanes;
+	}
+
+	void LockstepEngine::runFrame(size_t blockBegin, size_t blockEnd) {
+		for (size_t i = blockBegin; i < blockEnd; i++) {
+			runGroupFrame(groups[i]);
+		}
+	}
+
+	void LockstepEngine::runGroupFrame(Group& group) const {
+		uint8_t isRunning[kNumLanes];
+		uint64_t startFrame[kNumLanes];
+
+		for (size_t i = 0; i < kNumLanes; i++) {
+			isRunning[i] = group.isUsed[i];
+			startFrame[i] = group.numInterrupts[i] / 2;
+		}
+
+		for (;;) {
+			size_t leader = kNumLanes;
+			uint8_t mask[kNumLanes];
+
+			if (!group.findLeader(isRunning, leader, mask)) {
+				// every lane has completed its frame
+				break;
+			}
+
+			const uint32_t isInterruptDue = group.step(mask, leader);
+			group.numDispatches += 1;
+
+			uint32_t numSteps = 0;
+			for (size_t i = 0; i < kNumLanes; i++) {
+				numSteps += mask[i] & 1;
+			}
+
+			group.numLaneSteps += numSteps;
+
+			// interrupts are rare, so every lane is tested at once before handling them one lane at a time
+			if (isInterruptDue != 0) {
+				for (size_t i = 0; i < kNumLanes; i++) {
+					if (isInterruptDue & (1u << i)) {
+						group.interrupt(i);
+
+						if ((group.numInterrupts[i] / 2) != startFrame[i]) {
+							isRunning[i] = 0;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void LockstepEngine::setInputPort(size_t index, uint8_t port, uint8_t value) {
+		assert(index < numMachines);
+		assert(port < kNumInputPorts);
+
+		groups[index / kNumLanes].inputPorts[port][index % kNumLanes] = value;
+	}
+
+	void LockstepEngine::snapshot(size_t index, machine::Snapshot& outSnapshot) const {
+		assert(index < numMachines);
+
+		const Group& group = groups[index / kNumLanes];
+		const size_t lane = index % kNumLanes;
+
+		outSnapshot.state.reset();
+		outSnapshot.state.a = group.a[lane];
+		outSnapshot.state.b = group.b[lane];
+		outSnapshot.state.c = group.c[lane];
+		outSnapshot.state.d = group.d[lane];
+		outSnapshot.state.e = group.e[lane];
+		outSnapshot.state.h = group.h[lane];
+		outSnapshot.state.l = group.l[lane];
+		outSnapshot.state.sp = group.sp[lane];
+		outSnapshot.state.pc = group.pc[lane];
+		outSnapshot.state.cc.all = group.cc[lane];
+		outSnapshot.state.interruptsEnabled = (group.interruptsEnabled[lane] != 0);
+
+		outSnapshot.numSteps = group.numSteps[lane];
+		outSnapshot.numCycles = group.numCycles[lane];
+
+		for (size_t address = 0; address < machine::Snapshot::kSizeRam; address++) {
+			outSnapshot.ram[address] = group.ram[address][lane];
+		}
+
+		outSnapshot.shiftRegister = group.shiftRegister[lane];
+		outSnapshot.shiftRegisterResultOffset = group.shiftRegisterResultOffset[lane];
+
+		for (int port = 0; port < kNumInputPorts; port++) {
+			outSnapshot.inputPorts[port] = group.inputPorts[port][lane];
+		}
+
+		outSnapshot.interruptNum = group.interruptNum[lane];
+		outSnapshot.numInterrupts = group.numInterrupts[lane];
+		outSnapshot.nextInterruptCycle = group.nextInterruptCycle[lane];
+		outSnapshot.frameStartCycle = group.frameStartCycle[lane];
+	}
+
+	void LockstepEngine::restore(size_t index, const machine::Snapshot& snapshot) {
+		assert(index < numMachines);
+
+		Group& group = groups[index / kNumLanes];
+		const size_t lane = index % kNumLanes;
+
+		group.a[lane] = snapshot.state.a;
+		group.b[lane] = snapshot.state.b;
+		group.c[lane] = snapshot.state.c;
+		group.d[lane] = snapshot.state.d;
+		group.e[lane] = snapshot.state.e;
+		group.h[lane] = snapshot.state.h;
+		group.l[lane] = snapshot.state.l;
+		group.sp[lane] = snapshot.state.sp;
+		group.pc[lane] = snapshot.state.pc;
+		group.cc[lane] = snapshot.state.cc.all;
+		group.interruptsEnabled[lane] = snapshot.state.interruptsEnabled ? 1 : 0;
+
+		group.numSteps[lane] = snapshot.numSteps;
+		group.numCycles[lane] = snapshot.numCycles;
+
+		for (size_t address = 0; address < machine::Snapshot::kSizeRam; address++) {
+			group.ram[address][lane] = snapshot.ram[address];
+		}
+
+		group.shiftRegister[lane] = snapshot.shiftRegister;
+		group.shiftRegisterResultOffset[lane] = snapshot.shiftRegisterResultOffset;
+
+		for (int port = 0; port < kNumInputPorts; port++) {
+			group.inputPorts[port][lane] = snapshot.inputPorts[port];
+		}
+
+		group.interruptNum[lane] = snapshot.interruptNum;
+		group.numInterrupts[lane] = snapshot.numInterrupts;
+		group.nextInterruptCycle[lane] = snapshot.nextInterruptCycle;
+		group.frameStartCycle[lane] = snapshot.frameStartCycle;
+	}
+
+	uint64_t LockstepEngine::hashRam(size_t index) const {
+		assert(index < numMachines);
+
+		const Group& group = groups[index / kNumLanes];
+		const size_t lane = index % kNumLanes;
+
+		uint8_t ram[machine::Snapshot::kSizeRam];
+		for (size_t address = 0; address < machine::Snapshot::kSizeRam; address++) {
+			ram[address] = group.ram[address][lane];
+		}
+
+		return util::hash(ram, sizeof(ram));
+	}
+
+	void LockstepEngine::readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const {
+		assert(index < numMachines);
+
+		const Group& group = groups[index / kNumLanes];
+		const size_t lane = index % kNumLanes;
+
+		for (uint16_t i = 0; i < size; i++) {
+			outData[i] = group.read(uint16_t(address + i), lane);
+		}
+	}
+
+	uint64_t LockstepEngine::getNumSteps() const {
+		uint64_t total = 0;
+		for (size_t i = 0; i < numGroups; i++) {
+			total += groups[i].numLaneSteps;
+		}
+
+		return total;
+	}
+
+	uint64_t LockstepEngine::getNumDispatches() const {
+		uint64_t total = 0;
+		for (size_t i = 0; i < numGroups; i++) {
+			total += groups[i].numDispatches;
+		}
+
+		return total;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "batch/IEngine.h"
+
+namespace batch {
+
+	/// @class LockstepEngine
+	/// @brief Batch engine that runs groups of kNumLanes machines in lockstep, with structure-of-arrays state
+	/// @note every machine runs the same ROM, so machines in a group are often at the same PC. Each
+	///       dispatch decodes the opcode once, and executes it for every lane at that PC. Finding the lanes to
+	///       run, counting cycles + interrupts, and the register MOV / ALU / INR / DCR lanes have AVX2 versions
+	///       (LockstepAvx2.cpp), used when the CPU supports them - the other lane loops are left to the compiler.
+	///       Lanes at other PCs are masked out and run in a later dispatch - the lowest PC runs first, so
+	///       that lanes that branched ahead wait for the others to catch up. Each lane still triggers its own
+	///       interrupts from its own cycle count, so the results do not depend on the order lanes are run.
+	///
+	///       Produces exactly the same results as machine::Machine, except that the engine only supports
+	///       the Space Invaders memory map (8KB ROM + 8KB mirrored RAM) and has no breakpoints.
+	class LockstepEngine : public IEngine {
+	public:
+		// number of machines in each group
+		static const size_t kNumLanes = 16;
+
+		LockstepEngine();
+		~LockstepEngine();
+
+		// true if the CPU + OS support AVX2, so groups run the lane loops in LockstepAvx2.cpp
+		static bool isAvx2Supported();
+
+	public: // IEngine
+		bool init(const uint8_t* rom, uint16_t sizeRom, size_t numMachines) override;
+		size_t size() const override;
+		size_t getNumBlocks() const override;
+		size_t getBlockSize() const override;
+		void runFrame(size_t blockBegin, size_t blockEnd) override;
+		void setInputPort(size_t index, uint8_t port, uint8_t value) override;
+		void snapshot(size_t index, machine::Snapshot& outSnapshot) const override;
+		void restore(size_t index, const machine::Snapshot& snapshot) override;
+		uint64_t hashRam(size_t index) const override;
+		void readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const override;
+		uint64_t getNumSteps() const override;
+		uint64_t getNumDispatches() const override;
+
+	private:
+		struct Group;
+
+		void runGroupFrame(Group& group) const;
+
+		size_t numMachines;
+		size_t numGroups;
+
+		std::vector<uint8_t> rom;
+		std::unique_ptr<Group[]> groups;
+	};
+}
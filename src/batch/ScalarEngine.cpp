@@ -0,0 +1,90 @@
+#include "batch/ScalarEngine.h"
+
+#include <cassert>
+
+namespace batch {
+	ScalarEngine::ScalarEngine() :
+		numMachines(0)
+	{
+
+	}
+
+	bool ScalarEngine::init(const uint8_t* rom, uint16_t sizeRom, size_t inNumMachines) {
+		numMachines = inNumMachines;
+
+		machines.reset(new machine::Machine[numMachines]);
+		numSteps.assign(numMachines, 0);
+
+		for (size_t i = 0; i < numMachines; i++) {
+			if (!machines[i].init(rom, sizeRom)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	size_t ScalarEngine::size() const {
+		return numMachines;
+	}
+
+	size_t ScalarEngine::getNumBlocks() const {
+		return numMachines;
+	}
+
+	size_t ScalarEngine::getBlockSize() const {
+		return 1;
+	}
+
+	void ScalarEngine::runFrame(size_t blockBegin, size_t blockEnd) {
+		for (size_t i = blockBegin; i < blockEnd; i++) {
+			machine::Machine& machine = machines[i];
+
+			const uint64_t numStepsBefore = machine.getCPU().getNumSteps();
+			machine.runFrame();
+			numSteps[i] += machine.getCPU().getNumSteps() - numStepsBefore;
+		}
+	}
+
+	void ScalarEngine::setInputPort(size_t index, uint8_t port, uint8_t value) {
+		assert(index < numMachines);
+		machines[index].setInputPort(port, value);
+	}
+
+	void ScalarEngine::snapshot(size_t index, machine::Snapshot& outSnapshot) const {
+		assert(index < numMachines);
+		machines[index].snapshot(outSnapshot);
+	}
+
+	void ScalarEngine::restore(size_t index, const machine::Snapshot& snapshot) {
+		assert(index < numMachines);
+		machines[index].restore(snapshot);
+	}
+
+	uint64_t ScalarEngine::hashRam(size_t index) const {
+		assert(index < numMachines);
+		return machines[index].hashRam();
+	}
+
+	void ScalarEngine::readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const {
+		assert(index < numMachines);
+
+		const memory::Memory& memory = machines[index].getMemory();
+		for (uint16_t i = 0; i < size; i++) {
+			outData[i] = memory.read(memory.translate(uint16_t(address + i)));
+		}
+	}
+
+	uint64_t ScalarEngine::getNumSteps() const {
+		uint64_t total = 0;
+		for (uint64_t value : numSteps) {
+			total += value;
+		}
+
+		return total;
+	}
+
+	uint64_t ScalarEngine::getNumDispatches() const {
+		return getNumSteps();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "batch/IEngine.h"
+#include "machine/Machine.h"
+
+namespace batch {
+
+	/// @class ScalarEngine
+	/// @brief Batch engine that runs each machine with its own machine::Machine (cpu::CPU + memory::Memory)
+	class ScalarEngine : public IEngine {
+	public:
+		ScalarEngine();
+
+	public: // IEngine
+		bool init(const uint8_t* rom, uint16_t sizeRom, size_t numMachines) override;
+		size_t size() const override;
+		size_t getNumBlocks() const override;
+		size_t getBlockSize() const override;
+		void runFrame(size_t blockBegin, size_t blockEnd) override;
+		void setInputPort(size_t index, uint8_t port, uint8_t value) override;
+		void snapshot(size_t index, machine::Snapshot& outSnapshot) const override;
+		void restore(size_t index, const machine::Snapshot& snapshot) override;
+		uint64_t hashRam(size_t index) const override;
+		void readRam(size_t index, uint16_t address, uint16_t size, uint8_t* outData) const override;
+		uint64_t getNumSteps() const override;
+		uint64_t getNumDispatches() const override;
+
+	private:
+		size_t numMachines;
+
+		std::unique_ptr<machine::Machine[]> machines;
+
+		// instructions stepped by each machine, written only by the thread running that machine
+		std::vector<uint64_t> numSteps;
+	};
+}
@@ -1,7 +1,11 @@
 #include "cpu/Breakpoint.h"
 
 namespace cpu {
-	Breakpoint::Breakpoint(Type inType, uint16_t inAddress) : type(inType), address(inAddress) {
+	Breakpoint::Breakpoint(Type inType, uint16_t inAddress) : type(inType), address(inAddress), endAddress(inAddress), hitCount(0), numHits(0) {
+
+	}
+
+	Breakpoint::Breakpoint(Type inType, uint16_t inAddress, uint16_t inEndAddress) : type(inType), address(inAddress), endAddress(inEndAddress), hitCount(0), numHits(0) {
 
 	}
 }
@@ -2,20 +2,35 @@
 
 #include <cstdint>
 
+#include "cpu/Condition.h"
+
 namespace cpu {
 
     struct Breakpoint {
         enum class Type {
             MemoryWrite,
-            Opcode
+            Opcode,
+            MemoryRead,
+            PortIn,
+            PortOut
         };
 
         Breakpoint(Type type, uint16_t address);
 
+        // watch every address (or port) from address to endAddress, inclusive
+        Breakpoint(Type type, uint16_t address, uint16_t endAddress);
+
         Type type;
 
         uint16_t address;
+        uint16_t endAddress;
+
+        // only fire when condition holds, from the hitCount'th time it does (0 + 1 fire every time)
+        Condition condition;
+        uint32_t hitCount;
+
+        // times the address was hit while condition held, counted by the CPU the breakpoint was added to
+        uint32_t numHits;
     };
 
 }
-
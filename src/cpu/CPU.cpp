@@ -1,22 +1,38 @@
 #include "cpu/CPU.h"
+#include "cpu/Opcodes.h"
 #include "util/Utils.h"
 
 #include "Disassemble.h"
 #include "BuildOptions.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 
 namespace cpu {
+	namespace {
+		// number of clock cycles to respond to an interrupt (RST)
+		const uint8_t kInterruptCycles = 11;
+
+		// watchpoint flags, per memory page + address, and per port
+		const uint8_t kWatchRead = (1 << 0);
+		const uint8_t kWatchWrite = (1 << 1);
+		const uint8_t kWatchIn = (1 << 0);
+		const uint8_t kWatchOut = (1 << 1);
+	}
 
-	CPU::CPU() : memory(nullptr), numSteps(0) {	
+	CPU::CPU() : memory(nullptr), numSteps(0), numCycles(0), profiler(nullptr), tracer(nullptr) {	
 		state.reset();
+
+		breakpoints.generation = 0;
+		updateBreakpoints();
 	}
 
 	void CPU::init(memory::IMemory* inMemory, uint16_t pcStart) {		
 		memory = inMemory;
 		state.pc = pcStart;		
 		numSteps = 0;
+		numCycles = 0;
 	}
 
 	void CPU::setCallbackIn(CallbackIn callback) {
@@ -31,6 +47,10 @@ namespace cpu {
 		callbacks.breakpoint = callback;
 	}
 
+	CPU::CallbackBreakpoint CPU::getCallbackBreakpoint() const {
+		return callbacks.breakpoint;
+	}
+
 	uint64_t CPU::getNumSteps() const {
 		return numSteps;
 	}
@@ -39,10 +59,27 @@ namespace cpu {
 		return state;
 	}
 
+	void CPU::setState(const State& inState) {
+		state = inState;
+	}
+
+	void CPU::setNumSteps(uint64_t inNumSteps) {
+		numSteps = inNumSteps;
+	}
+
+	uint64_t CPU::getNumCycles() const {
+		return numCycles;
+	}
+
+	void CPU::setNumCycles(uint64_t inNumCycles) {
+		numCycles = inNumCycles;
+	}
+
 	void CPU::step() {
 		numSteps += 1;
 
-		uint8_t opcode = readMemory(state.pc);
+		const uint16_t pc = state.pc;
+		uint8_t opcode = fetchMemory(pc);
 	
 		uint16_t opcodeSize = 1;
 
@@ -51,8 +88,8 @@ namespace cpu {
 				break;
 			case 0x01:						// LXI B, D16
 			{
-				state.c = readMemory(state.pc + 1);
-				state.b = readMemory(state.pc + 2);
+				state.c = fetchMemory(state.pc + 1);
+				state.b = fetchMemory(state.pc + 2);
 				opcodeSize = 3;
 				break;
 			}
@@ -84,7 +121,7 @@ namespace cpu {
 			}
 			case 0x06:						// MVI B, D8
 			{
-				state.b = readMemory(state.pc + 1);
+				state.b = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -132,7 +169,7 @@ namespace cpu {
 			}
 			case 0x0E:						// MVI C, D8
 			{
-				state.c = readMemory(state.pc + 1);
+				state.c = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -147,8 +184,8 @@ namespace cpu {
 
 			case 0x11:						// LXI D, D16
 			{
-				state.d = readMemory(state.pc + 2);
-				state.e = readMemory(state.pc + 1);			
+				state.d = fetchMemory(state.pc + 2);
+				state.e = fetchMemory(state.pc + 1);			
 				opcodeSize = 3;
 				break;
 			}
@@ -179,7 +216,7 @@ namespace cpu {
 			}
 			case 0x16:						// MVI D, D8
 			{
-				state.d = readMemory(state.pc + 1);
+				state.d = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -229,7 +266,7 @@ namespace cpu {
 			}
 			case 0x1E:						// MVI E, D8
 			{
-				state.e = readMemory(state.pc + 1);
+				state.e = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -244,8 +281,8 @@ namespace cpu {
 
 			case 0x21:						// LXI H, D16
 			{
-				state.h = readMemory(state.pc + 2);
-				state.l = readMemory(state.pc + 1);			
+				state.h = fetchMemory(state.pc + 2);
+				state.l = fetchMemory(state.pc + 1);			
 				opcodeSize = 3;
 				break;
 			}
@@ -278,7 +315,7 @@ namespace cpu {
 			}
 			case 0x26:						// MVI H, D8
 			{
-				state.h = readMemory(state.pc + 1);
+				state.h = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -339,7 +376,7 @@ namespace cpu {
 			}
 			case 0x2E:						// MVI L, D8
 			{
-				state.l = readMemory(state.pc + 1);
+				state.l = fetchMemory(state.pc + 1);
 				opcodeSize = 2;
 				break;
 			}
@@ -387,7 +424,7 @@ namespace cpu {
 			}
 			case 0x36:						// MVI M, D8
 			{
-				uint8_t value = readMemory(state.pc + 1);
+				uint8_t value = fetchMemory(state.pc + 1);
 				uint16_t address = state.hl;
 				writeMemory(address, value);
 				opcodeSize = 2;
@@ -435,7 +472,7 @@ namespace cpu {
 
 			case 0x3e:						// MVI A, byte
 			{
-				uint8_t value = readMemory(state.pc + 1);
+				uint8_t value = fetchMemory(state.pc + 1);
 				state.a = value;
 
 				opcodeSize = 2;
@@ -1281,7 +1318,7 @@ namespace cpu {
 			}
 			case 0xC6:						// ADI byte
 			{
-				uint16_t answer = uint16_t(state.a) + uint16_t(readMemory(state.pc + 1));
+				uint16_t answer = uint16_t(state.a) + uint16_t(fetchMemory(state.pc + 1));
 				state.cc.updateByteZSP(answer);
 				state.cc.updateByteCY(answer);
 				state.a = uint8_t(answer & 0xff);
@@ -1379,7 +1416,7 @@ namespace cpu {
 			case 0xCE:						// ACI D8
 			{
 				uint16_t value = state.a;
-				value += uint16_t(readMemory(state.pc + 1));
+				value += uint16_t(fetchMemory(state.pc + 1));
 				value += uint16_t(state.cc.cy);
 				state.cc.updateByteCY(value);
 				state.cc.updateByteZSP(value);
@@ -1419,10 +1456,16 @@ namespace cpu {
 			}
 			case 0xD3:						// OUT D8 (special)
 			{
-				uint8_t port = readMemory(state.pc + 1);
+				uint8_t port = fetchMemory(state.pc + 1);
+				if (breakpoints.ports[port] & kWatchOut) {
+					onBreakpoint(Breakpoint::Type::PortOut, port, state.a);
+				}
 				if (callbacks.out) {
 					callbacks.out(port, state.a);
 				}
+				if (tracer) {
+					tracer->recordOut(port, state.a);
+				}
 				opcodeSize = 2;
 				break;
 			}
@@ -1449,7 +1492,7 @@ namespace cpu {
 			}
 			case 0xD6:						// SUI D8
 			{
-				uint8_t data = readMemory(state.pc + 1);
+				uint8_t data = fetchMemory(state.pc + 1);
 				uint16_t value = uint16_t(state.a) - uint16_t(data);
 				state.cc.updateByteCY(value);
 				state.cc.updateByteZSP(value);
@@ -1483,10 +1526,16 @@ namespace cpu {
 			}
 			case 0xDB:						// IN D8 (special)
 			{
-				uint8_t port = readMemory(state.pc + 1);
+				uint8_t port = fetchMemory(state.pc + 1);
 				if (callbacks.in) {
 					state.a = callbacks.in(port);
 				}
+				if (breakpoints.ports[port] & kWatchIn) {
+					onBreakpoint(Breakpoint::Type::PortIn, port, state.a);
+				}
+				if (tracer) {
+					tracer->recordIn(port, state.a);
+				}
 				opcodeSize = 2;
 				break;
 			}
@@ -1507,7 +1556,7 @@ namespace cpu {
 
 			case 0xDE:						// SBI D8
 			{
-				uint8_t data = readMemory(state.pc + 1);
+				uint8_t data = fetchMemory(state.pc + 1);
 				uint16_t value = uint16_t(state.a) - uint16_t(data) - uint16_t(state.cc.cy);
 				state.cc.updateByteCY(value);
 				state.cc.updateByteZSP(value);
@@ -1576,7 +1625,7 @@ namespace cpu {
 			}
 			case 0xE6:						// ANI D8
 			{
-				uint16_t value = uint16_t(state.a) & uint16_t(readMemory(state.pc + 1));
+				uint16_t value = uint16_t(state.a) & uint16_t(fetchMemory(state.pc + 1));
 				state.cc.updateByteZSP(value);
 				state.cc.updateByteCY(value);
 				state.a = uint8_t(value & 0xff);
@@ -1633,7 +1682,7 @@ namespace cpu {
 
 			case 0xEE:						// XRI
 			{
-				state.a ^= readMemory(state.pc + 1);
+				state.a ^= fetchMemory(state.pc + 1);
 				state.cc.updateByteCY(state.a);
 				state.cc.updateByteZSP(state.a);
 
@@ -1702,7 +1751,7 @@ namespace cpu {
 			}
 			case 0xF6:						// ORI D8
 			{
-				uint8_t data = readMemory(state.pc + 1);
+				uint8_t data = fetchMemory(state.pc + 1);
 				uint8_t value = state.a | data;
 				state.cc.updateByteCY(value);
 				state.cc.updateByteZSP(value);
@@ -1759,7 +1808,7 @@ namespace cpu {
 
 			case 0xFE:						// CPI D8
 			{
-				uint16_t value = uint16_t(state.a) - uint16_t(readMemory(state.pc + 1));
+				uint16_t value = uint16_t(state.a) - uint16_t(fetchMemory(state.pc + 1));
 				state.cc.updateByteZSP(value);
 				state.cc.updateByteCY(value);
 
@@ -1772,29 +1821,44 @@ namespace cpu {
 				break;
 		}
 
+		// opcodes that change PC directly report an opcodeSize of 0
+		const OpcodeInfo& info = opcodes::kTable[opcode];
+		const uint8_t cycles = (opcodeSize == 0) ? info.cyclesTaken : info.cycles;
+		numCycles += cycles;
+
+		if (profiler) {
+			profiler->record(pc, opcode, cycles);
+		}
+
 		state.pc += opcodeSize;
 
+		if (tracer) {
+			const uint8_t bytes[3] = { opcode, fetchMemory(pc + 1), fetchMemory(pc + 2) };
+			tracer->recordInstruction(pc, bytes, state);
+		}
+
 		if (!breakpoints.opcode.empty() && (breakpoints.opcode.find(state.pc) != breakpoints.opcode.end())) {
-			if (callbacks.breakpoint) {
-				Breakpoint breakpoint(Breakpoint::Type::Opcode, state.pc);
-				callbacks.breakpoint(breakpoint, 0);
-			}
+			onBreakpoint(Breakpoint::Type::Opcode, state.pc, 0);
 		}
 	}
 
 	uint16_t CPU::unimplementedOpcode(uint16_t pc) {
-		uint16_t numBytes;		
+		// opcodes::kTable must agree with the opcodes step() implements
+		const uint8_t opcode = fetchMemory(pc);
+		assert(!isOpcodeImplemented(opcode));
+
+		uint16_t numBytes;
 		std::string strOpcode = Disassemble::stringFromOpcode(memory, pc, numBytes);
 
-		printf("unimplemented Instruction: %04x 0x%02x %s\n", pc, memory->read(pc), strOpcode.c_str());
+		printf("unimplemented Instruction: %04x 0x%02x %s\n", pc, opcode, strOpcode.c_str());
 
-		return numBytes;
+		return getOpcodeSize(opcode);
 	}
 
 	uint16_t CPU::readOpcodeDataWord() const {
 		uint16_t value = util::makeWord(
-							readMemory(state.pc + 2),
-							readMemory(state.pc + 1)
+							fetchMemory(state.pc + 2),
+							fetchMemory(state.pc + 1)
 							);
 
 		return value;
@@ -1804,25 +1868,60 @@ namespace cpu {
 		uint16_t address = memory->translate(inAddress);
 		
 		/// @todo consider whether to invoke this breakpoint before OR after the write
-		if (!breakpoints.memoryWrite.empty() && (breakpoints.memoryWrite.find(address) != breakpoints.memoryWrite.end())) {
-			if (callbacks.breakpoint) {
-				Breakpoint breakpoint(Breakpoint::Type::MemoryWrite, address);
-				callbacks.breakpoint(breakpoint, value);
-			}
+		if ((breakpoints.pages[address >> 8] & kWatchWrite) && (breakpoints.addresses[address] & kWatchWrite)) {
+			onBreakpoint(Breakpoint::Type::MemoryWrite, address, value);
+		}
+
+		if (tracer) {
+			tracer->recordWrite(address, value);
 		}
 
 		memory->write(address, value);		
 	}
 
-	uint8_t CPU::readMemory(uint16_t inAddress) const {
+	uint8_t CPU::readMemory(uint16_t inAddress) {
 		uint16_t address = memory->translate(inAddress);
 
 		uint8_t value = memory->read(address);
 
+		if ((breakpoints.pages[address >> 8] & kWatchRead) && (breakpoints.addresses[address] & kWatchRead)) {
+			onBreakpoint(Breakpoint::Type::MemoryRead, address, value);
+		}
+
 		return value;
 	}
 
+	uint8_t CPU::fetchMemory(uint16_t inAddress) const {
+		return memory->read(memory->translate(inAddress));
+	}
+
+	void CPU::onBreakpoint(Breakpoint::Type type, uint16_t address, uint8_t value) {
+		// every breakpoint at the address counts its hit, even if another one has already fired
+		bool isFired = false;
+		for (Breakpoint& breakpoint : breakpoints.list) {
+			if ((breakpoint.type != type) || (address < breakpoint.address) || (address > breakpoint.endAddress)) {
+				continue;
+			}
+
+			if (!breakpoint.condition.evaluate(state, *memory, value)) {
+				continue;
+			}
+
+			breakpoint.numHits++;
+			isFired |= (breakpoint.numHits >= breakpoint.hitCount);
+		}
+
+		if (isFired && callbacks.breakpoint) {
+			Breakpoint breakpoint(type, address);
+			callbacks.breakpoint(breakpoint, value);
+		}
+	}
+
 	void CPU::call(uint16_t address, uint16_t returnAddress) {
+		if (profiler) {
+			profiler->recordCall(address, state.sp);
+		}
+
 		uint8_t rethi = uint8_t((returnAddress >> 8) & 0xff);
 		uint8_t retlo = uint8_t(returnAddress & 0xff);
 		writeMemory(state.sp - 1, rethi);
@@ -1836,12 +1935,23 @@ namespace cpu {
 		uint8_t pchi = readMemory(state.sp + 1);
 		state.pc = util::makeWord(pchi, pclo);
 		state.sp += 2;
+
+		if (profiler) {
+			profiler->recordReturn(state.sp);
+		}
 	}
 
 	void CPU::interrupt(int interruptNum) {
 		if (!state.interruptsEnabled) {
+			if (tracer) {
+				tracer->recordInterrupt(uint8_t(interruptNum), false, state);
+			}
 			return;
 		}
+
+		// interrupts are disabled until the interrupt handler re-enables them with EI
+		state.interruptsEnabled = false;
+
 		// push PC to stack
 		uint8_t pclo = uint8_t(state.pc & 0xff);
 		uint8_t pchi = uint8_t((state.pc >> 8) & 0xff);
@@ -1851,16 +1961,151 @@ namespace cpu {
 
 		// jump to interrupt vector
 		state.pc = 8 * interruptNum;
+
+		numCycles += kInterruptCycles;
+
+		if (profiler) {
+			profiler->recordInterrupt(state.pc, uint16_t(state.sp + 2), kInterruptCycles);
+		}
+
+		if (tracer) {
+			tracer->recordInterrupt(uint8_t(interruptNum), true, state);
+		}
+	}
+
+	void CPU::setProfiler(Profiler* inProfiler) {
+		profiler = inProfiler;
 	}
 
-	void CPU::addBreakpoint(const Breakpoint& breakpoint) {
-		switch (breakpoint.type) {
-		case Breakpoint::Type::MemoryWrite:
-			breakpoints.memoryWrite.insert(breakpoint.address);
-			break;
-		case Breakpoint::Type::Opcode:
-			breakpoints.opcode.insert(breakpoint.address);
-			break;
-		}	
-	}	
+	Profiler* CPU::getProfiler() const {
+		return profiler;
+	}
+
+	void CPU::setTracer(TraceRecorder* inTracer) {
+		tracer = inTracer;
+	}
+
+	TraceRecorder* CPU::getTracer() const {
+		return tracer;
+	}
+
+	uint8_t CPU::getOpcodeSize(uint8_t opcode) {
+		return opcodes::kTable[opcode].size;
+	}
+
+	uint8_t CPU::getOpcodeCycles(uint8_t opcode, bool isTaken) {
+		return isTaken ? opcodes::kTable[opcode].cyclesTaken : opcodes::kTable[opcode].cycles;
+	}
+
+	uint8_t CPU::getInterruptCycles() {
+		return kInterruptCycles;
+	}
+
+	bool CPU::isOpcodeImplemented(uint8_t opcode) {
+		return (opcodes::kTable[opcode].attributes & opcodes::kImplemented) != 0;
+	}
+
+	bool CPU::isCallOpcode(uint8_t opcode) {
+		return (opcodes::kTable[opcode].attributes & opcodes::kCall) != 0;
+	}
+
+	bool CPU::isReturnOpcode(uint8_t opcode) {
+		return (opcodes::kTable[opcode].attributes & opcodes::kReturn) != 0;
+	}
+
+	bool CPU::addBreakpoint(const Breakpoint& breakpoint) {
+		if (breakpoint.endAddress < breakpoint.address) {
+			printf("CPU - breakpoint range 0x%04x - 0x%04x ends before it starts\n", breakpoint.address, breakpoint.endAddress);
+			return false;
+		}
+
+		breakpoints.list.push_back(breakpoint);
+		breakpoints.list.back().numHits = 0;
+		updateBreakpoints();
+
+		return true;
+	}
+
+	void CPU::removeBreakpoint(const Breakpoint& breakpoint) {
+		std::vector<Breakpoint>& list = breakpoints.list;
+		list.erase(std::remove_if(list.begin(), list.end(), [&breakpoint](const Breakpoint& other) {
+			return (other.type == breakpoint.type) && (other.address == breakpoint.address) && (other.endAddress == breakpoint.endAddress);
+		}), list.end());
+
+		updateBreakpoints();
+	}
+
+	void CPU::clearBreakpoints() {
+		breakpoints.list.clear();
+		updateBreakpoints();
+	}
+
+	const std::vector<Breakpoint>& CPU::getBreakpoints() const {
+		return breakpoints.list;
+	}
+
+	void CPU::saveBreakpointHits(BreakpointHits& outHits) const {
+		outHits.generation = breakpoints.generation;
+		outHits.numHits.resize(breakpoints.list.size());
+
+		for (size_t i = 0; i < breakpoints.list.size(); i++) {
+			outHits.numHits[i] = breakpoints.list[i].numHits;
+		}
+	}
+
+	void CPU::restoreBreakpointHits(const BreakpointHits& hits) {
+		if ((hits.generation != breakpoints.generation) || (hits.numHits.size() != breakpoints.list.size())) {
+			return;
+		}
+
+		for (size_t i = 0; i < breakpoints.list.size(); i++) {
+			breakpoints.list[i].numHits = hits.numHits[i];
+		}
+	}
+
+	void CPU::resetBreakpointHits() {
+		for (Breakpoint& breakpoint : breakpoints.list) {
+			breakpoint.numHits = 0;
+		}
+	}
+
+	void CPU::updateBreakpoints() {
+		breakpoints.generation++;
+		breakpoints.opcode.clear();
+		memset(breakpoints.pages, 0, sizeof(breakpoints.pages));
+		memset(breakpoints.ports, 0, sizeof(breakpoints.ports));
+		std::fill(breakpoints.addresses.begin(), breakpoints.addresses.end(), uint8_t(0));
+
+		for (const Breakpoint& breakpoint : breakpoints.list) {
+			// flags per address are only read on pages that are watched, so they are only allocated once one is
+			const bool isMemory = (breakpoint.type == Breakpoint::Type::MemoryWrite) || (breakpoint.type == Breakpoint::Type::MemoryRead);
+			if (isMemory && breakpoints.addresses.empty()) {
+				breakpoints.addresses.assign(0x10000, 0);
+			}
+
+			for (uint32_t address = breakpoint.address; address <= breakpoint.endAddress; address++) {
+				switch (breakpoint.type) {
+				case Breakpoint::Type::MemoryWrite:
+				case Breakpoint::Type::MemoryRead:
+				{
+					const uint8_t flag = (breakpoint.type == Breakpoint::Type::MemoryWrite) ? kWatchWrite : kWatchRead;
+					breakpoints.pages[address >> 8] |= flag;
+					breakpoints.addresses[address] |= flag;
+					break;
+				}
+				case Breakpoint::Type::Opcode:
+					breakpoints.opcode.insert(uint16_t(address));
+					break;
+				case Breakpoint::Type::PortIn:
+					breakpoints.ports[address & 0xff] |= kWatchIn;
+					break;
+				case Breakpoint::Type::PortOut:
+					breakpoints.ports[address & 0xff] |= kWatchOut;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
 }
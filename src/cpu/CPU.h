@@ -3,8 +3,11 @@
 #include <cstdint>
 #include <functional>
 #include <set>
+#include <vector>
 
 #include "cpu/Breakpoint.h"
+#include "cpu/Profiler.h"
+#include "cpu/TraceRecorder.h"
 #include "cpu/State.h"
 #include "memory/IMemory.h"
 
@@ -24,9 +27,10 @@ namespace cpu {
         typedef std::function<void(uint8_t port, uint8_t value)> CallbackOut;
         void setCallbackOut(CallbackOut callback);
 
-        // CallbackBreakpoint - invoked when a breakpoint is reached
+        // CallbackBreakpoint - invoked when a breakpoint is reached, and its condition + hit count are met
         typedef std::function<void(const Breakpoint & breakpoint, uint16_t value)> CallbackBreakpoint;
         void setCallbackBreakpoint(CallbackBreakpoint callback);
+        CallbackBreakpoint getCallbackBreakpoint() const;
 
         // step through an instruction at current address in pc
         void step();
@@ -40,22 +44,97 @@ namespace cpu {
         // get the current state of the CPU
         const State& getState() const;        
 
-        // add a breakpoint that is fired when an address is written to
-        void addBreakpoint(const Breakpoint& breakpoint);
+        // overwrite the current state of the CPU (i.e. when restoring a snapshot)
+        void setState(const State& state);
+
+        // overwrite the number of steps that have been simulated so far
+        void setNumSteps(uint64_t numSteps);
+
+        // get the number of clock cycles that have been simulated so far
+        uint64_t getNumCycles() const;
+
+        // overwrite the number of clock cycles that have been simulated so far
+        void setNumCycles(uint64_t numCycles);
+
+        // add a breakpoint that is fired when an opcode is reached, or a watchpoint that is fired when memory in a
+        // range of addresses is read or written, or a port is used by IN / OUT
+        // - memory is watched per page, so pages without a watchpoint cost a single test per access
+        // - a condition is only evaluated once its address is hit, so unconditional breakpoints cost no more
+        // - returns false, adding nothing, if the range ends before it starts (i.e. it would wrap past 0xFFFF)
+        bool addBreakpoint(const Breakpoint& breakpoint);
+
+        // remove every breakpoint added with the same type + addresses
+        void removeBreakpoint(const Breakpoint& breakpoint);
+
+        void clearBreakpoints();
+
+        // breakpoints that have been added, with the number of times each was hit
+        const std::vector<Breakpoint>& getBreakpoints() const;
+
+        // hit counts of every breakpoint - saved + restored along with the machine state when steps are thrown
+        // away (i.e. run ahead, or stepping back), so that discarded steps are not counted as hits
+        struct BreakpointHits {
+            uint32_t generation;
+            std::vector<uint32_t> numHits;
+        };
+        void saveBreakpointHits(BreakpointHits& outHits) const;
+
+        // counts saved before breakpoints were last added or removed are ignored
+        void restoreBreakpointHits(const BreakpointHits& hits);
+
+        // zero the hit count of every breakpoint (i.e. when a snapshot replaces the machine state)
+        void resetBreakpointHits();
+
+        // attach a profiler that records every instruction + interrupt, or detach it with nullptr
+        void setProfiler(Profiler* profiler);
+        Profiler* getProfiler() const;
+
+        // attach a recorder that traces every instruction + interrupt, or detach it with nullptr
+        // - start the recorder from the current state first (see TraceRecorder::start())
+        void setTracer(TraceRecorder* tracer);
+        TraceRecorder* getTracer() const;
+
+        // opcode details are looked up in opcodes::kTable (see Opcodes.h)
+
+        // number of bytes in opcode, including its operands
+        static uint8_t getOpcodeSize(uint8_t opcode);
+
+        // number of clock cycles for opcode - isTaken when a conditional CALL / RET changes PC
+        static uint8_t getOpcodeCycles(uint8_t opcode, bool isTaken);
+
+        // number of clock cycles to respond to an interrupt
+        static uint8_t getInterruptCycles();
+
+        // true for opcodes that step() executes - any other is skipped, with a message
+        static bool isOpcodeImplemented(uint8_t opcode);
+
+        // true for CALL, conditional CALL + RST - opcodes that push a return address
+        static bool isCallOpcode(uint8_t opcode);
+
+        // true for RET + conditional RET
+        static bool isReturnOpcode(uint8_t opcode);
 
     private:
         uint16_t unimplementedOpcode(uint16_t pc);
         uint16_t readOpcodeDataWord() const;
-        uint8_t readMemory(uint16_t address) const;
+        // read data, firing read watchpoints - opcodes + their operands are fetched without them
+        uint8_t readMemory(uint16_t address);
+        uint8_t fetchMemory(uint16_t address) const;
         void writeMemory(uint16_t address, uint8_t value);
         void call(uint16_t address, uint16_t returnAddress);
         void ret();
+        void onBreakpoint(Breakpoint::Type type, uint16_t address, uint8_t value);
+        void updateBreakpoints();
 
         State state;
 
         memory::IMemory* memory;
         
         uint64_t numSteps;
+        uint64_t numCycles;
+
+        Profiler* profiler;
+        TraceRecorder* tracer;
 
         struct Callbacks {
             CallbackIn in;
@@ -64,8 +143,18 @@ namespace cpu {
         } callbacks;
 
         struct Breakpoints {
-            std::set<uint16_t> memoryWrite;
+            // every breakpoint, with its condition + hits
+            std::vector<Breakpoint> list;
+
+            // changed whenever the list changes, so that saved hit counts can be matched to it
+            uint32_t generation;
+
+            // addresses + flags built from the list (kWatch...), to find the ones that might fire - per address
+            // flags are only checked on pages that have a flag set
             std::set<uint16_t> opcode;
+            uint8_t pages[256];
+            std::vector<uint8_t> addresses;
+            uint8_t ports[256];
         } breakpoints;
     };
 
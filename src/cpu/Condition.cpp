@@ -0,0 +1,412 @@
+#include "cpu/Condition.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace cpu {
+	namespace {
+		enum Op : uint8_t {
+			kOpConstant,
+			kOpRegister,
+			kOpValue,
+			kOpLoad,
+
+			// unary
+			kOpNot,
+			kOpComplement,
+			kOpNegate,
+
+			// binary
+			kOpOr,
+			kOpAnd,
+			kOpBitOr,
+			kOpBitXor,
+			kOpBitAnd,
+			kOpEqual,
+			kOpNotEqual,
+			kOpLess,
+			kOpLessEqual,
+			kOpGreater,
+			kOpGreaterEqual,
+			kOpAdd,
+			kOpSubtract
+		};
+
+		enum Register : uint32_t {
+			kRegisterA,
+			kRegisterB,
+			kRegisterC,
+			kRegisterD,
+			kRegisterE,
+			kRegisterH,
+			kRegisterL,
+			kRegisterBC,
+			kRegisterDE,
+			kRegisterHL,
+			kRegisterSP,
+			kRegisterPC,
+			kRegisterZ,
+			kRegisterS,
+			kRegisterP,
+			kRegisterCY,
+			kRegisterAC
+		};
+
+		struct Name {
+			const char* name;
+			Register reg;
+		};
+
+		const Name kRegisterNames[] = {
+			{ "a", kRegisterA }, { "b", kRegisterB }, { "c", kRegisterC }, { "d", kRegisterD },
+			{ "e", kRegisterE }, { "h", kRegisterH }, { "l", kRegisterL },
+			{ "bc", kRegisterBC }, { "de", kRegisterDE }, { "hl", kRegisterHL }, { "sp", kRegisterSP }, { "pc", kRegisterPC },
+			{ "z", kRegisterZ }, { "s", kRegisterS }, { "p", kRegisterP }, { "cy", kRegisterCY }, { "ac", kRegisterAC }
+		};
+
+		struct BinaryOperator {
+			const char* token;
+			Op op;
+		};
+
+		// binary operators, one level of precedence per entry, from lowest to highest - longer tokens come first
+		const BinaryOperator kOr[] = { { "||", kOpOr } };
+		const BinaryOperator kAnd[] = { { "&&", kOpAnd } };
+		const BinaryOperator kBitOr[] = { { "|", kOpBitOr } };
+		const BinaryOperator kBitXor[] = { { "^", kOpBitXor } };
+		const BinaryOperator kBitAnd[] = { { "&", kOpBitAnd } };
+		const BinaryOperator kEquality[] = { { "==", kOpEqual }, { "!=", kOpNotEqual } };
+		const BinaryOperator kRelational[] = { { "<=", kOpLessEqual }, { ">=", kOpGreaterEqual }, { "<", kOpLess }, { ">", kOpGreater } };
+		const BinaryOperator kAdditive[] = { { "+", kOpAdd }, { "-", kOpSubtract } };
+
+		struct Level {
+			const BinaryOperator* operators;
+			size_t numOperators;
+		};
+
+		const Level kLevels[] = {
+			{ kOr, 1 }, { kAnd, 1 }, { kBitOr, 1 }, { kBitXor, 1 }, { kBitAnd, 1 },
+			{ kEquality, 2 }, { kRelational, 4 }, { kAdditive, 2 }
+		};
+
+		const size_t kNumLevels = sizeof(kLevels) / sizeof(kLevels[0]);
+
+		// recursive descent parser, emitting instructions as each operand + operator is read
+		class Parser {
+		public:
+			Parser(const char* inText, std::vector<Condition::Instruction>& outCode) :
+				text(inText),
+				position(inText),
+				code(outCode),
+				depth(0),
+				error(nullptr)
+			{
+
+			}
+
+			bool parse() {
+				parseBinary(0);
+				skipSpaces();
+
+				if (!error && *position) {
+					fail("unexpected character");
+				}
+
+				if (error) {
+					printf("Condition - %s at column %zu of '%s'\n", error, size_t(position - text) + 1, text);
+					return false;
+				}
+
+				return true;
+			}
+
+		private:
+			void parseBinary(size_t level) {
+				if (level == kNumLevels) {
+					parseUnary();
+					return;
+				}
+
+				parseBinary(level + 1);
+
+				while (!error) {
+					const BinaryOperator* binary = matchOperator(kLevels[level]);
+					if (!binary) {
+						break;
+					}
+
+					parseBinary(level + 1);
+					emit(binary->op, 0, -1);
+				}
+			}
+
+			void parseUnary() {
+				skipSpaces();
+
+				Op op;
+				if ((*position == '!') && (position[1] != '=')) {
+					op = kOpNot;
+				}
+				else if (*position == '~') {
+					op = kOpComplement;
+				}
+				else if (*position == '-') {
+					op = kOpNegate;
+				}
+				else {
+					parsePrimary();
+					return;
+				}
+
+				position++;
+				parseUnary();
+				emit(op, 0, 0);
+			}
+
+			void parsePrimary() {
+				skipSpaces();
+
+				if ((*position == '(') || (*position == '[')) {
+					const char close = (*position == '(') ? ')' : ']';
+					const bool isLoad = (close == ']');
+
+					position++;
+					parseBinary(0);
+					skipSpaces();
+
+					if (error) {
+						return;
+					}
+
+					if (*position != close) {
+						fail((close == ')') ? "expected ')'" : "expected ']'");
+						return;
+					}
+					position++;
+
+					if (isLoad) {
+						emit(kOpLoad, 0, 0);
+					}
+				}
+				else if (isdigit(static_cast<unsigned char>(*position))) {
+					// a leading 0 is not octal
+					const bool isHex = (position[0] == '0') && ((position[1] == 'x') || (position[1] == 'X'));
+
+					char* end = nullptr;
+					const unsigned long long number = strtoull(position, &end, isHex ? 16 : 10);
+					if ((end == position) || (number > 0xffffffffull)) {
+						fail("invalid number");
+						return;
+					}
+
+					position = end;
+					emit(kOpConstant, uint32_t(number), 1);
+				}
+				else if (isalpha(static_cast<unsigned char>(*position))) {
+					const char* start = position;
+					while (isalnum(static_cast<unsigned char>(*position))) {
+						position++;
+					}
+
+					parseName(start, size_t(position - start));
+				}
+				else {
+					fail(*position ? "expected a number, register or '('" : "unexpected end of expression");
+				}
+			}
+
+			void parseName(const char* name, size_t length) {
+				char lower[8] = {};
+				if (length < sizeof(lower)) {
+					for (size_t i = 0; i < length; i++) {
+						lower[i] = char(tolower(static_cast<unsigned char>(name[i])));
+					}
+				}
+
+				if (strcmp(lower, "value") == 0) {
+					emit(kOpValue, 0, 1);
+					return;
+				}
+
+				for (const Name& registerName : kRegisterNames) {
+					if (strcmp(lower, registerName.name) == 0) {
+						emit(kOpRegister, registerName.reg, 1);
+						return;
+					}
+				}
+
+				position = name;
+				fail("unknown register");
+			}
+
+			const BinaryOperator* matchOperator(const Level& level) {
+				skipSpaces();
+
+				for (size_t i = 0; i < level.numOperators; i++) {
+					const BinaryOperator& binary = level.operators[i];
+					const size_t length = strlen(binary.token);
+
+					if (strncmp(position, binary.token, length) != 0) {
+						continue;
+					}
+
+					// '|' + '&' are not the first half of '||' + '&&'
+					if ((length == 1) && ((*position == '|') || (*position == '&')) && (position[1] == *position)) {
+						continue;
+					}
+
+					position += length;
+					return &binary;
+				}
+
+				return nullptr;
+			}
+
+			void emit(Op op, uint32_t operand, int stackChange) {
+				if (error) {
+					return;
+				}
+
+				depth += stackChange;
+				if (depth > int(Condition::kMaxStack)) {
+					fail("expression too deep");
+					return;
+				}
+
+				code.push_back({ op, operand });
+			}
+
+			void skipSpaces() {
+				while (isspace(static_cast<unsigned char>(*position))) {
+					position++;
+				}
+			}
+
+			void fail(const char* message) {
+				if (!error) {
+					error = message;
+				}
+			}
+
+			const char* text;
+			const char* position;
+			std::vector<Condition::Instruction>& code;
+			int depth;
+			const char* error;
+		};
+
+		uint32_t getRegister(const State& state, uint32_t reg) {
+			switch (reg) {
+			case kRegisterA: return state.a;
+			case kRegisterB: return state.b;
+			case kRegisterC: return state.c;
+			case kRegisterD: return state.d;
+			case kRegisterE: return state.e;
+			case kRegisterH: return state.h;
+			case kRegisterL: return state.l;
+			case kRegisterBC: return (uint32_t(state.b) << 8) | state.c;
+			case kRegisterDE: return (uint32_t(state.d) << 8) | state.e;
+			case kRegisterHL: return (uint32_t(state.h) << 8) | state.l;
+			case kRegisterSP: return state.sp;
+			case kRegisterPC: return state.pc;
+			case kRegisterZ: return state.cc.z;
+			case kRegisterS: return state.cc.s;
+			case kRegisterP: return state.cc.p;
+			case kRegisterCY: return state.cc.cy;
+			case kRegisterAC: return state.cc.ac;
+			default: return 0;
+			}
+		}
+	}
+
+	Condition::Condition() {
+
+	}
+
+	bool Condition::compile(const char* inExpression) {
+		expression.clear();
+		code.clear();
+
+		std::vector<Instruction> compiled;
+		Parser parser(inExpression, compiled);
+		if (!parser.parse()) {
+			return false;
+		}
+
+		expression = inExpression;
+		code.swap(compiled);
+
+		return true;
+	}
+
+	bool Condition::isEmpty() const {
+		return code.empty();
+	}
+
+	const std::string& Condition::getExpression() const {
+		return expression;
+	}
+
+	bool Condition::evaluate(const State& state, const memory::IMemory& memory, uint8_t value) const {
+		if (code.empty()) {
+			return true;
+		}
+
+		// compile() checked the depth of the stack, so it is not checked again here
+		uint32_t stack[kMaxStack];
+		size_t top = 0;
+
+		for (const Instruction& instruction : code) {
+			switch (instruction.op) {
+			case kOpConstant:
+				stack[top++] = instruction.operand;
+				break;
+			case kOpRegister:
+				stack[top++] = getRegister(state, instruction.operand);
+				break;
+			case kOpValue:
+				stack[top++] = value;
+				break;
+			case kOpLoad:
+				stack[top - 1] = memory.read(memory.translate(uint16_t(stack[top - 1])));
+				break;
+			case kOpNot:
+				stack[top - 1] = !stack[top - 1];
+				break;
+			case kOpComplement:
+				stack[top - 1] = ~stack[top - 1];
+				break;
+			case kOpNegate:
+				stack[top - 1] = 0u - stack[top - 1];
+				break;
+			default:
+			{
+				const uint32_t right = stack[--top];
+				uint32_t& left = stack[top - 1];
+
+				switch (instruction.op) {
+				case kOpOr: left = (left || right); break;
+				case kOpAnd: left = (left && right); break;
+				case kOpBitOr: left |= right; break;
+				case kOpBitXor: left ^= right; break;
+				case kOpBitAnd: left &= right; break;
+				case kOpEqual: left = (left == right); break;
+				case kOpNotEqual: left = (left != right); break;
+				case kOpLess: left = (left < right); break;
+				case kOpLessEqual: left = (left <= right); break;
+				case kOpGreater: left = (left > right); break;
+				case kOpGreaterEqual: left = (left >= right); break;
+				case kOpAdd: left += right; break;
+				case kOpSubtract: left -= right; break;
+				default: break;
+				}
+				break;
+			}
+			}
+		}
+
+		return stack[0] != 0;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cpu/State.h"
+#include "memory/IMemory.h"
+
+namespace cpu {
+
+    /// @class Condition
+    /// @brief An expression that a breakpoint must satisfy before it fires, i.e. "a == 0x10 && [0x20eb] > 3"
+    /// @note the expression is parsed once by compile(), into bytecode for a small stack machine - evaluate()
+    ///       only runs that bytecode, and is only called once the address of its breakpoint has been hit.
+    ///
+    ///       Operands are numbers (decimal or 0x hex), registers (a b c d e h l bc de hl sp pc), flags
+    ///       (z s p cy ac), the byte at an address ([hl], [0x20eb]), and value - the byte written or read by a
+    ///       watchpoint, or used by IN / OUT. Operators follow C, from lowest precedence: || && | ^ & == !=
+    ///       < <= > >= + - and the unary ! ~ -. Names are not case sensitive. Every value is unsigned 32 bit.
+    class Condition {
+    public:
+        Condition();
+
+        // parse expression - returns false (and prints why) if it is not valid, leaving the condition empty
+        bool compile(const char* expression);
+
+        // true if there is no expression, so the condition always holds
+        bool isEmpty() const;
+
+        // the expression that was compiled
+        const std::string& getExpression() const;
+
+        // memory is read for [address] before a watched write is made, so it holds the old value
+        bool evaluate(const State& state, const memory::IMemory& memory, uint8_t value) const;
+
+        // deepest the stack of an expression can be
+        static const size_t kMaxStack = 16;
+
+        // one operation of the compiled expression - op is private to Condition.cpp
+        struct Instruction {
+            uint8_t op;
+            uint32_t operand;
+        };
+
+    private:
+        std::string expression;
+        std::vector<Instruction> code;
+    };
+
+}
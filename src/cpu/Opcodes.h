@@ -0,0 +1,328 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cpu {
+
+    namespace opcodes {
+        // kind of operand that follows an opcode
+        enum Operand : uint8_t {
+            kOperandNone,
+            kOperandD8,         // data or port, 1 byte
+            kOperandD16         // data or address, 2 bytes (low byte first)
+        };
+
+        // attributes of an opcode
+        const uint8_t kImplemented = (1 << 0);      // executed by CPU::step() - any other opcode is skipped with a message
+        const uint8_t kUndocumented = (1 << 1);     // alias of the opcode it is named after - disassembled as "-"
+        const uint8_t kCall = (1 << 2);             // pushes a return address (CALL, Ccc + RST)
+        const uint8_t kReturn = (1 << 3);           // pops a return address (RET + Rcc)
+    }
+
+    /// @struct OpcodeInfo
+    /// @brief Description of an opcode - how it is disassembled, its size + clock cycles
+    struct OpcodeInfo {
+        const char* mnemonic;
+
+        // text between the mnemonic + the operand, i.e. "B, #" for "MVI    B, #$12"
+        const char* operands;
+        opcodes::Operand operand;
+
+        // number of bytes, including the operand
+        uint8_t size;
+
+        // number of clock cycles, and the number when a conditional CALL / RET changes PC
+        uint8_t cycles;
+        uint8_t cyclesTaken;
+
+        // opcodes::kImplemented, kCall etc.
+        uint8_t attributes;
+    };
+
+    namespace opcodes {
+        // every opcode - the one description shared by CPU, the lockstep engine, the disassembler + the profiler
+        // http://www.emulator101.com/reference/8080-by-opcode.html
+        inline constexpr OpcodeInfo kTable[256] = {
+            // mnemonic, operands, operand, size, cycles, cyclesTaken, attributes
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x00
+            { "LXI",  "B, #",  kOperandD16,  3, 10, 10, kImplemented           },  // 0x01
+            { "STAX", "B",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x02
+            { "INX",  "B",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x03
+            { "INR",  "B",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x04
+            { "DCR",  "B",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x05
+            { "MVI",  "B, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x06
+            { "RLC",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x07
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kUndocumented          },  // 0x08
+            { "DAD",  "B",     kOperandNone, 1, 10, 10, kImplemented           },  // 0x09
+            { "LDAX", "B",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x0A
+            { "DCX",  "B",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x0B
+            { "INR",  "C",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x0C
+            { "DCR",  "C",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x0D
+            { "MVI",  "C, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x0E
+            { "RRC",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x0F
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kUndocumented          },  // 0x10
+            { "LXI",  "D, #",  kOperandD16,  3, 10, 10, kImplemented           },  // 0x11
+            { "STAX", "D",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x12
+            { "INX",  "D",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x13
+            { "INR",  "D",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x14
+            { "DCR",  "D",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x15
+            { "MVI",  "D, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x16
+            { "RAL",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x17
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kUndocumented          },  // 0x18
+            { "DAD",  "D",     kOperandNone, 1, 10, 10, kImplemented           },  // 0x19
+            { "LDAX", "D",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x1A
+            { "DCX",  "D",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x1B
+            { "INR",  "E",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x1C
+            { "DCR",  "E",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x1D
+            { "MVI",  "E, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x1E
+            { "RAR",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x1F
+            { "RIM",  "",      kOperandNone, 1,  4,  4, 0                      },  // 0x20
+            { "LXI",  "H, #",  kOperandD16,  3, 10, 10, kImplemented           },  // 0x21
+            { "SHLD", "",      kOperandD16,  3, 16, 16, kImplemented           },  // 0x22
+            { "INX",  "H",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x23
+            { "INR",  "H",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x24
+            { "DCR",  "H",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x25
+            { "MVI",  "H, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x26
+            { "DAA",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x27
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kUndocumented          },  // 0x28
+            { "DAD",  "H",     kOperandNone, 1, 10, 10, kImplemented           },  // 0x29
+            { "LHLD", "",      kOperandD16,  3, 16, 16, kImplemented           },  // 0x2A
+            { "DCX",  "H",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x2B
+            { "INR",  "L",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x2C
+            { "DCR",  "L",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x2D
+            { "MVI",  "L, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x2E
+            { "CMA",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x2F
+            { "SIM",  "",      kOperandNone, 1,  4,  4, 0                      },  // 0x30
+            { "LXI",  "SP, #", kOperandD16,  3, 10, 10, kImplemented           },  // 0x31
+            { "STA",  "",      kOperandD16,  3, 13, 13, kImplemented           },  // 0x32
+            { "INX",  "SP",    kOperandNone, 1,  5,  5, kImplemented           },  // 0x33
+            { "INR",  "M",     kOperandNone, 1, 10, 10, kImplemented           },  // 0x34
+            { "DCR",  "M",     kOperandNone, 1, 10, 10, kImplemented           },  // 0x35
+            { "MVI",  "M, #",  kOperandD8,   2, 10, 10, kImplemented           },  // 0x36
+            { "STC",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x37
+            { "NOP",  "",      kOperandNone, 1,  4,  4, kUndocumented          },  // 0x38
+            { "DAD",  "SP",    kOperandNone, 1, 10, 10, kImplemented           },  // 0x39
+            { "LDA",  "",      kOperandD16,  3, 13, 13, kImplemented           },  // 0x3A
+            { "DCX",  "SP",    kOperandNone, 1,  5,  5, kImplemented           },  // 0x3B
+            { "INR",  "A",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x3C
+            { "DCR",  "A",     kOperandNone, 1,  5,  5, kImplemented           },  // 0x3D
+            { "MVI",  "A, #",  kOperandD8,   2,  7,  7, kImplemented           },  // 0x3E
+            { "CMC",  "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0x3F
+            { "MOV",  "B, B",  kOperandNone, 1,  5,  5, 0                      },  // 0x40
+            { "MOV",  "B, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x41
+            { "MOV",  "B, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x42
+            { "MOV",  "B, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x43
+            { "MOV",  "B, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x44
+            { "MOV",  "B, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x45
+            { "MOV",  "B, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x46
+            { "MOV",  "B, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x47
+            { "MOV",  "C, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x48
+            { "MOV",  "C, C",  kOperandNone, 1,  5,  5, 0                      },  // 0x49
+            { "MOV",  "C, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x4A
+            { "MOV",  "C, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x4B
+            { "MOV",  "C, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x4C
+            { "MOV",  "C, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x4D
+            { "MOV",  "C, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x4E
+            { "MOV",  "C, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x4F
+            { "MOV",  "D, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x50
+            { "MOV",  "D, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x51
+            { "MOV",  "D, D",  kOperandNone, 1,  5,  5, 0                      },  // 0x52
+            { "MOV",  "D, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x53
+            { "MOV",  "D, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x54
+            { "MOV",  "D, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x55
+            { "MOV",  "D, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x56
+            { "MOV",  "D, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x57
+            { "MOV",  "E, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x58
+            { "MOV",  "E, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x59
+            { "MOV",  "E, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x5A
+            { "MOV",  "E, E",  kOperandNone, 1,  5,  5, 0                      },  // 0x5B
+            { "MOV",  "E, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x5C
+            { "MOV",  "E, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x5D
+            { "MOV",  "E, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x5E
+            { "MOV",  "E, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x5F
+            { "MOV",  "H, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x60
+            { "MOV",  "H, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x61
+            { "MOV",  "H, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x62
+            { "MOV",  "H, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x63
+            { "MOV",  "H, H",  kOperandNone, 1,  5,  5, 0                      },  // 0x64
+            { "MOV",  "H, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x65
+            { "MOV",  "H, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x66
+            { "MOV",  "H, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x67
+            { "MOV",  "L, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x68
+            { "MOV",  "L, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x69
+            { "MOV",  "L, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x6A
+            { "MOV",  "L, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x6B
+            { "MOV",  "L, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x6C
+            { "MOV",  "L, L",  kOperandNone, 1,  5,  5, 0                      },  // 0x6D
+            { "MOV",  "L, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x6E
+            { "MOV",  "L, A",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x6F
+            { "MOV",  "M, B",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x70
+            { "MOV",  "M, C",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x71
+            { "MOV",  "M, D",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x72
+            { "MOV",  "M, E",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x73
+            { "MOV",  "M, H",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x74
+            { "MOV",  "M, L",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x75
+            { "HLT",  "",      kOperandNone, 1,  7,  7, 0                      },  // 0x76
+            { "MOV",  "M, A",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x77
+            { "MOV",  "A, B",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x78
+            { "MOV",  "A, C",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x79
+            { "MOV",  "A, D",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x7A
+            { "MOV",  "A, E",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x7B
+            { "MOV",  "A, H",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x7C
+            { "MOV",  "A, L",  kOperandNone, 1,  5,  5, kImplemented           },  // 0x7D
+            { "MOV",  "A, M",  kOperandNone, 1,  7,  7, kImplemented           },  // 0x7E
+            { "MOV",  "A, A",  kOperandNone, 1,  5,  5, 0                      },  // 0x7F
+            { "ADD",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x80
+            { "ADD",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x81
+            { "ADD",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x82
+            { "ADD",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x83
+            { "ADD",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x84
+            { "ADD",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x85
+            { "ADD",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x86
+            { "ADD",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x87
+            { "ADC",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x88
+            { "ADC",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x89
+            { "ADC",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x8A
+            { "ADC",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x8B
+            { "ADC",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x8C
+            { "ADC",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x8D
+            { "ADC",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x8E
+            { "ADC",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x8F
+            { "SUB",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x90
+            { "SUB",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x91
+            { "SUB",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x92
+            { "SUB",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x93
+            { "SUB",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x94
+            { "SUB",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x95
+            { "SUB",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x96
+            { "SUB",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x97
+            { "SBB",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x98
+            { "SBB",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x99
+            { "SBB",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x9A
+            { "SBB",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x9B
+            { "SBB",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x9C
+            { "SBB",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x9D
+            { "SBB",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0x9E
+            { "SBB",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0x9F
+            { "ANA",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA0
+            { "ANA",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA1
+            { "ANA",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA2
+            { "ANA",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA3
+            { "ANA",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA4
+            { "ANA",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA5
+            { "ANA",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0xA6
+            { "ANA",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA7
+            { "XRA",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA8
+            { "XRA",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xA9
+            { "XRA",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xAA
+            { "XRA",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xAB
+            { "XRA",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xAC
+            { "XRA",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xAD
+            { "XRA",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0xAE
+            { "XRA",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xAF
+            { "ORA",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB0
+            { "ORA",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB1
+            { "ORA",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB2
+            { "ORA",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB3
+            { "ORA",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB4
+            { "ORA",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB5
+            { "ORA",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0xB6
+            { "ORA",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB7
+            { "CMP",  "B",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB8
+            { "CMP",  "C",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xB9
+            { "CMP",  "D",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xBA
+            { "CMP",  "E",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xBB
+            { "CMP",  "H",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xBC
+            { "CMP",  "L",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xBD
+            { "CMP",  "M",     kOperandNone, 1,  7,  7, kImplemented           },  // 0xBE
+            { "CMP",  "A",     kOperandNone, 1,  4,  4, kImplemented           },  // 0xBF
+            { "RNZ",  "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xC0
+            { "POP",  "B",     kOperandNone, 1, 10, 10, kImplemented           },  // 0xC1
+            { "JNZ",  "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xC2
+            { "JMP",  "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xC3
+            { "CNZ",  "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xC4
+            { "PUSH", "B",     kOperandNone, 1, 11, 11, kImplemented           },  // 0xC5
+            { "ADI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xC6
+            { "RST",  "0",     kOperandNone, 1, 11, 11, kCall                  },  // 0xC7
+            { "RZ",   "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xC8
+            { "RET",  "",      kOperandNone, 1, 10, 10, kImplemented | kReturn },  // 0xC9
+            { "JZ",   "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xCA
+            { "JMP",  "",      kOperandD16,  3, 10, 10, kUndocumented          },  // 0xCB
+            { "CZ",   "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xCC
+            { "CALL", "",      kOperandD16,  3, 17, 17, kImplemented | kCall   },  // 0xCD
+            { "ACI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xCE
+            { "RST",  "1",     kOperandNone, 1, 11, 11, kCall                  },  // 0xCF
+            { "RNC",  "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xD0
+            { "POP",  "D",     kOperandNone, 1, 10, 10, kImplemented           },  // 0xD1
+            { "JNC",  "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xD2
+            { "OUT",  "",      kOperandD8,   2, 10, 10, kImplemented           },  // 0xD3
+            { "CNC",  "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xD4
+            { "PUSH", "D",     kOperandNone, 1, 11, 11, kImplemented           },  // 0xD5
+            { "SUI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xD6
+            { "RST",  "2",     kOperandNone, 1, 11, 11, kCall                  },  // 0xD7
+            { "RC",   "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xD8
+            { "RET",  "",      kOperandNone, 1, 10, 10, kUndocumented          },  // 0xD9
+            { "JC",   "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xDA
+            { "IN",   "#",     kOperandD8,   2, 10, 10, kImplemented           },  // 0xDB
+            { "CC",   "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xDC
+            { "CALL", "",      kOperandD16,  3, 17, 17, kUndocumented          },  // 0xDD
+            { "SBI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xDE
+            { "RST",  "3",     kOperandNone, 1, 11, 11, kCall                  },  // 0xDF
+            { "RPO",  "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xE0
+            { "POP",  "H",     kOperandNone, 1, 10, 10, kImplemented           },  // 0xE1
+            { "JPO",  "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xE2
+            { "XTHL", "",      kOperandNone, 1, 18, 18, kImplemented           },  // 0xE3
+            { "CPO",  "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xE4
+            { "PUSH", "H",     kOperandNone, 1, 11, 11, kImplemented           },  // 0xE5
+            { "ANI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xE6
+            { "RST",  "4",     kOperandNone, 1, 11, 11, kCall                  },  // 0xE7
+            { "RPE",  "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xE8
+            { "PCHL", "",      kOperandNone, 1,  5,  5, kImplemented           },  // 0xE9
+            { "JPE",  "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xEA
+            { "XCHG", "",      kOperandNone, 1,  5,  5, kImplemented           },  // 0xEB
+            { "CPE",  "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xEC
+            { "CALL", "",      kOperandD16,  3, 17, 17, kUndocumented          },  // 0xED
+            { "XRI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xEE
+            { "RST",  "5",     kOperandNone, 1, 11, 11, kCall                  },  // 0xEF
+            { "RP",   "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xF0
+            { "POP",  "PSW",   kOperandNone, 1, 10, 10, kImplemented           },  // 0xF1
+            { "JP",   "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xF2
+            { "DI",   "",      kOperandNone, 1,  4,  4, 0                      },  // 0xF3
+            { "CP",   "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xF4
+            { "PUSH", "PSW",   kOperandNone, 1, 11, 11, kImplemented           },  // 0xF5
+            { "ORI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xF6
+            { "RST",  "6",     kOperandNone, 1, 11, 11, kCall                  },  // 0xF7
+            { "RM",   "",      kOperandNone, 1,  5, 11, kImplemented | kReturn },  // 0xF8
+            { "SPHL", "",      kOperandNone, 1,  5,  5, kImplemented           },  // 0xF9
+            { "JM",   "",      kOperandD16,  3, 10, 10, kImplemented           },  // 0xFA
+            { "EI",   "",      kOperandNone, 1,  4,  4, kImplemented           },  // 0xFB
+            { "CM",   "",      kOperandD16,  3, 11, 17, kImplemented | kCall   },  // 0xFC
+            { "CALL", "",      kOperandD16,  3, 17, 17, kUndocumented          },  // 0xFD
+            { "CPI",  "#",     kOperandD8,   2,  7,  7, kImplemented           },  // 0xFE
+            { "RST",  "7",     kOperandNone, 1, 11, 11, kCall                  },  // 0xFF
+        };
+
+        // every entry agrees with itself - its size with its operand, and only conditional CALL + RET take longer
+        // when taken
+        constexpr bool isTableValid() {
+            for (const OpcodeInfo& info : kTable) {
+                if ((info.mnemonic == nullptr) || (info.operands == nullptr)) {
+                    return false;
+                }
+
+                const uint8_t size = (info.operand == kOperandD16) ? 3 : ((info.operand == kOperandD8) ? 2 : 1);
+                if (info.size != size) {
+                    return false;
+                }
+
+                if ((info.cyclesTaken != info.cycles) && ((info.cyclesTaken < info.cycles) || !(info.attributes & (kCall | kReturn)))) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        static_assert(isTableValid(), "opcodes::kTable is inconsistent");
+    }
+}
@@ -0,0 +1,322 @@
+#include "cpu/Profiler.h"
+#include "cpu/Opcodes.h"
+
+#include "Disassemble.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace cpu {
+	namespace {
+		const size_t kNumAddresses = 0x10000;
+
+		// deeper calls are attributed to the deepest tracked subroutine (i.e. runaway recursion)
+		const size_t kMaxCallDepth = 1024;
+
+		double getPercent(uint64_t value, uint64_t total) {
+			return (total > 0) ? (100.0 * double(value) / double(total)) : 0.0;
+		}
+	}
+
+	Profiler::Profiler() {
+		reset();
+	}
+
+	void Profiler::reset() {
+		numInstructions = 0;
+		numCycles = 0;
+		numInterrupts = 0;
+		numInterruptCycles = 0;
+
+		memset(opcodeCounts, 0, sizeof(opcodeCounts));
+		memset(opcodeCycles, 0, sizeof(opcodeCycles));
+
+		counts.assign(kNumAddresses, 0);
+		cycles.assign(kNumAddresses, 0);
+
+		// keep the shadow call stack, so a profile can be restarted part way through a call (i.e. for each phase
+		// of a game), with the nodes of the current call path recreated
+		std::vector<CallNode> path;
+		for (const CallFrame& frame : callStack) {
+			path.push_back(callNodes[frame.node]);
+		}
+
+		callNodes.clear();
+		callNodeIndices.clear();
+		callNodes.push_back({ 0, 0, false, 0, 0 });
+
+		uint32_t node = 0;
+		for (size_t i = 0; i < callStack.size(); i++) {
+			node = getChild(node, path[i].address, path[i].isInterrupt);
+			callStack[i].node = node;
+		}
+	}
+
+	void Profiler::record(uint16_t pc, uint8_t opcode, uint8_t inCycles) {
+		numInstructions += 1;
+		numCycles += inCycles;
+
+		opcodeCounts[opcode] += 1;
+		opcodeCycles[opcode] += inCycles;
+
+		counts[pc] += 1;
+		cycles[pc] += inCycles;
+
+		callNodes[getCurrentNode()].cycles += inCycles;
+	}
+
+	void Profiler::recordCall(uint16_t address, uint16_t sp) {
+		pushFrame(address, false, sp);
+	}
+
+	void Profiler::recordReturn(uint16_t sp) {
+		popFrames(sp);
+	}
+
+	void Profiler::recordInterrupt(uint16_t address, uint16_t sp, uint8_t inCycles) {
+		numInterrupts += 1;
+		numInterruptCycles += inCycles;
+		numCycles += inCycles;
+
+		pushFrame(address, true, sp);
+		callNodes[getCurrentNode()].cycles += inCycles;
+	}
+
+	void Profiler::pushFrame(uint16_t address, bool isInterrupt, uint16_t sp) {
+		popFrames(sp);
+
+		if (callStack.size() >= kMaxCallDepth) {
+			return;
+		}
+
+		const uint32_t node = getChild(getCurrentNode(), address, isInterrupt);
+		callNodes[node].numCalls += 1;
+		callStack.push_back({ node, sp });
+	}
+
+	void Profiler::popFrames(uint16_t sp) {
+		// the stack pointer is below returnSp until a frame returns - above it, the frame has been returned
+		// from, or discarded by resetting SP
+		while (!callStack.empty() && (sp >= callStack.back().returnSp)) {
+			callStack.pop_back();
+		}
+	}
+
+	uint32_t Profiler::getChild(uint32_t parent, uint16_t address, bool isInterrupt) {
+		const uint64_t key = (uint64_t(parent) << 17) | (isInterrupt ? 0x10000 : 0) | address;
+
+		auto it = callNodeIndices.find(key);
+		if (it != callNodeIndices.end()) {
+			return it->second;
+		}
+
+		const uint32_t node = uint32_t(callNodes.size());
+		callNodes.push_back({ parent, address, isInterrupt, 0, 0 });
+		callNodeIndices.emplace(key, node);
+
+		return node;
+	}
+
+	uint32_t Profiler::getCurrentNode() const {
+		return callStack.empty() ? 0 : callStack.back().node;
+	}
+
+	std::string Profiler::getName(uint32_t node) const {
+		if (node == 0) {
+			return "main";
+		}
+
+		char buffer[16];
+		snprintf(buffer, sizeof(buffer), callNodes[node].isInterrupt ? "int_0x%04x" : "0x%04x", callNodes[node].address);
+
+		return buffer;
+	}
+
+	uint64_t Profiler::getNumInstructions() const {
+		return numInstructions;
+	}
+
+	uint64_t Profiler::getNumCycles() const {
+		return numCycles;
+	}
+
+	uint64_t Profiler::getNumInterrupts() const {
+		return numInterrupts;
+	}
+
+	uint64_t Profiler::getOpcodeCount(uint8_t opcode) const {
+		return opcodeCounts[opcode];
+	}
+
+	uint64_t Profiler::getOpcodeCycles(uint8_t opcode) const {
+		return opcodeCycles[opcode];
+	}
+
+	uint64_t Profiler::getCount(uint16_t pc) const {
+		return counts[pc];
+	}
+
+	uint64_t Profiler::getCycles(uint16_t pc) const {
+		return cycles[pc];
+	}
+
+	void Profiler::print(memory::IMemory* memory, size_t numHotspots) const {
+		printf("%llu instructions, %llu cycles, %llu interrupts (%.1f%% of cycles)\n",
+			(unsigned long long)numInstructions, (unsigned long long)numCycles, (unsigned long long)numInterrupts, getPercent(numInterruptCycles, numCycles));
+
+		// each opcode is disassembled from the hottest address it was executed at
+		uint32_t opcodeAddresses[256];
+		for (uint32_t& address : opcodeAddresses) {
+			address = uint32_t(kNumAddresses);
+		}
+
+		for (uint32_t pc = 0; pc < kNumAddresses; pc++) {
+			if (counts[pc] > 0) {
+				uint32_t& address = opcodeAddresses[memory->read(uint16_t(pc))];
+				if ((address == kNumAddresses) || (counts[pc] > counts[address])) {
+					address = pc;
+				}
+			}
+		}
+
+		std::vector<uint32_t> opcodes;
+		for (uint32_t opcode = 0; opcode < 256; opcode++) {
+			if (opcodeCounts[opcode] > 0) {
+				opcodes.push_back(opcode);
+			}
+		}
+		std::sort(opcodes.begin(), opcodes.end(), [this](uint32_t a, uint32_t b) { return opcodeCounts[a] > opcodeCounts[b]; });
+
+		printf("\nopcodes by executions (%zu of 256 used):\n", opcodes.size());
+		printf("  opcode  %14s      %%  %14s      %%  instruction (at its hottest address)\n", "executions", "cycles");
+
+		for (uint32_t opcode : opcodes) {
+			uint16_t opcodeSize = 0;
+			const uint32_t address = opcodeAddresses[opcode];
+			const std::string instruction = (address < kNumAddresses) ? Disassemble::stringFromOpcode(memory, uint16_t(address), opcodeSize) : opcodes::kTable[opcode].mnemonic;
+
+			// opcodes the CPU does not implement are skipped rather than run, so their cycles are not the code's
+			const bool isImplemented = (opcodes::kTable[opcode].attributes & opcodes::kImplemented) != 0;
+
+			printf("  0x%02x    %14llu  %5.1f  %14llu  %5.1f  %s%s\n", opcode,
+				(unsigned long long)opcodeCounts[opcode], getPercent(opcodeCounts[opcode], numInstructions),
+				(unsigned long long)opcodeCycles[opcode], getPercent(opcodeCycles[opcode], numCycles), instruction.c_str(),
+				isImplemented ? "" : "  (not implemented)");
+		}
+
+		std::vector<uint32_t> addresses;
+		for (uint32_t pc = 0; pc < kNumAddresses; pc++) {
+			if (counts[pc] > 0) {
+				addresses.push_back(pc);
+			}
+		}
+
+		const size_t numPrinted = std::min(numHotspots, addresses.size());
+		std::partial_sort(addresses.begin(), addresses.begin() + numPrinted, addresses.end(), [this](uint32_t a, uint32_t b) {
+			return (cycles[a] != cycles[b]) ? (cycles[a] > cycles[b]) : (a < b);
+		});
+
+		printf("\nhottest addresses by cycles (%zu of %zu executed):\n", numPrinted, addresses.size());
+		printf("  address  %14s  %14s      %%  cumulative  instruction\n", "executions", "cycles");
+
+		uint64_t cumulativeCycles = 0;
+		for (size_t i = 0; i < numPrinted; i++) {
+			const uint32_t pc = addresses[i];
+			cumulativeCycles += cycles[pc];
+
+			uint16_t opcodeSize = 0;
+			const std::string instruction = Disassemble::stringFromOpcode(memory, uint16_t(pc), opcodeSize);
+
+			printf("  0x%04x   %14llu  %14llu  %5.1f       %5.1f  %s\n", pc,
+				(unsigned long long)counts[pc], (unsigned long long)cycles[pc], getPercent(cycles[pc], numCycles),
+				getPercent(cumulativeCycles, numCycles), instruction.c_str());
+		}
+	
+		// cycles of each call path including its callees - children always follow their parent
+		std::vector<uint64_t> inclusiveCycles(callNodes.size());
+		for (size_t node = callNodes.size(); node-- > 0;) {
+			inclusiveCycles[node] += callNodes[node].cycles;
+			if (node > 0) {
+				inclusiveCycles[callNodes[node].parent] += inclusiveCycles[node];
+			}
+		}
+
+		// totals per subroutine - a subroutine that is already further up the path is not counted again
+		struct Subroutine {
+			uint32_t node;
+			uint64_t numCalls;
+			uint64_t cycles;
+			uint64_t selfCycles;
+		};
+
+		std::unordered_map<uint32_t, Subroutine> subroutines;
+		for (uint32_t node = 1; node < callNodes.size(); node++) {
+			const uint32_t key = (callNodes[node].isInterrupt ? 0x10000 : 0) | callNodes[node].address;
+
+			auto it = subroutines.emplace(key, Subroutine{ node, 0, 0, 0 }).first;
+			it->second.numCalls += callNodes[node].numCalls;
+			it->second.selfCycles += callNodes[node].cycles;
+
+			bool isRecursive = false;
+			for (uint32_t ancestor = callNodes[node].parent; (ancestor != 0) && !isRecursive; ancestor = callNodes[ancestor].parent) {
+				isRecursive = (callNodes[ancestor].address == callNodes[node].address) && (callNodes[ancestor].isInterrupt == callNodes[node].isInterrupt);
+			}
+
+			if (!isRecursive) {
+				it->second.cycles += inclusiveCycles[node];
+			}
+		}
+
+		std::vector<Subroutine> sortedSubroutines;
+		for (const auto& entry : subroutines) {
+			sortedSubroutines.push_back(entry.second);
+		}
+
+		const size_t numSubroutines = std::min(numHotspots, sortedSubroutines.size());
+		std::partial_sort(sortedSubroutines.begin(), sortedSubroutines.begin() + numSubroutines, sortedSubroutines.end(), [this](const Subroutine& a, const Subroutine& b) {
+			return (a.cycles != b.cycles) ? (a.cycles > b.cycles) : (callNodes[a.node].address < callNodes[b.node].address);
+		});
+
+		printf("\nsubroutines by cycles including callees (%zu of %zu called, %zu call paths):\n", numSubroutines, sortedSubroutines.size(), callNodes.size() - 1);
+		printf("  subroutine  %14s  %14s      %%  %14s      %%\n", "calls", "cycles", "self cycles");
+
+		for (size_t i = 0; i < numSubroutines; i++) {
+			const Subroutine& subroutine = sortedSubroutines[i];
+
+			printf("  %-10s  %14llu  %14llu  %5.1f  %14llu  %5.1f\n", getName(subroutine.node).c_str(), (unsigned long long)subroutine.numCalls,
+				(unsigned long long)subroutine.cycles, getPercent(subroutine.cycles, numCycles),
+				(unsigned long long)subroutine.selfCycles, getPercent(subroutine.selfCycles, numCycles));
+		}
+	}
+
+	bool Profiler::writeFoldedStacks(const char* filename) const {
+		std::ofstream file;
+		file.open(filename, std::ios::out | std::ios::trunc);
+		if (!file.is_open()) {
+			printf("Profiler - unable to open %s for writing\n", filename);
+			return false;
+		}
+
+		std::vector<uint32_t> path;
+		for (uint32_t node = 0; node < callNodes.size(); node++) {
+			if (callNodes[node].cycles == 0) {
+				continue;
+			}
+
+			path.clear();
+			for (uint32_t ancestor = node; ancestor != 0; ancestor = callNodes[ancestor].parent) {
+				path.push_back(ancestor);
+			}
+
+			file << getName(0);
+			for (size_t i = path.size(); i-- > 0;) {
+				file << ';' << getName(path[i]);
+			}
+			file << ' ' << callNodes[node].cycles << '\n';
+		}
+
+		return bool(file);
+	}
+}
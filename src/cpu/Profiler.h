@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory/IMemory.h"
+
+namespace cpu {
+
+    /// @class Profiler
+    /// @brief Execution counts + clock cycles per opcode and per PC, recorded by the CPU it is attached to
+    /// @note attach with CPU::setProfiler() - a CPU without a profiler pays a single predictable branch per
+    ///       instruction. Cycles spent responding to interrupts are counted separately from any PC.
+    ///
+    ///       Cycles are also attributed to call paths, with a shadow call stack pushed by CALL + interrupts and
+    ///       popped by RET. Frames are matched by stack pointer rather than return address, so code that
+    ///       rewrites its return address (XTHL), jumps with PUSH + RET, or resets SP (SPHL, LXI SP) leaves the
+    ///       shadow stack in step - any frame the stack pointer has moved above is discarded.
+    class Profiler {
+    public:
+        Profiler();
+
+        // clear every count
+        void reset();
+
+        // record an instruction at pc that took cycles clock cycles
+        void record(uint16_t pc, uint8_t opcode, uint8_t cycles);
+
+        // record a call to address - sp is the stack pointer before the return address is pushed
+        void recordCall(uint16_t address, uint16_t sp);
+
+        // record a return - sp is the stack pointer after the return address is popped
+        void recordReturn(uint16_t sp);
+
+        // record an interrupt to vector address that took cycles clock cycles - sp as for recordCall()
+        void recordInterrupt(uint16_t address, uint16_t sp, uint8_t cycles);
+
+        uint64_t getNumInstructions() const;
+        uint64_t getNumCycles() const;
+        uint64_t getNumInterrupts() const;
+
+        uint64_t getOpcodeCount(uint8_t opcode) const;
+        uint64_t getOpcodeCycles(uint8_t opcode) const;
+
+        uint64_t getCount(uint16_t pc) const;
+        uint64_t getCycles(uint16_t pc) const;
+
+        // print the opcode histogram, the numHotspots addresses with the most cycles disassembled from memory,
+        // and the numHotspots subroutines with the most cycles including the subroutines they call
+        void print(memory::IMemory* memory, size_t numHotspots) const;
+
+        // write cycles per call path in folded stack format (i.e. for flamegraph.pl), one line per path:
+        // "main;0x0a5f;0x1618 12345"
+        bool writeFoldedStacks(const char* filename) const;
+
+    private:
+        // one node per distinct call path, with the cycles spent in the subroutine itself
+        struct CallNode {
+            uint32_t parent;
+            uint16_t address;
+            bool isInterrupt;
+
+            uint64_t numCalls;
+            uint64_t cycles;
+        };
+
+        // subroutine on the shadow call stack, and the stack pointer that returning from it restores
+        struct CallFrame {
+            uint32_t node;
+            uint16_t returnSp;
+        };
+
+        void pushFrame(uint16_t address, bool isInterrupt, uint16_t sp);
+        void popFrames(uint16_t sp);
+        uint32_t getChild(uint32_t parent, uint16_t address, bool isInterrupt);
+        uint32_t getCurrentNode() const;
+        std::string getName(uint32_t node) const;
+
+        uint64_t numInstructions;
+        uint64_t numCycles;
+        uint64_t numInterrupts;
+        uint64_t numInterruptCycles;
+
+        uint64_t opcodeCounts[256];
+        uint64_t opcodeCycles[256];
+
+        // one entry per address
+        std::vector<uint64_t> counts;
+        std::vector<uint64_t> cycles;
+
+        // node 0 is the root, for code outside any tracked call
+        std::vector<CallNode> callNodes;
+        std::unordered_map<uint64_t, uint32_t> callNodeIndices;
+        std::vector<CallFrame> callStack;
+    };
+
+}
@@ -10,6 +10,28 @@ namespace cpu {
 	{
 	}
 
+	State::State(const State& other) :
+		hl(h, l), de(d, e), bc(b, c)
+	{
+		*this = other;
+	}
+
+	State& State::operator=(const State& other) {
+		a = other.a;
+		b = other.b;
+		c = other.c;
+		d = other.d;
+		e = other.e;
+		h = other.h;
+		l = other.l;
+		sp = other.sp;
+		pc = other.pc;
+		cc.all = other.cc.all;
+		interruptsEnabled = other.interruptsEnabled;
+
+		return *this;
+	}
+
 	void State::reset() {
 		cc.reset();
 
@@ -9,6 +9,10 @@ namespace cpu {
     struct State {
         State();
 
+        // copy register values (hl, de + bc continue to reference this instance's registers)
+        State(const State& other);
+        State& operator=(const State& other);
+
         void reset();
 
         Register16 hl;
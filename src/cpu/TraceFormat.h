@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cpu {
+
+    /// @struct TraceRegisters
+    /// @brief Registers of a traced CPU, after an instruction or interrupt
+    struct TraceRegisters {
+        uint8_t a;
+        uint8_t b;
+        uint8_t c;
+        uint8_t d;
+        uint8_t e;
+        uint8_t h;
+        uint8_t l;
+        uint8_t flags;
+        uint16_t sp;
+        uint16_t pc;
+        bool interruptsEnabled;
+    };
+
+    // File Format (all values little-endian)
+    //  - u32 magic 'SITR'
+    //  - u16 version
+    //  - blocks, until the end of the file:
+    //      - u32 size of records in bytes, u32 number of records
+    //      - u64 number of steps + u64 number of interrupts before the first record
+    //      - registers before the first record: u8 a, b, c, d, e, h, l, flags, u16 sp, u16 pc, u8 interruptsEnabled
+    //      - records, each decoded against the registers left by the record before it:
+    //          - u8 flags (trace::kFlag...)
+    //          - interrupts: u8 interrupt number, with bit 7 set if it was taken
+    //            instructions: the opcode + its operands (CPU::getOpcodeSize() bytes)
+    //          - kFlagPc: u16 pc after the record, when it is not the next instruction
+    //          - kFlagWrites: u8 count, then u16 address + u8 value for each memory write, in order
+    //          - kFlagIn: u8 port, u8 value read by IN
+    //          - kFlagOut: u8 port, u8 value written by OUT
+    //          - kFlagRegisters: u8 mask of changed 8-bit registers (bit per trace::kRegister...), then the new
+    //            value of each one, in order
+    //          - kFlagSp: u16 sp after the record
+    //          - kFlagInterruptsEnabled: no data - interrupts were enabled or disabled by the record
+    namespace trace {
+        const uint32_t kMagic = 0x52544953;
+        const uint16_t kVersion = 1;
+
+        const uint8_t kFlagInterrupt = (1 << 0);
+        const uint8_t kFlagPc = (1 << 1);
+        const uint8_t kFlagWrites = (1 << 2);
+        const uint8_t kFlagIn = (1 << 3);
+        const uint8_t kFlagOut = (1 << 4);
+        const uint8_t kFlagRegisters = (1 << 5);
+        const uint8_t kFlagSp = (1 << 6);
+        const uint8_t kFlagInterruptsEnabled = (1 << 7);
+
+        const uint8_t kInterruptTaken = 0x80;
+
+        enum Register {
+            kRegisterA,
+            kRegisterB,
+            kRegisterC,
+            kRegisterD,
+            kRegisterE,
+            kRegisterH,
+            kRegisterL,
+            kRegisterFlags,
+            kNumRegisters
+        };
+
+        // most memory writes made by one instruction or interrupt (i.e. PUSH, CALL, XTHL, SHLD)
+        const size_t kMaxWrites = 4;
+
+        // largest encoded record
+        const size_t kMaxRecordSize = 64;
+    }
+}
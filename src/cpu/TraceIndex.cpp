@@ -0,0 +1,253 @@
+#include "cpu/TraceIndex.h"
+#include "cpu/TraceReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace cpu {
+	namespace {
+		const uint32_t kMagic = 0x58544953;	// 'SITX'
+		const uint32_t kVersion = 1;
+
+		// entries are grouped by key - memory addresses, then IN ports, then OUT ports
+		const size_t kKeyIn = 0x10000;
+		const size_t kKeyOut = kKeyIn + 0x100;
+		const size_t kNumKeys = kKeyOut + 0x100;
+
+		size_t align(size_t offset) {
+			return (offset + 7) & ~size_t(7);
+		}
+
+		// call visit(key, step, pc, value) for each write + port access in a trace, and frameStart(frame, step)
+		// with the first step of each frame
+		template <typename Visit, typename FrameStart>
+		bool readTrace(const char* traceFilename, Visit visit, FrameStart frameStart, uint64_t& outLastStep) {
+			TraceReader reader;
+			if (!reader.open(traceFilename)) {
+				return false;
+			}
+
+			TraceRecord record;
+			bool isFirst = true;
+			while (reader.next(record)) {
+				if (isFirst) {
+					frameStart(record.numInterrupts / 2, record.numSteps);
+					isFirst = false;
+				}
+
+				for (size_t i = 0; i < record.numWrites; i++) {
+					visit(size_t(record.writes[i].address), record.numSteps, record.pc, record.writes[i].value);
+				}
+				if (record.hasIn) {
+					visit(kKeyIn + record.inPort, record.numSteps, record.pc, record.inValue);
+				}
+				if (record.hasOut) {
+					visit(kKeyOut + record.outPort, record.numSteps, record.pc, record.outValue);
+				}
+
+				// a new frame starts with the instruction after every second interrupt
+				if (record.isInterrupt && (record.numInterrupts % 2 == 1)) {
+					frameStart((record.numInterrupts + 1) / 2, record.numSteps + 1);
+				}
+
+				outLastStep = record.numSteps;
+			}
+
+			return !isFirst;
+		}
+	}
+
+	// layout of the start of an index file - the sections follow it, each aligned to 8 bytes
+	struct TraceIndex::Header {
+		uint32_t magic;
+		uint32_t version;
+
+		uint64_t firstStep;
+		uint64_t lastStep;
+		uint64_t firstFrame;
+		uint64_t numFrames;
+		uint64_t numEntries;
+
+		// offsets from the start of the file
+		uint64_t offsetFrames;		// u64 first step of each frame, then the step after the last frame
+		uint64_t offsetKeys;		// u64 index of the first entry of each key, then numEntries
+		uint64_t offsetSteps;		// u64 step of each entry
+		uint64_t offsetPcs;			// u16 pc of each entry
+		uint64_t offsetValues;		// u8 value of each entry
+	};
+
+	size_t TraceIndex::Entries::find(uint64_t step) const {
+		return size_t(std::lower_bound(steps, steps + size, step) - steps);
+	}
+
+	TraceIndex::TraceIndex() :
+		header(nullptr)
+	{
+
+	}
+
+	bool TraceIndex::build(const char* traceFilename, const char* indexFilename) {
+		// count the entries of each key first, so the index can be written in place in a single mapping
+		std::vector<uint64_t> keys(kNumKeys + 1, 0);
+		std::vector<uint64_t> frames;
+		uint64_t firstFrame = 0;
+		uint64_t lastStep = 0;
+
+		const bool isCounted = readTrace(traceFilename, [&keys](size_t key, uint64_t, uint16_t, uint8_t) {
+			keys[key + 1]++;
+		}, [&frames, &firstFrame](uint64_t frame, uint64_t step) {
+			if (frames.empty()) {
+				firstFrame = frame;
+			}
+			frames.push_back(step);
+		}, lastStep);
+
+		if (!isCounted) {
+			printf("TraceIndex - no records in %s\n", traceFilename);
+			return false;
+		}
+
+		// the frame table ends with the step after the last one, unless the trace ended on a frame boundary
+		if (frames.back() <= lastStep) {
+			frames.push_back(lastStep + 1);
+		}
+
+		for (size_t i = 1; i <= kNumKeys; i++) {
+			keys[i] += keys[i - 1];
+		}
+		const uint64_t numEntries = keys[kNumKeys];
+
+		Header layout;
+		memset(&layout, 0, sizeof(layout));
+		layout.magic = kMagic;
+		layout.version = kVersion;
+		layout.firstStep = frames.front();
+		layout.lastStep = lastStep;
+		layout.firstFrame = firstFrame;
+		layout.numFrames = frames.size() - 1;
+		layout.numEntries = numEntries;
+		layout.offsetFrames = align(sizeof(Header));
+		layout.offsetKeys = align(layout.offsetFrames + frames.size() * sizeof(uint64_t));
+		layout.offsetSteps = align(layout.offsetKeys + keys.size() * sizeof(uint64_t));
+		layout.offsetPcs = align(layout.offsetSteps + numEntries * sizeof(uint64_t));
+		layout.offsetValues = align(layout.offsetPcs + numEntries * sizeof(uint16_t));
+		const size_t size = align(layout.offsetValues + numEntries);
+
+		util::MappedFile index;
+		if (!index.create(indexFilename, size)) {
+			return false;
+		}
+
+		uint8_t* data = index.data();
+		memcpy(data + layout.offsetFrames, frames.data(), frames.size() * sizeof(uint64_t));
+		memcpy(data + layout.offsetKeys, keys.data(), keys.size() * sizeof(uint64_t));
+
+		uint64_t* steps = reinterpret_cast<uint64_t*>(data + layout.offsetSteps);
+		uint16_t* pcs = reinterpret_cast<uint16_t*>(data + layout.offsetPcs);
+		uint8_t* values = data + layout.offsetValues;
+
+		// the trace is in step order, so filling each key in the order its entries are read keeps them sorted
+		std::vector<uint64_t> cursors(keys.begin(), keys.end() - 1);
+
+		const bool isWritten = readTrace(traceFilename, [&](size_t key, uint64_t step, uint16_t pc, uint8_t value) {
+			const uint64_t entry = cursors[key]++;
+			steps[entry] = step;
+			pcs[entry] = pc;
+			values[entry] = value;
+		}, [](uint64_t, uint64_t) {}, lastStep);
+
+		if (!isWritten) {
+			return false;
+		}
+
+		// the header is written last, so an index that was not completed is never opened
+		memcpy(data, &layout, sizeof(layout));
+
+		return true;
+	}
+
+	bool TraceIndex::open(const char* indexFilename) {
+		close();
+
+		if (!file.open(indexFilename)) {
+			return false;
+		}
+
+		header = reinterpret_cast<const Header*>(file.data());
+		if ((file.size() < sizeof(Header)) || (header->magic != kMagic) || (header->version != kVersion)) {
+			printf("TraceIndex - %s is not a trace index (version %u)\n", indexFilename, kVersion);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void TraceIndex::close() {
+		file.close();
+		header = nullptr;
+	}
+
+	TraceIndex::Entries TraceIndex::getWrites(uint16_t address) const {
+		return getEntries(address);
+	}
+
+	TraceIndex::Entries TraceIndex::getIns(uint8_t port) const {
+		return getEntries(kKeyIn + port);
+	}
+
+	TraceIndex::Entries TraceIndex::getOuts(uint8_t port) const {
+		return getEntries(kKeyOut + port);
+	}
+
+	uint64_t TraceIndex::getFirstStep() const {
+		return header->firstStep;
+	}
+
+	uint64_t TraceIndex::getLastStep() const {
+		return header->lastStep;
+	}
+
+	uint64_t TraceIndex::getFirstFrame() const {
+		return header->firstFrame;
+	}
+
+	uint64_t TraceIndex::getLastFrame() const {
+		return header->firstFrame + header->numFrames - 1;
+	}
+
+	uint64_t TraceIndex::getFrameStep(uint64_t frame) const {
+		const uint64_t* frames = reinterpret_cast<const uint64_t*>(file.data() + header->offsetFrames);
+
+		if (frame < header->firstFrame) {
+			return frames[0];
+		}
+
+		return frames[std::min(frame - header->firstFrame, header->numFrames)];
+	}
+
+	uint64_t TraceIndex::getFrame(uint64_t step) const {
+		const uint64_t* frames = reinterpret_cast<const uint64_t*>(file.data() + header->offsetFrames);
+		const uint64_t* end = frames + header->numFrames;
+
+		// the last frame whose first step is at or before step
+		const uint64_t* frame = std::upper_bound(frames, end, step);
+
+		return header->firstFrame + ((frame == frames) ? 0 : uint64_t(frame - frames - 1));
+	}
+
+	TraceIndex::Entries TraceIndex::getEntries(size_t key) const {
+		const uint8_t* data = file.data();
+		const uint64_t* keys = reinterpret_cast<const uint64_t*>(data + header->offsetKeys);
+
+		Entries entries;
+		entries.steps = reinterpret_cast<const uint64_t*>(data + header->offsetSteps) + keys[key];
+		entries.pcs = reinterpret_cast<const uint16_t*>(data + header->offsetPcs) + keys[key];
+		entries.values = data + header->offsetValues + keys[key];
+		entries.size = size_t(keys[key + 1] - keys[key]);
+
+		return entries;
+	}
+}
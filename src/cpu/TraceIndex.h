@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/MappedFile.h"
+
+namespace cpu {
+
+    /// @class TraceIndex
+    /// @brief Index of the memory writes + port I/O in a trace written by TraceRecorder, by address and port
+    /// @note build() decodes the trace once, and writes every memory write, IN and OUT to an index file, grouped
+    ///       by address or port and sorted by step. open() maps the index file rather than loading it, so a
+    ///       query only touches the pages it reads - finding the writes to one address in a range of steps is a
+    ///       binary search, however long the trace is.
+    ///
+    ///       Steps are CPU::getNumSteps() after the instruction that made the write. Writes made by an interrupt
+    ///       (pushing PC) have the step of the instruction before it, and the PC that was interrupted.
+    class TraceIndex {
+    public:
+        /// @struct Entries
+        /// @brief Writes to one address (or port), in step order
+        struct Entries {
+            const uint64_t* steps;
+            const uint16_t* pcs;
+            const uint8_t* values;
+            size_t size;
+
+            // index of the first entry at or after step
+            size_t find(uint64_t step) const;
+        };
+
+        TraceIndex();
+
+        // decode traceFilename and write an index of it to indexFilename
+        static bool build(const char* traceFilename, const char* indexFilename);
+
+        bool open(const char* indexFilename);
+        void close();
+
+        // memory writes to address, values read from a port by IN, and values written to a port by OUT
+        Entries getWrites(uint16_t address) const;
+        Entries getIns(uint8_t port) const;
+        Entries getOuts(uint8_t port) const;
+
+        // first + last step in the trace
+        uint64_t getFirstStep() const;
+        uint64_t getLastStep() const;
+
+        // first + last frame in the trace (Machine::getNumFrames())
+        uint64_t getFirstFrame() const;
+        uint64_t getLastFrame() const;
+
+        // step of the first instruction in frame, clamped to the frames in the trace - the frame after the last
+        // one starts after the last step
+        uint64_t getFrameStep(uint64_t frame) const;
+
+        // frame that step was executed in
+        uint64_t getFrame(uint64_t step) const;
+
+    private:
+        struct Header;
+
+        Entries getEntries(size_t key) const;
+
+        util::MappedFile file;
+        const Header* header;
+    };
+}
@@ -0,0 +1,277 @@
+#include "cpu/TraceReader.h"
+#include "cpu/CPU.h"
+#include "util/BinaryStream.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace cpu {
+	namespace {
+		uint16_t get16(const uint8_t* data) {
+			return uint16_t(data[0] | (data[1] << 8));
+		}
+
+		bool readBlockHeader(std::istream& stream, uint32_t& outSize, uint32_t& outNumRecords, uint64_t& outNumSteps, uint64_t& outNumInterrupts, TraceRegisters& outRegisters) {
+			uint8_t registerBytes[8];
+			uint8_t interruptsEnabled = 0;
+
+			const bool isRead = util::readU32(stream, outSize) && util::readU32(stream, outNumRecords) &&
+				util::readU64(stream, outNumSteps) && util::readU64(stream, outNumInterrupts) &&
+				util::readBytes(stream, registerBytes, sizeof(registerBytes)) &&
+				util::readU16(stream, outRegisters.sp) && util::readU16(stream, outRegisters.pc) &&
+				util::readU8(stream, interruptsEnabled);
+
+			outRegisters.a = registerBytes[trace::kRegisterA];
+			outRegisters.b = registerBytes[trace::kRegisterB];
+			outRegisters.c = registerBytes[trace::kRegisterC];
+			outRegisters.d = registerBytes[trace::kRegisterD];
+			outRegisters.e = registerBytes[trace::kRegisterE];
+			outRegisters.h = registerBytes[trace::kRegisterH];
+			outRegisters.l = registerBytes[trace::kRegisterL];
+			outRegisters.flags = registerBytes[trace::kRegisterFlags];
+			outRegisters.interruptsEnabled = (interruptsEnabled != 0);
+
+			return isRead;
+		}
+	}
+
+	TraceReader::TraceReader() :
+		offset(0),
+		numRecordsLeft(0),
+		registers(),
+		numSteps(0),
+		numInterrupts(0)
+	{
+
+	}
+
+	bool TraceReader::open(const char* filename) {
+		close();
+
+		file.open(filename, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			printf("TraceReader - unable to open %s\n", filename);
+			return false;
+		}
+
+		uint32_t magic = 0;
+		uint16_t version = 0;
+		if (!util::readU32(file, magic) || !util::readU16(file, version) || (magic != trace::kMagic) || (version != trace::kVersion)) {
+			printf("TraceReader - %s is not a trace (version %u)\n", filename, trace::kVersion);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void TraceReader::close() {
+		file.close();
+		file.clear();
+
+		block.clear();
+		offset = 0;
+		numRecordsLeft = 0;
+	}
+
+	bool TraceReader::next(TraceRecord& outRecord) {
+		while (numRecordsLeft == 0) {
+			if (!readBlock()) {
+				return false;
+			}
+		}
+
+		const uint8_t* flags = take(1);
+		if (!flags) {
+			return false;
+		}
+
+		outRecord.isInterrupt = (*flags & trace::kFlagInterrupt) != 0;
+		outRecord.interruptNum = 0;
+		outRecord.isInterruptTaken = false;
+		outRecord.pc = registers.pc;
+		outRecord.size = 0;
+		memset(outRecord.bytes, 0, sizeof(outRecord.bytes));
+		outRecord.numWrites = 0;
+		outRecord.hasIn = false;
+		outRecord.hasOut = false;
+
+		uint16_t pc = registers.pc;
+
+		if (outRecord.isInterrupt) {
+			const uint8_t* interrupt = take(1);
+			if (!interrupt) {
+				return false;
+			}
+
+			outRecord.interruptNum = *interrupt & ~trace::kInterruptTaken;
+			outRecord.isInterruptTaken = (*interrupt & trace::kInterruptTaken) != 0;
+			outRecord.numInterrupts = numInterrupts++;
+		}
+		else {
+			const uint8_t* opcode = take(1);
+			if (!opcode) {
+				return false;
+			}
+
+			outRecord.size = CPU::getOpcodeSize(*opcode);
+			outRecord.bytes[0] = *opcode;
+
+			const uint8_t* operands = take(outRecord.size - 1);
+			if (!operands) {
+				return false;
+			}
+
+			memcpy(outRecord.bytes + 1, operands, outRecord.size - 1);
+			outRecord.numInterrupts = numInterrupts;
+
+			pc = uint16_t(pc + outRecord.size);
+			numSteps++;
+		}
+
+		outRecord.numSteps = numSteps;
+
+		if (*flags & trace::kFlagPc) {
+			const uint8_t* data = take(2);
+			if (!data) {
+				return false;
+			}
+			pc = get16(data);
+		}
+
+		if (*flags & trace::kFlagWrites) {
+			const uint8_t* count = take(1);
+			if (!count || (*count > trace::kMaxWrites)) {
+				printf("TraceReader - corrupt record at step %llu\n", (unsigned long long)numSteps);
+				return false;
+			}
+
+			const uint8_t* data = take(*count * 3);
+			if (!data) {
+				return false;
+			}
+
+			outRecord.numWrites = *count;
+			for (size_t i = 0; i < outRecord.numWrites; i++) {
+				outRecord.writes[i].address = get16(data + i * 3);
+				outRecord.writes[i].value = data[i * 3 + 2];
+			}
+		}
+
+		if (*flags & trace::kFlagIn) {
+			const uint8_t* data = take(2);
+			if (!data) {
+				return false;
+			}
+			outRecord.hasIn = true;
+			outRecord.inPort = data[0];
+			outRecord.inValue = data[1];
+		}
+
+		if (*flags & trace::kFlagOut) {
+			const uint8_t* data = take(2);
+			if (!data) {
+				return false;
+			}
+			outRecord.hasOut = true;
+			outRecord.outPort = data[0];
+			outRecord.outValue = data[1];
+		}
+
+		registers.pc = pc;
+
+		if (*flags & trace::kFlagRegisters) {
+			const uint8_t* mask = take(1);
+			if (!mask) {
+				return false;
+			}
+
+			uint8_t* registerBytes[] = { &registers.a, &registers.b, &registers.c, &registers.d, &registers.e, &registers.h, &registers.l, &registers.flags };
+			for (int i = 0; i < trace::kNumRegisters; i++) {
+				if (*mask & (1 << i)) {
+					const uint8_t* value = take(1);
+					if (!value) {
+						return false;
+					}
+					*registerBytes[i] = *value;
+				}
+			}
+		}
+
+		if (*flags & trace::kFlagSp) {
+			const uint8_t* data = take(2);
+			if (!data) {
+				return false;
+			}
+			registers.sp = get16(data);
+		}
+
+		if (*flags & trace::kFlagInterruptsEnabled) {
+			registers.interruptsEnabled = !registers.interruptsEnabled;
+		}
+
+		outRecord.registers = registers;
+		numRecordsLeft--;
+
+		return true;
+	}
+
+	bool TraceReader::skipTo(uint64_t inNumSteps) {
+		// decode the rest of the current block first
+		if (numRecordsLeft > 0) {
+			return true;
+		}
+
+		for (;;) {
+			const std::streampos position = file.tellg();
+
+			uint32_t size = 0;
+			uint32_t numRecords = 0;
+			uint64_t blockNumSteps = 0;
+			uint64_t blockNumInterrupts = 0;
+			TraceRegisters blockRegisters;
+			if (!readBlockHeader(file, size, numRecords, blockNumSteps, blockNumInterrupts, blockRegisters)) {
+				return false;
+			}
+
+			// every record is at most one step, so the block can be skipped if this is still short of numSteps
+			if (blockNumSteps + numRecords >= inNumSteps) {
+				file.seekg(position);
+				return bool(file);
+			}
+
+			file.seekg(size, std::ios::cur);
+		}
+	}
+
+	bool TraceReader::readBlock() {
+		uint32_t size = 0;
+		uint32_t numRecords = 0;
+		if (!readBlockHeader(file, size, numRecords, numSteps, numInterrupts, registers)) {
+			return false;
+		}
+
+		block.resize(size);
+		if (!util::readBytes(file, block.data(), size)) {
+			printf("TraceReader - trace ends part way through a block\n");
+			return false;
+		}
+
+		offset = 0;
+		numRecordsLeft = numRecords;
+
+		return true;
+	}
+
+	const uint8_t* TraceReader::take(size_t size) {
+		if (offset + size > block.size()) {
+			printf("TraceReader - corrupt record at step %llu\n", (unsigned long long)numSteps);
+			return nullptr;
+		}
+
+		const uint8_t* data = block.data() + offset;
+		offset += size;
+
+		return data;
+	}
+}
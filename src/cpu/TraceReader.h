@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "cpu/TraceFormat.h"
+
+namespace cpu {
+
+    /// @struct TraceRecord
+    /// @brief One instruction or interrupt decoded from a trace
+    struct TraceRecord {
+        bool isInterrupt;
+        uint8_t interruptNum;
+        bool isInterruptTaken;
+
+        // CPU::getNumSteps() after the record, and interrupts before it (frame is numInterrupts / 2)
+        uint64_t numSteps;
+        uint64_t numInterrupts;
+
+        // address of the instruction, or PC when the interrupt happened
+        uint16_t pc;
+
+        // opcode + operands of an instruction
+        uint8_t bytes[3];
+        uint8_t size;
+
+        // registers after the record
+        TraceRegisters registers;
+
+        struct Write {
+            uint16_t address;
+            uint8_t value;
+        };
+
+        Write writes[trace::kMaxWrites];
+        size_t numWrites;
+
+        bool hasIn;
+        uint8_t inPort;
+        uint8_t inValue;
+
+        bool hasOut;
+        uint8_t outPort;
+        uint8_t outValue;
+    };
+
+    /// @class TraceReader
+    /// @brief Decode a trace written by TraceRecorder, one record at a time
+    /// @note only one block is held in memory, so traces of any length can be read
+    class TraceReader {
+    public:
+        TraceReader();
+
+        bool open(const char* filename);
+        void close();
+
+        // decode the next record - returns false at the end of the trace, or if it is corrupt
+        bool next(TraceRecord& outRecord);
+
+        // skip whole blocks that end before step numSteps, without decoding them
+        bool skipTo(uint64_t numSteps);
+
+    private:
+        bool readBlock();
+
+        // pointer to the next size bytes of the block, or nullptr if the block is too short
+        const uint8_t* take(size_t size);
+
+        std::ifstream file;
+
+        std::vector<uint8_t> block;
+        size_t offset;
+        uint32_t numRecordsLeft;
+
+        // registers after the last record
+        TraceRegisters registers;
+        uint64_t numSteps;
+        uint64_t numInterrupts;
+    };
+}
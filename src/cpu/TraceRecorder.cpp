@@ -0,0 +1,367 @@
+#include "cpu/TraceRecorder.h"
+#include "cpu/CPU.h"
+#include "util/BinaryStream.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace cpu {
+	namespace {
+		uint8_t* put16(uint8_t* out, uint16_t value) {
+			out[0] = uint8_t(value & 0xff);
+			out[1] = uint8_t(value >> 8);
+			return out + 2;
+		}
+	}
+
+	TraceRecorder::Config::Config() :
+		bufferSize(64 * 1024 * 1024),
+		blockSize(64 * 1024)
+	{
+
+	}
+
+	TraceRecorder::TraceRecorder() :
+		numBlocks(0),
+		firstBlock(0),
+		numUsedBlocks(0),
+		registers(),
+		numSteps(0),
+		numInterrupts(0),
+		numWrites(0),
+		hasIn(false),
+		hasOut(false),
+		numRecords(0),
+		numBytes(0),
+		numDiscardedBlocks(0)
+	{
+
+	}
+
+	TraceRecorder::~TraceRecorder() {
+		close();
+	}
+
+	bool TraceRecorder::init(const Config& inConfig) {
+		config = inConfig;
+
+		if (config.blockSize < 2 * trace::kMaxRecordSize) {
+			printf("TraceRecorder - block size %zu is too small (at least %zu bytes)\n", config.blockSize, 2 * trace::kMaxRecordSize);
+			return false;
+		}
+
+		numBlocks = (config.bufferSize > config.blockSize) ? (config.bufferSize / config.blockSize) : 1;
+		buffer.assign(numBlocks * config.blockSize, 0);
+		headers.assign(numBlocks, BlockHeader());
+
+		start(State(), 0, 0);
+
+		return true;
+	}
+
+	void TraceRecorder::start(const State& state, uint64_t inNumSteps, uint64_t inNumInterrupts) {
+		registers = getTraceRegisters(state);
+		numSteps = inNumSteps;
+		numInterrupts = inNumInterrupts;
+
+		numWrites = 0;
+		hasIn = false;
+		hasOut = false;
+
+		numRecords = 0;
+		numBytes = 0;
+		numDiscardedBlocks = 0;
+
+		firstBlock = 0;
+		numUsedBlocks = 0;
+		startBlock();
+	}
+
+	bool TraceRecorder::open(const char* filename) {
+		close();
+
+		file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			printf("TraceRecorder - unable to open %s for writing\n", filename);
+			return false;
+		}
+
+		util::writeU32(file, trace::kMagic);
+		util::writeU16(file, trace::kVersion);
+
+		// records already in the ring buffer are discarded - the file starts from the current state
+		firstBlock = 0;
+		numUsedBlocks = 0;
+		startBlock();
+
+		return true;
+	}
+
+	bool TraceRecorder::close() {
+		if (!file.is_open()) {
+			return true;
+		}
+
+		writeBlock(file, getCurrentBlock());
+
+		const bool isGood = bool(file);
+		file.close();
+
+		firstBlock = 0;
+		numUsedBlocks = 0;
+		startBlock();
+
+		return isGood;
+	}
+
+	bool TraceRecorder::save(const char* filename) const {
+		if (file.is_open()) {
+			printf("TraceRecorder - records are being written to a file, not kept in the ring buffer\n");
+			return false;
+		}
+
+		std::ofstream stream;
+		stream.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			printf("TraceRecorder - unable to open %s for writing\n", filename);
+			return false;
+		}
+
+		util::writeU32(stream, trace::kMagic);
+		util::writeU16(stream, trace::kVersion);
+
+		for (size_t i = 0; i < numUsedBlocks; i++) {
+			writeBlock(stream, (firstBlock + i) % numBlocks);
+		}
+
+		return bool(stream);
+	}
+
+	uint64_t TraceRecorder::getNumRecords() const {
+		return numRecords;
+	}
+
+	uint64_t TraceRecorder::getNumBytes() const {
+		return numBytes;
+	}
+
+	uint64_t TraceRecorder::getNumDiscardedBlocks() const {
+		return numDiscardedBlocks;
+	}
+
+	void TraceRecorder::recordWrite(uint16_t address, uint8_t value) {
+		assert(numWrites < trace::kMaxWrites);
+
+		if (numWrites < trace::kMaxWrites) {
+			writes[numWrites].address = address;
+			writes[numWrites].value = value;
+			numWrites++;
+		}
+	}
+
+	void TraceRecorder::recordIn(uint8_t port, uint8_t value) {
+		hasIn = true;
+		ports[0] = port;
+		portValues[0] = value;
+	}
+
+	void TraceRecorder::recordOut(uint8_t port, uint8_t value) {
+		hasOut = true;
+		ports[1] = port;
+		portValues[1] = value;
+	}
+
+	void TraceRecorder::recordInstruction(uint16_t pc, const uint8_t bytes[3], const State& state) {
+		// the CPU state was changed outside of the trace (i.e. a snapshot was restored) - start() again
+		assert(pc == registers.pc);
+
+		uint8_t* begin = beginRecord();
+		uint8_t* out = begin + 1;
+		uint8_t flags = 0;
+
+		const uint8_t size = CPU::getOpcodeSize(bytes[0]);
+		memcpy(out, bytes, size);
+		out += size;
+
+		if (state.pc != uint16_t(pc + size)) {
+			flags |= trace::kFlagPc;
+			out = put16(out, state.pc);
+		}
+
+		out = encodeEffects(out, flags, state);
+		begin[0] = flags;
+
+		numSteps++;
+		endRecord(begin, out, state);
+	}
+
+	void TraceRecorder::recordInterrupt(uint8_t interruptNum, bool isTaken, const State& state) {
+		uint8_t* begin = beginRecord();
+		uint8_t* out = begin + 1;
+		uint8_t flags = trace::kFlagInterrupt;
+
+		*out++ = interruptNum | (isTaken ? trace::kInterruptTaken : 0);
+
+		if (state.pc != registers.pc) {
+			flags |= trace::kFlagPc;
+			out = put16(out, state.pc);
+		}
+
+		out = encodeEffects(out, flags, state);
+		begin[0] = flags;
+
+		numInterrupts++;
+		endRecord(begin, out, state);
+	}
+
+	uint8_t* TraceRecorder::beginRecord() {
+		size_t index = getCurrentBlock();
+
+		if (headers[index].size + trace::kMaxRecordSize > config.blockSize) {
+			if (file.is_open()) {
+				writeBlock(file, index);
+				firstBlock = 0;
+				numUsedBlocks = 0;
+			}
+
+			startBlock();
+			index = getCurrentBlock();
+		}
+
+		return buffer.data() + index * config.blockSize + headers[index].size;
+	}
+
+	void TraceRecorder::endRecord(const uint8_t* begin, const uint8_t* end, const State& state) {
+		const size_t size = size_t(end - begin);
+		assert(size <= trace::kMaxRecordSize);
+
+		BlockHeader& header = headers[getCurrentBlock()];
+		header.size += uint32_t(size);
+		header.numRecords += 1;
+
+		numRecords += 1;
+		numBytes += size;
+
+		registers = getTraceRegisters(state);
+
+		numWrites = 0;
+		hasIn = false;
+		hasOut = false;
+	}
+
+	uint8_t* TraceRecorder::encodeEffects(uint8_t* out, uint8_t& flags, const State& state) const {
+		if (numWrites > 0) {
+			flags |= trace::kFlagWrites;
+			*out++ = uint8_t(numWrites);
+
+			for (size_t i = 0; i < numWrites; i++) {
+				out = put16(out, writes[i].address);
+				*out++ = writes[i].value;
+			}
+		}
+
+		if (hasIn) {
+			flags |= trace::kFlagIn;
+			*out++ = ports[0];
+			*out++ = portValues[0];
+		}
+
+		if (hasOut) {
+			flags |= trace::kFlagOut;
+			*out++ = ports[1];
+			*out++ = portValues[1];
+		}
+
+		const TraceRegisters next = getTraceRegisters(state);
+		const uint8_t previousBytes[] = { registers.a, registers.b, registers.c, registers.d, registers.e, registers.h, registers.l, registers.flags };
+		const uint8_t nextBytes[] = { next.a, next.b, next.c, next.d, next.e, next.h, next.l, next.flags };
+
+		uint8_t mask = 0;
+		for (int i = 0; i < trace::kNumRegisters; i++) {
+			mask |= (previousBytes[i] != nextBytes[i]) ? (1 << i) : 0;
+		}
+
+		if (mask != 0) {
+			flags |= trace::kFlagRegisters;
+			*out++ = mask;
+
+			for (int i = 0; i < trace::kNumRegisters; i++) {
+				if (mask & (1 << i)) {
+					*out++ = nextBytes[i];
+				}
+			}
+		}
+
+		if (next.sp != registers.sp) {
+			flags |= trace::kFlagSp;
+			out = put16(out, next.sp);
+		}
+
+		if (next.interruptsEnabled != registers.interruptsEnabled) {
+			flags |= trace::kFlagInterruptsEnabled;
+		}
+
+		return out;
+	}
+
+	void TraceRecorder::startBlock() {
+		// the ring buffer is full, so discard the oldest block
+		if (numUsedBlocks == numBlocks) {
+			firstBlock = (firstBlock + 1) % numBlocks;
+			numUsedBlocks--;
+			numDiscardedBlocks++;
+		}
+
+		numUsedBlocks++;
+
+		BlockHeader& header = headers[getCurrentBlock()];
+		header.size = 0;
+		header.numRecords = 0;
+		header.numSteps = numSteps;
+		header.numInterrupts = numInterrupts;
+		header.registers = registers;
+	}
+
+	size_t TraceRecorder::getCurrentBlock() const {
+		return (firstBlock + numUsedBlocks - 1) % numBlocks;
+	}
+
+	void TraceRecorder::writeBlock(std::ostream& stream, size_t index) const {
+		const BlockHeader& header = headers[index];
+		if (header.numRecords == 0) {
+			return;
+		}
+
+		util::writeU32(stream, header.size);
+		util::writeU32(stream, header.numRecords);
+		util::writeU64(stream, header.numSteps);
+		util::writeU64(stream, header.numInterrupts);
+
+		const TraceRegisters& blockRegisters = header.registers;
+		const uint8_t registerBytes[] = { blockRegisters.a, blockRegisters.b, blockRegisters.c, blockRegisters.d, blockRegisters.e, blockRegisters.h, blockRegisters.l, blockRegisters.flags };
+		util::writeBytes(stream, registerBytes, sizeof(registerBytes));
+		util::writeU16(stream, blockRegisters.sp);
+		util::writeU16(stream, blockRegisters.pc);
+		util::writeU8(stream, blockRegisters.interruptsEnabled ? 1 : 0);
+
+		util::writeBytes(stream, buffer.data() + index * config.blockSize, header.size);
+	}
+
+	TraceRegisters getTraceRegisters(const State& state) {
+		TraceRegisters registers;
+		registers.a = state.a;
+		registers.b = state.b;
+		registers.c = state.c;
+		registers.d = state.d;
+		registers.e = state.e;
+		registers.h = state.h;
+		registers.l = state.l;
+		registers.flags = uint8_t(state.cc.all & 0x1f);
+		registers.sp = state.sp;
+		registers.pc = state.pc;
+		registers.interruptsEnabled = state.interruptsEnabled;
+
+		return registers;
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "cpu/State.h"
+#include "cpu/TraceFormat.h"
+
+namespace cpu {
+
+    /// @class TraceRecorder
+    /// @brief Record every instruction executed by the CPU it is attached to - PC, opcode, registers, memory
+    ///        writes + port I/O - in a packed binary format
+    /// @note attach with CPU::setTracer() - a CPU without a recorder pays a single predictable branch per
+    ///       instruction. Records are delta encoded against the previous record (only registers that changed,
+    ///       and PC only after a jump), around 5 bytes per instruction.
+    ///
+    ///       Records are held in fixed size blocks, each starting with the complete register state, so any block
+    ///       can be decoded on its own. By default the blocks form a ring buffer, where the oldest block is
+    ///       discarded to make room - save() writes the blocks that remain. After open(), each block is written to
+    ///       a file as soon as it is full instead, for runs of any length. Read traces back with TraceReader.
+    class TraceRecorder {
+    public:
+        /// @struct Config
+        /// @brief Size of the ring buffer, and of each block in it
+        struct Config {
+            Config();
+
+            size_t bufferSize;
+            size_t blockSize;
+        };
+
+        TraceRecorder();
+        ~TraceRecorder();
+
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        // allocate the ring buffer
+        bool init(const Config& config);
+
+        // discard every record and start recording from state - numSteps + numInterrupts number the records
+        // (i.e. CPU::getNumSteps() and Machine::getNumInterrupts())
+        void start(const State& state, uint64_t numSteps, uint64_t numInterrupts);
+
+        // write each block to filename as it fills, rather than keeping them in the ring buffer
+        bool open(const char* filename);
+
+        // write the block in progress to the file opened with open(), and close it
+        bool close();
+
+        // write the records held in the ring buffer to filename, oldest first
+        bool save(const char* filename) const;
+
+        // number of records + encoded bytes since start(), including any that have been discarded
+        uint64_t getNumRecords() const;
+        uint64_t getNumBytes() const;
+
+        // number of blocks discarded from the ring buffer to make room for new records
+        uint64_t getNumDiscardedBlocks() const;
+
+    public: // called by CPU
+        // memory writes + port I/O are attached to the instruction or interrupt that follows them
+        void recordWrite(uint16_t address, uint8_t value);
+        void recordIn(uint8_t port, uint8_t value);
+        void recordOut(uint8_t port, uint8_t value);
+
+        // record the instruction at pc (opcode + operands in bytes), leaving the CPU in state
+        void recordInstruction(uint16_t pc, const uint8_t bytes[3], const State& state);
+
+        // record an interrupt - one that was not taken (interrupts disabled) leaves state unchanged
+        void recordInterrupt(uint8_t interruptNum, bool isTaken, const State& state);
+
+    private:
+        struct BlockHeader {
+            uint32_t size;
+            uint32_t numRecords;
+            uint64_t numSteps;
+            uint64_t numInterrupts;
+            TraceRegisters registers;
+        };
+
+        struct Write {
+            uint16_t address;
+            uint8_t value;
+        };
+
+        // return space for a record, starting a new block if the current one is full
+        uint8_t* beginRecord();
+        void endRecord(const uint8_t* begin, const uint8_t* end, const State& state);
+
+        // encode the writes, port I/O + registers shared by instructions + interrupts
+        uint8_t* encodeEffects(uint8_t* out, uint8_t& flags, const State& state) const;
+
+        void startBlock();
+        size_t getCurrentBlock() const;
+        void writeBlock(std::ostream& stream, size_t index) const;
+
+        Config config;
+
+        std::vector<uint8_t> buffer;
+        std::vector<BlockHeader> headers;
+        size_t numBlocks;
+        size_t firstBlock;
+        size_t numUsedBlocks;
+
+        // registers after the last record
+        TraceRegisters registers;
+        uint64_t numSteps;
+        uint64_t numInterrupts;
+
+        Write writes[trace::kMaxWrites];
+        size_t numWrites;
+        bool hasIn;
+        bool hasOut;
+        uint8_t ports[2];
+        uint8_t portValues[2];
+
+        uint64_t numRecords;
+        uint64_t numBytes;
+        uint64_t numDiscardedBlocks;
+
+        std::ofstream file;
+    };
+
+    // registers of state, as recorded in a trace
+    TraceRegisters getTraceRegisters(const State& state);
+}
@@ -0,0 +1,599 @@
+#include "machine/GdbStub.h"
+#include "machine/Machine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace machine {
+	namespace {
+		// longest wait for a client, or for data from it, before checking for shutdown
+		const uint32_t kPollMilliseconds = 100;
+
+		// longest memory read or write in one packet, and the packet size told to the client
+		const size_t kMaxMemoryPacket = 0x800;
+		const char* kSupported = "PacketSize=1000";
+
+		// signals reported when the machine stops
+		const uint8_t kSignalInterrupt = 2;
+		const uint8_t kSignalTrap = 5;
+
+		// af bc de hl sp pc ix iy af' bc' de' hl' ir
+		const uint32_t kNumRegisters = 13;
+		const uint32_t kRegisterAF = 0;
+		const uint32_t kRegisterBC = 1;
+		const uint32_t kRegisterDE = 2;
+		const uint32_t kRegisterHL = 3;
+		const uint32_t kRegisterSP = 4;
+		const uint32_t kRegisterPC = 5;
+
+		const char kHexDigits[] = "0123456789abcdef";
+
+		void appendHex8(std::string& text, uint8_t value) {
+			text += kHexDigits[value >> 4];
+			text += kHexDigits[value & 0xf];
+		}
+
+		// registers are sent in target (little endian) byte order
+		void appendHex16(std::string& text, uint16_t value) {
+			appendHex8(text, uint8_t(value & 0xff));
+			appendHex8(text, uint8_t(value >> 8));
+		}
+
+		int getHexDigit(char c) {
+			if ((c >= '0') && (c <= '9')) {
+				return c - '0';
+			}
+			if ((c >= 'a') && (c <= 'f')) {
+				return c - 'a' + 10;
+			}
+			if ((c >= 'A') && (c <= 'F')) {
+				return c - 'A' + 10;
+			}
+			return -1;
+		}
+
+		bool parseHex8(const char* text, uint8_t& outValue) {
+			const int high = getHexDigit(text[0]);
+			const int low = (high >= 0) ? getHexDigit(text[1]) : -1;
+			outValue = uint8_t((high << 4) | low);
+			return (low >= 0);
+		}
+
+		uint16_t parseHex16(const char* text) {
+			uint8_t low = 0;
+			uint8_t high = 0;
+			parseHex8(text, low);
+			parseHex8(text + 2, high);
+			return uint16_t(low | (high << 8));
+		}
+
+		// hex number, followed by one of separators (or the end of the packet) - text is moved past both
+		bool parseNumber(const char*& text, const char* separators, uint32_t& outValue) {
+			char* end = nullptr;
+			const unsigned long value = strtoul(text, &end, 16);
+			if ((end == text) || (*end && !strchr(separators, *end))) {
+				return false;
+			}
+
+			outValue = uint32_t(value);
+			text = *end ? (end + 1) : end;
+			return true;
+		}
+
+		// F as the 8080 pushes it with PUSH PSW - S Z 0 AC 0 P 1 CY
+		uint8_t getFlags(const cpu::ConditionCodes& cc) {
+			return uint8_t((cc.s << 7) | (cc.z << 6) | (cc.ac << 4) | (cc.p << 2) | (1 << 1) | cc.cy);
+		}
+
+		void setFlags(cpu::ConditionCodes& cc, uint8_t flags) {
+			cc.s = (flags >> 7) & 1;
+			cc.z = (flags >> 6) & 1;
+			cc.ac = (flags >> 4) & 1;
+			cc.p = (flags >> 2) & 1;
+			cc.cy = flags & 1;
+		}
+
+		uint16_t getRegister(const cpu::State& state, uint32_t reg) {
+			switch (reg) {
+			case kRegisterAF: return uint16_t((state.a << 8) | getFlags(state.cc));
+			case kRegisterBC: return uint16_t((state.b << 8) | state.c);
+			case kRegisterDE: return uint16_t((state.d << 8) | state.e);
+			case kRegisterHL: return uint16_t((state.h << 8) | state.l);
+			case kRegisterSP: return state.sp;
+			case kRegisterPC: return state.pc;
+			default: return 0;
+			}
+		}
+
+		// registers the 8080 does not have are ignored
+		void setRegister(cpu::State& state, uint32_t reg, uint16_t value) {
+			const uint8_t high = uint8_t(value >> 8);
+			const uint8_t low = uint8_t(value & 0xff);
+
+			switch (reg) {
+			case kRegisterAF: state.a = high; setFlags(state.cc, low); break;
+			case kRegisterBC: state.b = high; state.c = low; break;
+			case kRegisterDE: state.d = high; state.e = low; break;
+			case kRegisterHL: state.h = high; state.l = low; break;
+			case kRegisterSP: state.sp = value; break;
+			case kRegisterPC: state.pc = value; break;
+			default: break;
+			}
+		}
+
+		// Z / z packet type to the CPU breakpoints that implement it
+		size_t getBreakpointTypes(uint32_t type, cpu::Breakpoint::Type outTypes[2]) {
+			switch (type) {
+			case 0:
+			case 1:
+				outTypes[0] = cpu::Breakpoint::Type::Opcode;
+				return 1;
+			case 2:
+				outTypes[0] = cpu::Breakpoint::Type::MemoryWrite;
+				return 1;
+			case 3:
+				outTypes[0] = cpu::Breakpoint::Type::MemoryRead;
+				return 1;
+			case 4:
+				outTypes[0] = cpu::Breakpoint::Type::MemoryWrite;
+				outTypes[1] = cpu::Breakpoint::Type::MemoryRead;
+				return 2;
+			default:
+				return 0;
+			}
+		}
+	}
+
+	GdbStub::GdbStub() :
+		isShutdown(false),
+		isConnectionOpen(false),
+		isInterruptRequested(false),
+		framing(Framing::Idle),
+		isAttached(false),
+		isRunning(false),
+		isKilled(false),
+		isWatchHit(false),
+		watchType(cpu::Breakpoint::Type::MemoryWrite),
+		watchAddress(0)
+	{
+
+	}
+
+	GdbStub::~GdbStub() {
+		shutdown();
+	}
+
+	bool GdbStub::start(uint16_t port) {
+		shutdown();
+
+		if (!listener.listen(port)) {
+			return false;
+		}
+
+		isShutdown = false;
+		isKilled = false;
+		thread = std::thread([this]() {
+			serve();
+		});
+
+		return true;
+	}
+
+	void GdbStub::shutdown() {
+		isShutdown = true;
+		requestCondition.notify_all();
+
+		if (thread.joinable()) {
+			thread.join();
+		}
+
+		std::lock_guard<std::mutex> lock(connectionMutex);
+		connection.close();
+		listener.close();
+		isConnectionOpen = false;
+	}
+
+	bool GdbStub::isConnected() const {
+		return isConnectionOpen;
+	}
+
+	void GdbStub::serve() {
+		uint8_t buffer[4096];
+
+		while (!isShutdown) {
+			{
+				// nothing is sent while there is no client, so holding the lock while waiting for one costs nothing
+				std::lock_guard<std::mutex> lock(connectionMutex);
+				if (!listener.accept(connection, kPollMilliseconds)) {
+					continue;
+				}
+				isConnectionOpen = true;
+			}
+
+			framing = Framing::Idle;
+
+			while (!isShutdown) {
+				const int numReceived = connection.receive(buffer, sizeof(buffer), kPollMilliseconds);
+				if (numReceived < 0) {
+					break;
+				}
+
+				receive(buffer, size_t(numReceived));
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(connectionMutex);
+				connection.close();
+				isConnectionOpen = false;
+			}
+
+			// tell update() the client has gone, so it can detach from the machine
+			std::lock_guard<std::mutex> lock(requestMutex);
+			requests.push_back(std::string());
+			requestCondition.notify_all();
+		}
+	}
+
+	void GdbStub::receive(const uint8_t* data, size_t size) {
+		for (size_t i = 0; i < size; i++) {
+			const char c = char(data[i]);
+
+			switch (framing) {
+			case Framing::Idle:
+				if (c == '$') {
+					payload.clear();
+					framing = Framing::Payload;
+				}
+				else if (c == 0x03) {
+					// ^C - interrupt the running machine
+					isInterruptRequested = true;
+					requestCondition.notify_all();
+				}
+				// acknowledgements (+ / -) from the client are ignored, as packets are never resent
+				break;
+			case Framing::Payload:
+				if (c == '#') {
+					checksum.clear();
+					framing = Framing::Checksum;
+				}
+				else {
+					payload += c;
+				}
+				break;
+			case Framing::Checksum:
+			{
+				checksum += c;
+				if (checksum.size() < 2) {
+					break;
+				}
+
+				framing = Framing::Idle;
+
+				uint8_t expected = 0;
+				uint8_t sum = 0;
+				for (char p : payload) {
+					sum = uint8_t(sum + uint8_t(p));
+				}
+
+				if (!parseHex8(checksum.c_str(), expected) || (expected != sum)) {
+					sendRaw("-");
+					break;
+				}
+				sendRaw("+");
+
+				// binary data escapes '#', '$', '}' + '*' as '}' followed by the byte xor 0x20
+				std::string packet;
+				for (size_t j = 0; j < payload.size(); j++) {
+					packet += ((payload[j] == '}') && (j + 1 < payload.size())) ? char(payload[++j] ^ 0x20) : payload[j];
+				}
+
+				std::lock_guard<std::mutex> lock(requestMutex);
+				requests.push_back(packet);
+				requestCondition.notify_all();
+				break;
+			}
+			}
+		}
+	}
+
+	void GdbStub::sendRaw(const std::string& data) {
+		std::lock_guard<std::mutex> lock(connectionMutex);
+		connection.send(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+	}
+
+	bool GdbStub::update(Machine& machine, uint32_t timeoutMilliseconds) {
+		std::deque<std::string> packets;
+		{
+			std::unique_lock<std::mutex> lock(requestMutex);
+			if (requests.empty() && !isRunning) {
+				requestCondition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [this]() {
+					return !requests.empty() || isShutdown;
+				});
+			}
+			packets.swap(requests);
+		}
+
+		for (const std::string& packet : packets) {
+			if (packet.empty()) {
+				detach(machine);
+				continue;
+			}
+
+			attach(machine);
+			execute(machine, packet);
+		}
+
+		if (isRunning) {
+			if (isInterruptRequested.exchange(false)) {
+				isRunning = false;
+				sendStop(kSignalInterrupt);
+			}
+			else if (!machine.runFrame()) {
+				// stopped by a breakpoint
+				isRunning = false;
+				sendStop(kSignalTrap);
+			}
+		}
+
+		return !isKilled;
+	}
+
+	void GdbStub::attach(Machine& machine) {
+		if (isAttached) {
+			return;
+		}
+
+		isAttached = true;
+		isRunning = false;
+		isInterruptRequested = false;
+
+		// the client's breakpoints stop the machine, and are reported to it rather than to the host
+		cpu::CPU& cpu = machine.getCPU();
+		previousCallback = cpu.getCallbackBreakpoint();
+		cpu.setCallbackBreakpoint([this, &machine](const cpu::Breakpoint& breakpoint, uint16_t value) {
+			(void)value;
+
+			isWatchHit = (breakpoint.type == cpu::Breakpoint::Type::MemoryWrite) || (breakpoint.type == cpu::Breakpoint::Type::MemoryRead);
+			watchType = breakpoint.type;
+			watchAddress = breakpoint.address;
+
+			machine.stop();
+		});
+	}
+
+	void GdbStub::detach(Machine& machine) {
+		if (!isAttached) {
+			return;
+		}
+
+		cpu::CPU& cpu = machine.getCPU();
+		for (const cpu::Breakpoint& breakpoint : breakpoints) {
+			cpu.removeBreakpoint(breakpoint);
+		}
+		breakpoints.clear();
+
+		cpu.setCallbackBreakpoint(previousCallback);
+		previousCallback = nullptr;
+
+		isAttached = false;
+		isRunning = false;
+	}
+
+	void GdbStub::sendPacket(const std::string& text) {
+		std::string packet = "$";
+		uint8_t sum = 0;
+
+		for (char c : text) {
+			if ((c == '#') || (c == '$') || (c == '}') || (c == '*')) {
+				packet += '}';
+				sum = uint8_t(sum + uint8_t('}'));
+				c = char(c ^ 0x20);
+			}
+
+			packet += c;
+			sum = uint8_t(sum + uint8_t(c));
+		}
+
+		packet += '#';
+		appendHex8(packet, sum);
+
+		sendRaw(packet);
+	}
+
+	void GdbStub::sendStop(uint8_t signal) {
+		std::string reply = "T";
+		appendHex8(reply, signal);
+
+		if ((signal == kSignalTrap) && isWatchHit) {
+			char watch[16];
+			snprintf(watch, sizeof(watch), "%s:%x;", (watchType == cpu::Breakpoint::Type::MemoryWrite) ? "watch" : "rwatch", watchAddress);
+			reply += watch;
+		}
+
+		isWatchHit = false;
+		sendPacket(reply);
+	}
+
+	void GdbStub::execute(Machine& machine, const std::string& packet) {
+		cpu::CPU& cpu = machine.getCPU();
+		memory::Memory& memory = machine.getMemory();
+		const char* arguments = packet.c_str() + 1;
+
+		std::string reply;
+
+		switch (packet[0]) {
+		case '?':
+			reply = "S05";
+			break;
+		case 'g':
+			for (uint32_t reg = 0; reg < kNumRegisters; reg++) {
+				appendHex16(reply, getRegister(cpu.getState(), reg));
+			}
+			break;
+		case 'G':
+		{
+			cpu::State state = cpu.getState();
+			for (uint32_t reg = 0; (reg < kNumRegisters) && (strlen(arguments) >= (reg + 1) * 4); reg++) {
+				setRegister(state, reg, parseHex16(arguments + reg * 4));
+			}
+			cpu.setState(state);
+			reply = "OK";
+			break;
+		}
+		case 'p':
+		{
+			uint32_t reg = 0;
+			if (!parseNumber(arguments, "", reg) || (reg >= kNumRegisters)) {
+				reply = "E01";
+				break;
+			}
+			appendHex16(reply, getRegister(cpu.getState(), reg));
+			break;
+		}
+		case 'P':
+		{
+			uint32_t reg = 0;
+			if (!parseNumber(arguments, "=", reg) || (reg >= kNumRegisters) || (strlen(arguments) < 4)) {
+				reply = "E01";
+				break;
+			}
+			cpu::State state = cpu.getState();
+			setRegister(state, reg, parseHex16(arguments));
+			cpu.setState(state);
+			reply = "OK";
+			break;
+		}
+		case 'm':
+		{
+			uint32_t address = 0;
+			uint32_t length = 0;
+			if (!parseNumber(arguments, ",", address) || !parseNumber(arguments, "", length) || (length > kMaxMemoryPacket)) {
+				reply = "E01";
+				break;
+			}
+			for (uint32_t i = 0; i < length; i++) {
+				appendHex8(reply, memory.read(memory.translate(uint16_t(address + i))));
+			}
+			break;
+		}
+		case 'M':
+		{
+			uint32_t address = 0;
+			uint32_t length = 0;
+			if (!parseNumber(arguments, ",", address) || !parseNumber(arguments, ":", length) || (strlen(arguments) < length * 2)) {
+				reply = "E01";
+				break;
+			}
+
+			// ROM can not be written
+			const uint16_t sizeRom = uint16_t(memory.size() - memory.sizeRam());
+			bool isWritable = true;
+			for (uint32_t i = 0; i < length; i++) {
+				isWritable = isWritable && (memory.translate(uint16_t(address + i)) >= sizeRom);
+			}
+			if (!isWritable) {
+				reply = "E0e";
+				break;
+			}
+
+			for (uint32_t i = 0; i < length; i++) {
+				uint8_t value = 0;
+				parseHex8(arguments + i * 2, value);
+				memory.write(memory.translate(uint16_t(address + i)), value);
+			}
+			reply = "OK";
+			break;
+		}
+		case 'c':
+		case 's':
+		{
+			// optional address to resume from
+			uint32_t address = 0;
+			if (*arguments && parseNumber(arguments, "", address)) {
+				cpu::State state = cpu.getState();
+				state.pc = uint16_t(address);
+				cpu.setState(state);
+			}
+
+			if (packet[0] == 'c') {
+				// the reply is sent when the machine stops
+				isInterruptRequested = false;
+				isRunning = true;
+				return;
+			}
+
+			machine.step();
+			sendStop(kSignalTrap);
+			return;
+		}
+		case 'Z':
+		case 'z':
+		{
+			uint32_t type = 0;
+			uint32_t address = 0;
+			uint32_t length = 0;
+			cpu::Breakpoint::Type types[2];
+			const size_t numTypes = (parseNumber(arguments, ",", type) && parseNumber(arguments, ",", address) && parseNumber(arguments, ";", length)) ?
+				getBreakpointTypes(type, types) : 0;
+
+			if (numTypes == 0) {
+				// unsupported type - an empty reply tells the client to manage the breakpoint itself
+				break;
+			}
+
+			// a breakpoint covers one address, a watchpoint every byte it watches - ranges past 0xFFFF can't be watched
+			const uint32_t endAddress = ((type <= 1) || (length == 0)) ? address : (address + length - 1);
+			if ((endAddress > 0xffff) || (endAddress < address)) {
+				reply = "E01";
+				break;
+			}
+
+			for (size_t i = 0; i < numTypes; i++) {
+				const cpu::Breakpoint breakpoint(types[i], uint16_t(address), uint16_t(endAddress));
+
+				if (packet[0] == 'Z') {
+					cpu.addBreakpoint(breakpoint);
+					breakpoints.push_back(breakpoint);
+					continue;
+				}
+
+				cpu.removeBreakpoint(breakpoint);
+				for (auto it = breakpoints.begin(); it != breakpoints.end(); it++) {
+					if ((it->type == breakpoint.type) && (it->address == breakpoint.address) && (it->endAddress == breakpoint.endAddress)) {
+						breakpoints.erase(it);
+						break;
+					}
+				}
+			}
+			reply = "OK";
+			break;
+		}
+		case 'H':
+			reply = "OK";
+			break;
+		case 'D':
+			sendPacket("OK");
+			detach(machine);
+			return;
+		case 'k':
+			detach(machine);
+			isKilled = true;
+			return;
+		case 'q':
+			if (packet.compare(0, 10, "qSupported") == 0) {
+				reply = kSupported;
+			}
+			else if (packet == "qAttached") {
+				reply = "1";
+			}
+			break;
+		default:
+			// anything else is not supported - an empty reply says so
+			break;
+		}
+
+		sendPacket(reply);
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu/Breakpoint.h"
+#include "cpu/CPU.h"
+#include "util/Socket.h"
+
+namespace machine {
+
+	class Machine;
+
+	/// @class GdbStub
+	/// @brief Debug a machine from GDB, or any other client of the GDB remote serial protocol, over a loopback socket
+	/// @note the socket is served on a thread of its own, which frames packets, acknowledges them + sends
+	///       replies. Packets are only executed by update(), on the thread that runs the machine, so the machine
+	///       is only ever touched between instructions - a machine with no client connected runs as fast as ever.
+	///
+	///       Registers are reported in GDB's z80 layout (af bc de hl sp pc ix iy af' bc' de' hl' ir, 16 bits each)
+	///       - the 8080 registers are a subset of the z80's, so "set architecture z80" in GDB shows them. Flags
+	///       are packed into F as the 8080 pushes them (S Z 0 AC 0 P 1 CY). Breakpoints (Z0 / Z1) and write,
+	///       read + access watchpoints (Z2 / Z3 / Z4) are CPU breakpoints, added while the client is attached.
+	class GdbStub {
+	public:
+		GdbStub();
+		~GdbStub();
+
+		GdbStub(const GdbStub&) = delete;
+		GdbStub& operator=(const GdbStub&) = delete;
+
+		// listen for a client on 127.0.0.1:port, serving it from a new thread
+		bool start(uint16_t port);
+
+		// disconnect the client + stop the thread
+		void shutdown();
+
+		// execute the client's packets - while the client has the machine running (continue), run it for up to a
+		// frame, otherwise wait up to timeoutMilliseconds for a packet. Returns false once the client has killed
+		// the target
+		bool update(Machine& machine, uint32_t timeoutMilliseconds);
+
+		bool isConnected() const;
+
+	private:
+		// socket thread
+		void serve();
+		void receive(const uint8_t* data, size_t size);
+		void sendRaw(const std::string& data);
+
+		// machine thread
+		void execute(Machine& machine, const std::string& packet);
+		void attach(Machine& machine);
+		void detach(Machine& machine);
+		void sendPacket(const std::string& payload);
+		void sendStop(uint8_t signal);
+
+		util::Socket listener;
+		util::Socket connection;
+		std::thread thread;
+
+		std::atomic<bool> isShutdown;
+		std::atomic<bool> isConnectionOpen;
+
+		// set by ^C from the client while the machine is running
+		std::atomic<bool> isInterruptRequested;
+
+		// held while the connection is opened, closed or sent to
+		std::mutex connectionMutex;
+
+		// packets received, waiting for update() - an empty packet means the client has disconnected
+		std::mutex requestMutex;
+		std::condition_variable requestCondition;
+		std::deque<std::string> requests;
+
+		// framing of the packet being received (socket thread only)
+		enum class Framing {
+			Idle,
+			Payload,
+			Checksum
+		};
+
+		Framing framing;
+		std::string payload;
+		std::string checksum;
+
+		// state of the session (machine thread only)
+		bool isAttached;
+		bool isRunning;
+		bool isKilled;
+		cpu::CPU::CallbackBreakpoint previousCallback;
+		std::vector<cpu::Breakpoint> breakpoints;
+
+		// watchpoint that stopped the machine, reported in the stop reply
+		bool isWatchHit;
+		cpu::Breakpoint::Type watchType;
+		uint16_t watchAddress;
+	};
+}
@@ -0,0 +1,337 @@
+#include "machine/Machine.h"
+#include "util/Utils.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace machine {
+	Machine::Machine() :
+		shiftRegister(0), shiftRegisterResultOffset(0),
+		interruptNum(1), numInterrupts(0),
+		nextInterruptCycle(kCyclesPerHalfFrame), frameStartCycle(0),
+		isStopRequested(false)
+	{
+		memset(inputPorts, 0, sizeof(inputPorts));
+
+		cpu.setCallbackIn([this](uint8_t port) -> uint8_t {
+			return in(port);
+		});
+
+		cpu.setCallbackOut([this](uint8_t port, uint8_t value) -> void {
+			out(port, value);
+		});
+	}
+
+	bool Machine::init(const char* romFilename) {
+		configureMemory(uint16_t(util::getFileSize(romFilename)));
+		if (!memory.load(romFilename)) {
+			return false;
+		}
+
+		uint16_t pcStart = 0;
+		cpu.init(&memory, pcStart);
+
+		return true;
+	}
+
+	bool Machine::init(const uint8_t* rom, uint16_t sizeRom) {
+		configureMemory(sizeRom);
+		if (!memory.load(rom, sizeRom)) {
+			return false;
+		}
+
+		uint16_t pcStart = 0;
+		cpu.init(&memory, pcStart);
+
+		return true;
+	}
+
+	void Machine::configureMemory(uint16_t sizeRom) {
+		memory::Memory::Config config;
+		config.sizeRam = Snapshot::kSizeRam;
+		config.sizeRom = sizeRom;
+		config.isRomWriteable = false;
+		config.isRamMirrored = true;
+
+		memory.configure(config);
+	}
+
+	void Machine::step() {
+		cpu.step();
+
+		if (cpu.getNumCycles() >= nextInterruptCycle) {
+			interrupt();
+		}
+	}
+
+	bool Machine::runFrame() {
+		isStopRequested = false;
+
+		const uint64_t numFrames = getNumFrames();
+
+		while ((getNumFrames() == numFrames) && !isStopRequested) {
+			step();
+		}
+
+		return (getNumFrames() != numFrames);
+	}
+
+	void Machine::stop() {
+		isStopRequested = true;
+	}
+
+	bool Machine::stepOver(uint64_t maxFrames) {
+		const cpu::State& state = cpu.getState();
+		const uint8_t opcode = memory.read(memory.translate(state.pc));
+
+		if (!cpu::CPU::isCallOpcode(opcode)) {
+			step();
+			return true;
+		}
+
+		// a conditional CALL that is not taken reaches the next instruction straight away
+		return runTo(uint16_t(state.pc + cpu::CPU::getOpcodeSize(opcode)), state.sp, maxFrames);
+	}
+
+	bool Machine::stepOut(uint64_t maxFrames) {
+		isStopRequested = false;
+
+		// the function returns with the RET that leaves SP above where it is now - RETs of the functions it
+		// calls (and of interrupt handlers) only restore SP to where it was before their CALL
+		const uint16_t sp = cpu.getState().sp;
+		const uint64_t endFrame = getNumFrames() + maxFrames;
+
+		while (!isStopRequested && (getNumFrames() < endFrame)) {
+			const bool isReturn = cpu::CPU::isReturnOpcode(memory.read(memory.translate(cpu.getState().pc)));
+
+			step();
+
+			if (isReturn && (cpu.getState().sp > sp)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool Machine::runTo(uint16_t address, uint16_t minSp, uint64_t maxFrames) {
+		isStopRequested = false;
+
+		const cpu::State& state = cpu.getState();
+		const uint64_t endFrame = getNumFrames() + maxFrames;
+
+		do {
+			step();
+
+			if ((state.pc == address) && (state.sp >= minSp)) {
+				return true;
+			}
+		} while (!isStopRequested && (getNumFrames() < endFrame));
+
+		return false;
+	}
+
+	bool Machine::runFrames(uint64_t numFrames) {
+		for (uint64_t i = 0; i < numFrames; i++) {
+			if (!runFrame()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void Machine::setCallbackFrame(CallbackFrame callback) {
+		callbackFrame = callback;
+	}
+
+	Machine::CallbackFrame Machine::getCallbackFrame() const {
+		return callbackFrame;
+	}
+
+	void Machine::interrupt() {
+		// interruptNum 1 => simulate vsync when beam is near the middle of the screen
+		// interruptNum 2 => simulate vsync when beam is near the bottom of the screen
+		const bool isFrameComplete = (interruptNum == 2);
+
+		cpu.interrupt(interruptNum);
+
+		interruptNum = (interruptNum == 1) ? 2 : 1;
+		numInterrupts += 1;
+		nextInterruptCycle += kCyclesPerHalfFrame;
+
+		if (isFrameComplete) {
+			frameStartCycle = cpu.getNumCycles();
+
+			if (callbackFrame) {
+				callbackFrame();
+			}
+		}
+	}
+
+	void Machine::setInputPort(uint8_t port, uint8_t value) {
+		assert(port < kNumInputPorts);
+		inputPorts[port] = value;
+	}
+
+	uint8_t Machine::getInputPort(uint8_t port) const {
+		assert(port < kNumInputPorts);
+		return inputPorts[port];
+	}
+
+	bool Machine::isFrameStart() const {
+		return (cpu.getNumCycles() == frameStartCycle);
+	}
+
+	void Machine::snapshot(Snapshot& outSnapshot) const {
+		assert(memory.sizeRam() == Snapshot::kSizeRam);
+
+		outSnapshot.state = cpu.getState();
+		outSnapshot.numSteps = cpu.getNumSteps();
+		outSnapshot.numCycles = cpu.getNumCycles();
+
+		memory.getRam(outSnapshot.ram);
+
+		outSnapshot.shiftRegister = shiftRegister;
+		outSnapshot.shiftRegisterResultOffset = shiftRegisterResultOffset;
+
+		memcpy(outSnapshot.inputPorts, inputPorts, sizeof(inputPorts));
+
+		outSnapshot.interruptNum = uint8_t(interruptNum);
+		outSnapshot.numInterrupts = numInterrupts;
+		outSnapshot.nextInterruptCycle = nextInterruptCycle;
+		outSnapshot.frameStartCycle = frameStartCycle;
+	}
+
+	void Machine::restore(const Snapshot& snapshot) {
+		assert(memory.sizeRam() == Snapshot::kSizeRam);
+
+		cpu.setState(snapshot.state);
+		cpu.setNumSteps(snapshot.numSteps);
+		cpu.setNumCycles(snapshot.numCycles);
+
+		memory.setRam(snapshot.ram);
+
+		shiftRegister = snapshot.shiftRegister;
+		shiftRegisterResultOffset = snapshot.shiftRegisterResultOffset;
+
+		memcpy(inputPorts, snapshot.inputPorts, sizeof(inputPorts));
+
+		interruptNum = snapshot.interruptNum;
+		numInterrupts = snapshot.numInterrupts;
+		nextInterruptCycle = snapshot.nextInterruptCycle;
+		frameStartCycle = snapshot.frameStartCycle;
+	}
+
+	void Machine::fork(Machine& outMachine) const {
+		assert(&outMachine != this);
+
+		outMachine.memory.fork(memory);
+
+		outMachine.cpu.init(&outMachine.memory, 0);
+		outMachine.cpu.setState(cpu.getState());
+		outMachine.cpu.setNumSteps(cpu.getNumSteps());
+		outMachine.cpu.setNumCycles(cpu.getNumCycles());
+
+		outMachine.shiftRegister = shiftRegister;
+		outMachine.shiftRegisterResultOffset = shiftRegisterResultOffset;
+
+		memcpy(outMachine.inputPorts, inputPorts, sizeof(inputPorts));
+
+		outMachine.interruptNum = interruptNum;
+		outMachine.numInterrupts = numInterrupts;
+		outMachine.nextInterruptCycle = nextInterruptCycle;
+		outMachine.frameStartCycle = frameStartCycle;
+		outMachine.isStopRequested = false;
+	}
+
+	uint64_t Machine::hashRam() const {
+		uint8_t ram[Snapshot::kSizeRam];
+		memory.getRam(ram);
+
+		return util::hash(ram, sizeof(ram));
+	}
+
+	uint64_t Machine::hashState() const {
+		const cpu::State& state = cpu.getState();
+		const uint32_t cyclesToInterrupt = uint32_t(nextInterruptCycle - cpu.getNumCycles());
+
+		const uint8_t registers[] = {
+			state.a, state.b, state.c, state.d, state.e, state.h, state.l,
+			uint8_t(state.sp), uint8_t(state.sp >> 8),
+			uint8_t(state.pc), uint8_t(state.pc >> 8),
+			uint8_t(state.cc.all & 0x1f),
+			uint8_t(state.interruptsEnabled ? 1 : 0),
+			uint8_t(shiftRegister), uint8_t(shiftRegister >> 8), shiftRegisterResultOffset,
+			inputPorts[0], inputPorts[1], inputPorts[2],
+			uint8_t(interruptNum),
+			uint8_t(cyclesToInterrupt), uint8_t(cyclesToInterrupt >> 8), uint8_t(cyclesToInterrupt >> 16), uint8_t(cyclesToInterrupt >> 24)
+		};
+
+		return memory.getHash() ^ util::mix(util::hash(registers, sizeof(registers)));
+	}
+
+	uint64_t Machine::getNumInterrupts() const {
+		return numInterrupts;
+	}
+
+	uint64_t Machine::getNumFrames() const {
+		return numInterrupts / 2;
+	}
+
+	cpu::CPU& Machine::getCPU() {
+		return cpu;
+	}
+
+	const cpu::CPU& Machine::getCPU() const {
+		return cpu;
+	}
+
+	memory::Memory& Machine::getMemory() {
+		return memory;
+	}
+
+	const memory::Memory& Machine::getMemory() const {
+		return memory;
+	}
+
+	uint8_t Machine::in(uint8_t port) const {
+		uint8_t a = 0;
+
+		switch (port) {
+		case 0:
+		case 1:
+		case 2:
+			a = inputPorts[port];
+			break;
+		case 3:
+			// read from shift register
+			{
+				uint8_t shiftAmount = 8 - shiftRegisterResultOffset;
+				uint16_t shiftedResult = shiftRegister >> shiftAmount;
+				a = uint8_t(shiftedResult & 0xff);
+			}
+			break;
+		default:
+			break;
+		}
+
+		return a;
+	}
+
+	void Machine::out(uint8_t port, uint8_t value) {
+		switch (port) {
+		case 2:
+			// 3 bit shift register offset
+			shiftRegisterResultOffset = value & 0x7;
+			break;
+		case 4:
+			// push to high byte of shift register
+			shiftRegister >>= 8;
+			shiftRegister |= (uint16_t(value) << 8);
+			break;
+		default:
+			break;
+		}
+	}
+}
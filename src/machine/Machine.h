@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "cpu/CPU.h"
+#include "memory/Memory.h"
+#include "machine/Snapshot.h"
+
+namespace machine {
+
+	/// @class Machine
+	/// @brief Taito Space Invaders machine hardware - 8080 CPU, memory map, shift register + input ports
+	/// @note has no dependency on the host UI, so it can be run headless.
+	///       Interrupts are triggered by the number of emulated clock cycles, so the machine is
+	///       deterministic - the same inputs at the start of each frame always produce the same result.
+	class Machine {
+	public:
+		Machine();
+
+		// CPU callbacks reference this instance, so it can not be copied - use snapshot() + restore() instead
+		Machine(const Machine&) = delete;
+		Machine& operator=(const Machine&) = delete;
+
+		// 8080 clock rate, and number of clock cycles between vhalf/vblank interrupts (120 per second)
+		static const uint32_t kClockRate = 2000000;
+		static const uint32_t kCyclesPerHalfFrame = kClockRate / 120;
+
+		// initialise machine with Space Invaders ROM loaded from romFilename
+		bool init(const char* romFilename);
+
+		// initialise machine with Space Invaders ROM supplied in memory (i.e. shared by a batch of machines)
+		bool init(const uint8_t* rom, uint16_t sizeRom);
+
+		// step through a single instruction, triggering vhalf/vblank interrupts when they are due
+		void step();
+
+		// step through instructions until the end of the current frame, or until stop() is called
+		// - returns true if the frame was completed
+		bool runFrame();
+
+		// stop runFrame() (or a debugger command) at the end of the current instruction (i.e. from a breakpoint callback)
+		void stop();
+
+		// debugger commands - each runs in the same loop as runFrame(), checking a single temporary breakpoint
+		// after every instruction. They stop at the temporary breakpoint, after maxFrames frames, or when
+		// stop() is called, and return true if the temporary breakpoint was reached
+
+		// step through an instruction, running a CALL or RST until it returns
+		bool stepOver(uint64_t maxFrames);
+
+		// run until the function at PC returns to its caller
+		bool stepOut(uint64_t maxFrames);
+
+		// run at least one instruction, until PC reaches address with SP at or above minSp - so a recursive
+		// call back to address does not stop it early
+		bool runTo(uint16_t address, uint16_t minSp, uint64_t maxFrames);
+
+		// run numFrames frames - returns true if they were all completed
+		bool runFrames(uint64_t numFrames);
+
+		// CallbackFrame - invoked at the end of each frame, immediately after the vblank interrupt
+		typedef std::function<void()> CallbackFrame;
+		void setCallbackFrame(CallbackFrame callback);
+		CallbackFrame getCallbackFrame() const;
+
+		// latch the value of input port 0, 1 or 2, which is returned by IN until it is latched again
+		// - for deterministic playback, only latch input ports when isFrameStart() is true
+		void setInputPort(uint8_t port, uint8_t value);
+		uint8_t getInputPort(uint8_t port) const;
+
+		// return true if no instructions have been stepped since the start of the current frame
+		bool isFrameStart() const;
+
+		// capture the complete state of the machine
+		void snapshot(Snapshot& outSnapshot) const;
+
+		// restore the complete state of the machine
+		void restore(const Snapshot& snapshot);
+
+		// make outMachine a copy of this machine, which can then run independently (i.e. to branch a search)
+		// - memory pages are shared copy-on-write, so only the pages either machine writes to are copied.
+		//   outMachine does not need to be initialised, and keeps its own callbacks + breakpoints
+		void fork(Machine& outMachine) const;
+
+		// hash the contents of RAM (including video RAM)
+		uint64_t hashRam() const;
+
+		// hash everything that determines how the machine runs from here - memory, registers, shift register,
+		// input ports + cycles to the next interrupt. O(1), as the memory hash is updated on every write, so it
+		// can be used to find duplicate states (i.e. in a search). Counters that only ever increase (steps,
+		// cycles, interrupts) are left out, so the same state reached by different paths has the same hash
+		uint64_t hashState() const;
+
+		// get the number of interrupts that have been triggered so far
+		uint64_t getNumInterrupts() const;
+
+		// get the number of frames that have been completed so far
+		uint64_t getNumFrames() const;
+
+		cpu::CPU& getCPU();
+		const cpu::CPU& getCPU() const;
+
+		memory::Memory& getMemory();
+		const memory::Memory& getMemory() const;
+
+	private:
+		void configureMemory(uint16_t sizeRom);
+		void interrupt();
+		uint8_t in(uint8_t port) const;
+		void out(uint8_t port, uint8_t value);
+
+		cpu::CPU cpu;
+		memory::Memory memory;
+
+		uint16_t shiftRegister;
+		uint8_t shiftRegisterResultOffset;
+
+		static const int kNumInputPorts = 3;
+		uint8_t inputPorts[kNumInputPorts];
+
+		int interruptNum;
+		uint64_t numInterrupts;
+		uint64_t nextInterruptCycle;
+		uint64_t frameStartCycle;
+
+		bool isStopRequested;
+
+		CallbackFrame callbackFrame;
+	};
+}
@@ -0,0 +1,187 @@
+#include "machine/Movie.h"
+#include "util/BinaryStream.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace machine {
+	namespace {
+		// File Format (all values little-endian)
+		//  - u32 magic 'SIMV'
+		//  - u16 version
+		//  - u8 hasSnapshot, followed by snapshot (see Snapshot.cpp) if non-zero
+		//  - varint numFrames
+		//  - input runs, until numFrames are covered: varint runLength, u8[3] inputPorts
+		//  - u64[numFrames] hashRam
+		const uint32_t kMagic = 0x564d4953;
+		const uint16_t kVersion = 1;
+
+		bool isSameInput(const Movie::Frame& a, const Movie::Frame& b) {
+			return (memcmp(a.inputPorts, b.inputPorts, sizeof(a.inputPorts)) == 0);
+		}
+	}
+
+	Movie::Movie() : hasSnapshot(false) {
+
+	}
+
+	void Movie::start(const Machine& machine) {
+		assert(machine.isFrameStart());
+
+		hasSnapshot = true;
+		machine.snapshot(snapshot);
+
+		frames.clear();
+	}
+
+	void Movie::record(const Machine& machine) {
+		Frame frame;
+		for (uint8_t port = 0; port < 3; port++) {
+			frame.inputPorts[port] = machine.getInputPort(port);
+		}
+		frame.hashRam = machine.hashRam();
+
+		frames.push_back(frame);
+	}
+
+	ReplayResult::ReplayResult() : numFrames(0), firstMismatchFrame(-1) {
+
+	}
+
+	bool saveMovie(const char* filename, const Movie& movie) {
+		std::ofstream file;
+		file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			printf("movie - unable to open %s for writing\n", filename);
+			return false;
+		}
+
+		util::writeU32(file, kMagic);
+		util::writeU16(file, kVersion);
+
+		util::writeU8(file, movie.hasSnapshot ? 1 : 0);
+		if (movie.hasSnapshot) {
+			writeSnapshot(file, movie.snapshot);
+		}
+
+		const size_t numFrames = movie.frames.size();
+		util::writeVarint(file, numFrames);
+
+		size_t i = 0;
+		while (i < numFrames) {
+			size_t runLength = 1;
+			while ((i + runLength < numFrames) && isSameInput(movie.frames[i], movie.frames[i + runLength])) {
+				runLength += 1;
+			}
+
+			util::writeVarint(file, runLength);
+			util::writeBytes(file, movie.frames[i].inputPorts, sizeof(movie.frames[i].inputPorts));
+
+			i += runLength;
+		}
+
+		for (const Movie::Frame& frame : movie.frames) {
+			util::writeU64(file, frame.hashRam);
+		}
+
+		return bool(file);
+	}
+
+	bool loadMovie(const char* filename, Movie& outMovie) {
+		std::ifstream file;
+		file.open(filename, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			printf("movie - unable to open %s for reading\n", filename);
+			return false;
+		}
+
+		uint32_t magic;
+		uint16_t version;
+		if (!util::readU32(file, magic) || (magic != kMagic)) {
+			printf("movie - unrecognised format\n");
+			return false;
+		}
+		if (!util::readU16(file, version) || (version != kVersion)) {
+			printf("movie - unsupported version\n");
+			return false;
+		}
+
+		uint8_t hasSnapshot;
+		if (!util::readU8(file, hasSnapshot)) {
+			printf("movie - truncated\n");
+			return false;
+		}
+
+		outMovie.hasSnapshot = (hasSnapshot != 0);
+		if (outMovie.hasSnapshot && !readSnapshot(file, outMovie.snapshot)) {
+			return false;
+		}
+
+		uint64_t numFrames;
+		if (!util::readVarint(file, numFrames)) {
+			printf("movie - truncated\n");
+			return false;
+		}
+
+		outMovie.frames.clear();
+		outMovie.frames.reserve(size_t(numFrames));
+
+		while (outMovie.frames.size() < numFrames) {
+			uint64_t runLength;
+			Movie::Frame frame;
+			frame.hashRam = 0;
+
+			if (!util::readVarint(file, runLength) || !util::readBytes(file, frame.inputPorts, sizeof(frame.inputPorts))) {
+				printf("movie - truncated\n");
+				return false;
+			}
+
+			if ((runLength == 0) || (outMovie.frames.size() + runLength > numFrames)) {
+				printf("movie - invalid input run\n");
+				return false;
+			}
+
+			outMovie.frames.insert(outMovie.frames.end(), size_t(runLength), frame);
+		}
+
+		for (Movie::Frame& frame : outMovie.frames) {
+			if (!util::readU64(file, frame.hashRam)) {
+				printf("movie - truncated\n");
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool replayMovie(Machine& machine, const Movie& movie, ReplayResult& outResult) {
+		outResult = ReplayResult();
+
+		if (movie.hasSnapshot) {
+			machine.restore(movie.snapshot);
+		}
+
+		assert(machine.isFrameStart());
+
+		for (const Movie::Frame& frame : movie.frames) {
+			for (uint8_t port = 0; port < 3; port++) {
+				machine.setInputPort(port, frame.inputPorts[port]);
+			}
+
+			if (!machine.runFrame()) {
+				// stopped by a breakpoint
+				break;
+			}
+
+			if ((outResult.firstMismatchFrame < 0) && (machine.hashRam() != frame.hashRam)) {
+				outResult.firstMismatchFrame = int64_t(outResult.numFrames);
+			}
+
+			outResult.numFrames += 1;
+		}
+
+		return (outResult.numFrames == movie.frames.size()) && (outResult.firstMismatchFrame < 0);
+	}
+}
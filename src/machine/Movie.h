@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "machine/Machine.h"
+#include "machine/Snapshot.h"
+
+namespace machine {
+
+	/// @struct Movie
+	/// @brief Input ports latched at the start of each frame, and a hash of RAM at the end of each frame
+	/// @note a movie starts either from power-on, or from an embedded snapshot
+	struct Movie {
+		Movie();
+
+		struct Frame {
+			uint8_t inputPorts[3];
+			uint64_t hashRam;
+		};
+
+		// start recording from the current state of machine (which must be at the start of a frame)
+		void start(const Machine& machine);
+
+		// record the frame that machine has just completed
+		void record(const Machine& machine);
+
+		bool hasSnapshot;
+		Snapshot snapshot;
+
+		std::vector<Frame> frames;
+	};
+
+	// save movie to a binary file
+	// - inputs are run-length encoded, as they rarely change between frames
+	bool saveMovie(const char* filename, const Movie& movie);
+
+	// load movie from a binary file
+	bool loadMovie(const char* filename, Movie& outMovie);
+
+	struct ReplayResult {
+		ReplayResult();
+
+		uint64_t numFrames;
+
+		// index of the first frame whose RAM hash did not match the recording, or -1
+		int64_t firstMismatchFrame;
+	};
+
+	// replay movie on machine, as fast as possible, verifying the RAM hash after each frame
+	// - for movies without a snapshot, machine must have just been initialised
+	// - returns true if every frame matched the recording
+	bool replayMovie(Machine& machine, const Movie& movie, ReplayResult& outResult);
+}
@@ -0,0 +1,165 @@
+#include "machine/Rewind.h"
+#include "util/Delta.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace machine {
+	namespace {
+		float microsecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	Rewind::Config::Config() :
+		frameInterval(6),
+		maxBytes(4 * 1024 * 1024)
+	{
+
+	}
+
+	Rewind::Metrics::Metrics() :
+		numSnapshots(0), numBytes(0), numFrames(0),
+		recordMicroseconds(0.0f), rewindMicroseconds(0.0f)
+	{
+
+	}
+
+	Rewind::Entry::Entry() :
+		numSteps(0), numCycles(0),
+		shiftRegister(0), shiftRegisterResultOffset(0),
+		interruptNum(1), numInterrupts(0),
+		nextInterruptCycle(0), frameStartCycle(0)
+	{
+		memset(inputPorts, 0, sizeof(inputPorts));
+	}
+
+	Rewind::Rewind() : framesSinceRecord(0), numBytes(0) {
+		memset(latestRam, 0, sizeof(latestRam));
+	}
+
+	void Rewind::configure(const Config& inConfig) {
+		config = inConfig;
+
+		clear();
+	}
+
+	void Rewind::update(const Machine& machine) {
+		framesSinceRecord += 1;
+
+		if (framesSinceRecord >= config.frameInterval) {
+			record(machine);
+		}
+	}
+
+	void Rewind::record(const Machine& machine) {
+		auto start = std::chrono::steady_clock::now();
+
+		framesSinceRecord = 0;
+
+		machine.snapshot(scratch);
+
+		if (!entries.empty()) {
+			// previous entry no longer holds the full RAM image - replace it with a delta to this one
+			Entry& previous = entries.back();
+			numBytes -= sizeOfEntry(previous);
+			util::encodeXorDelta(scratch.ram, latestRam, Snapshot::kSizeRam, previous.delta);
+			previous.delta.shrink_to_fit();
+			numBytes += sizeOfEntry(previous);
+		}
+
+		entries.emplace_back();
+		Entry& entry = entries.back();
+		entry.state = scratch.state;
+		entry.numSteps = scratch.numSteps;
+		entry.numCycles = scratch.numCycles;
+		entry.shiftRegister = scratch.shiftRegister;
+		entry.shiftRegisterResultOffset = scratch.shiftRegisterResultOffset;
+		memcpy(entry.inputPorts, scratch.inputPorts, sizeof(entry.inputPorts));
+		entry.interruptNum = scratch.interruptNum;
+		entry.numInterrupts = scratch.numInterrupts;
+		entry.nextInterruptCycle = scratch.nextInterruptCycle;
+		entry.frameStartCycle = scratch.frameStartCycle;
+		machine.getCPU().saveBreakpointHits(entry.breakpointHits);
+		numBytes += sizeOfEntry(entry);
+
+		memcpy(latestRam, scratch.ram, Snapshot::kSizeRam);
+
+		// stay within budget, by discarding the oldest entries
+		while ((entries.size() > 1) && (numBytes + sizeof(latestRam) > config.maxBytes)) {
+			numBytes -= sizeOfEntry(entries.front());
+			entries.pop_front();
+		}
+
+		metrics.recordMicroseconds = microsecondsSince(start);
+		updateMetrics();
+	}
+
+	bool Rewind::rewind(Machine& machine) {
+		if (entries.empty()) {
+			return false;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		const Entry& entry = entries.back();
+		scratch.state = entry.state;
+		scratch.numSteps = entry.numSteps;
+		scratch.numCycles = entry.numCycles;
+		memcpy(scratch.ram, latestRam, Snapshot::kSizeRam);
+		scratch.shiftRegister = entry.shiftRegister;
+		scratch.shiftRegisterResultOffset = entry.shiftRegisterResultOffset;
+		memcpy(scratch.inputPorts, entry.inputPorts, sizeof(scratch.inputPorts));
+		scratch.interruptNum = entry.interruptNum;
+		scratch.numInterrupts = entry.numInterrupts;
+		scratch.nextInterruptCycle = entry.nextInterruptCycle;
+		scratch.frameStartCycle = entry.frameStartCycle;
+
+		machine.restore(scratch);
+		machine.getCPU().restoreBreakpointHits(entry.breakpointHits);
+
+		numBytes -= sizeOfEntry(entry);
+		entries.pop_back();
+
+		if (!entries.empty()) {
+			// reconstruct the full RAM image for the new most recent entry
+			Entry& previous = entries.back();
+			numBytes -= sizeOfEntry(previous);
+			bool isValid = util::applyXorDelta(latestRam, Snapshot::kSizeRam, previous.delta);
+			assert(isValid);
+			previous.delta.clear();
+			previous.delta.shrink_to_fit();
+			numBytes += sizeOfEntry(previous);
+		}
+
+		framesSinceRecord = 0;
+
+		metrics.rewindMicroseconds = microsecondsSince(start);
+		updateMetrics();
+
+		return true;
+	}
+
+	void Rewind::clear() {
+		entries.clear();
+		framesSinceRecord = 0;
+		numBytes = 0;
+
+		updateMetrics();
+	}
+
+	const Rewind::Metrics& Rewind::getMetrics() const {
+		return metrics;
+	}
+
+	size_t Rewind::sizeOfEntry(const Entry& entry) const {
+		return sizeof(Entry) + entry.delta.capacity() + (entry.breakpointHits.numHits.capacity() * sizeof(uint32_t));
+	}
+
+	void Rewind::updateMetrics() {
+		metrics.numSnapshots = entries.size();
+		metrics.numBytes = entries.empty() ? 0 : (numBytes + sizeof(latestRam));
+		metrics.numFrames = entries.empty() ? 0 : (entries.back().numInterrupts - entries.front().numInterrupts) / 2;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "machine/Machine.h"
+#include "machine/Snapshot.h"
+
+namespace machine {
+
+	/// @class Rewind
+	/// @brief Bounded history of machine snapshots, that can be stepped backwards through
+	/// @note only the most recent snapshot keeps a full RAM image - older snapshots store an
+	///       XOR/RLE delta to the RAM of the snapshot that followed them
+	class Rewind {
+	public:
+		Rewind();
+
+		struct Config {
+			Config();
+
+			// number of frames between each recorded snapshot
+			uint32_t frameInterval;
+
+			// maximum number of bytes used to store history - oldest snapshots are discarded first
+			size_t maxBytes;
+		};
+
+		// Configure rewind, and discard any recorded history
+		void configure(const Config& config);
+
+		// call once per emulated frame - records a snapshot every frameInterval frames
+		void update(const Machine& machine);
+
+		// record a snapshot of the machine
+		void record(const Machine& machine);
+
+		// restore the most recent snapshot, and remove it from history
+		// - returns false if there is no history
+		bool rewind(Machine& machine);
+
+		// discard all recorded history
+		void clear();
+
+		struct Metrics {
+			Metrics();
+
+			size_t numSnapshots;
+			size_t numBytes;
+
+			// number of frames that can be rewound
+			uint64_t numFrames;
+
+			// most recent cost of record() + rewind(), in microseconds
+			float recordMicroseconds;
+			float rewindMicroseconds;
+		};
+
+		const Metrics& getMetrics() const;
+
+	private:
+		struct Entry {
+			Entry();
+
+			cpu::State state;
+			uint64_t numSteps;
+			uint64_t numCycles;
+			uint16_t shiftRegister;
+			uint8_t shiftRegisterResultOffset;
+			uint8_t inputPorts[3];
+			uint8_t interruptNum;
+			uint64_t numInterrupts;
+			uint64_t nextInterruptCycle;
+			uint64_t frameStartCycle;
+
+			// hit counts at the time of the snapshot, so rewinding doesn't count hits from the discarded frames
+			cpu::CPU::BreakpointHits breakpointHits;
+
+			// delta from RAM of the following entry, to RAM of this entry
+			std::vector<uint8_t> delta;
+		};
+
+		size_t sizeOfEntry(const Entry& entry) const;
+		void updateMetrics();
+
+		Config config;
+
+		std::deque<Entry> entries;
+
+		// RAM image for most recent entry
+		uint8_t latestRam[Snapshot::kSizeRam];
+
+		// scratch snapshot, to avoid allocation during record + rewind
+		Snapshot scratch;
+
+		uint32_t framesSinceRecord;
+		size_t numBytes;
+
+		Metrics metrics;
+	};
+}
@@ -0,0 +1,78 @@
+#include "machine/RunAhead.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace machine {
+	RunAhead::RunAhead() :
+		numFrames(0),
+		isRamValid(false),
+		isRunningAheadFlag(false),
+		costMicroseconds(0.0f)
+	{
+		memset(ram, 0, sizeof(ram));
+	}
+
+	void RunAhead::setNumFrames(uint32_t inNumFrames) {
+		numFrames = inNumFrames;
+		isRamValid = false;
+	}
+
+	uint32_t RunAhead::getNumFrames() const {
+		return numFrames;
+	}
+
+	bool RunAhead::runFrame(Machine& machine) {
+		isRamValid = false;
+
+		if (!machine.runFrame()) {
+			return false;
+		}
+
+		if (numFrames == 0) {
+			return true;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		machine.snapshot(snapshot);
+		machine.getCPU().saveBreakpointHits(breakpointHits);
+
+		// inputs stay latched, so run ahead frames see the current inputs
+		isRunningAheadFlag = true;
+
+		for (uint32_t i = 0; i < numFrames; i++) {
+			if (!machine.runFrame()) {
+				break;
+			}
+		}
+
+		machine.getMemory().getRam(ram);
+
+		isRunningAheadFlag = false;
+
+		machine.restore(snapshot);
+		machine.getCPU().restoreBreakpointHits(breakpointHits);
+
+		isRamValid = true;
+		costMicroseconds = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		return true;
+	}
+
+	bool RunAhead::isRunningAhead() const {
+		return isRunningAheadFlag;
+	}
+
+	bool RunAhead::hasRam() const {
+		return isRamValid;
+	}
+
+	const uint8_t* RunAhead::getRam() const {
+		return ram;
+	}
+
+	float RunAhead::getCostMicroseconds() const {
+		return costMicroseconds;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "machine/Machine.h"
+#include "machine/Snapshot.h"
+
+namespace machine {
+
+	/// @class RunAhead
+	/// @brief Reduce input latency by presenting a frame from the near future
+	/// @note each frame, the machine is snapshotted, run ahead N frames with the current inputs, and
+	///       restored. The RAM of the run ahead frame is kept for presentation.
+	class RunAhead {
+	public:
+		RunAhead();
+
+		// number of frames to run ahead, or 0 to disable
+		void setNumFrames(uint32_t numFrames);
+		uint32_t getNumFrames() const;
+
+		// run one frame of machine, then run ahead + restore
+		// - returns false if the frame was stopped before it completed (i.e. by a breakpoint)
+		bool runFrame(Machine& machine);
+
+		// true while run ahead frames are running, so that callbacks can ignore them
+		bool isRunningAhead() const;
+
+		// true if getRam() holds a run ahead frame for the most recent call to runFrame()
+		bool hasRam() const;
+
+		// RAM (including video RAM) of the most recent run ahead frame
+		const uint8_t* getRam() const;
+
+		// cost of the most recent run ahead + restore, in microseconds
+		float getCostMicroseconds() const;
+
+	private:
+		uint32_t numFrames;
+
+		Snapshot snapshot;
+		cpu::CPU::BreakpointHits breakpointHits;
+		uint8_t ram[Snapshot::kSizeRam];
+		bool isRamValid;
+
+		bool isRunningAheadFlag;
+		float costMicroseconds;
+	};
+}
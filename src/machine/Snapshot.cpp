@@ -0,0 +1,157 @@
+#include "machine/Snapshot.h"
+#include "machine/Machine.h"
+#include "util/BinaryStream.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace machine {
+	namespace {
+		// File Format (all values little-endian)
+		//  - u32 magic 'SISN'
+		//  - u16 version
+		//  - cpu: u8 a, b, c, d, e, h, l, u16 sp, pc, u8 cc, u8 interruptsEnabled, u64 numSteps
+		//  - u8[kSizeRam] ram
+		//  - u16 shiftRegister, u8 shiftRegisterResultOffset
+		//  - u8[3] inputPorts
+		//  - u8 interruptNum, u64 numInterrupts
+		//  - version 2: u64 numCycles, nextInterruptCycle, frameStartCycle
+		const uint32_t kMagic = 0x4e534953;
+		const uint16_t kVersion = 2;
+	}
+
+	Snapshot::Snapshot() :
+		numSteps(0), numCycles(0),
+		shiftRegister(0), shiftRegisterResultOffset(0),
+		interruptNum(1), numInterrupts(0),
+		nextInterruptCycle(Machine::kCyclesPerHalfFrame), frameStartCycle(0)
+	{
+		memset(ram, 0, sizeof(ram));
+		memset(inputPorts, 0, sizeof(inputPorts));
+	}
+
+	void writeSnapshot(std::ostream& stream, const Snapshot& snapshot) {
+		util::writeU32(stream, kMagic);
+		util::writeU16(stream, kVersion);
+
+		const cpu::State& state = snapshot.state;
+		util::writeU8(stream, state.a);
+		util::writeU8(stream, state.b);
+		util::writeU8(stream, state.c);
+		util::writeU8(stream, state.d);
+		util::writeU8(stream, state.e);
+		util::writeU8(stream, state.h);
+		util::writeU8(stream, state.l);
+		util::writeU16(stream, state.sp);
+		util::writeU16(stream, state.pc);
+		util::writeU8(stream, state.cc.all);
+		util::writeU8(stream, state.interruptsEnabled ? 1 : 0);
+		util::writeU64(stream, snapshot.numSteps);
+
+		util::writeBytes(stream, snapshot.ram, Snapshot::kSizeRam);
+
+		util::writeU16(stream, snapshot.shiftRegister);
+		util::writeU8(stream, snapshot.shiftRegisterResultOffset);
+
+		util::writeBytes(stream, snapshot.inputPorts, sizeof(snapshot.inputPorts));
+
+		util::writeU8(stream, snapshot.interruptNum);
+		util::writeU64(stream, snapshot.numInterrupts);
+
+		util::writeU64(stream, snapshot.numCycles);
+		util::writeU64(stream, snapshot.nextInterruptCycle);
+		util::writeU64(stream, snapshot.frameStartCycle);
+	}
+
+	bool readSnapshot(std::istream& stream, Snapshot& outSnapshot) {
+		uint32_t magic;
+		uint16_t version;
+		if (!util::readU32(stream, magic) || (magic != kMagic)) {
+			printf("snapshot - unrecognised format\n");
+			return false;
+		}
+		if (!util::readU16(stream, version) || (version == 0) || (version > kVersion)) {
+			printf("snapshot - unsupported version\n");
+			return false;
+		}
+
+		Snapshot snapshot;
+		cpu::State& state = snapshot.state;
+		uint8_t interruptsEnabled;
+
+		bool isValid =
+			util::readU8(stream, state.a) &&
+			util::readU8(stream, state.b) &&
+			util::readU8(stream, state.c) &&
+			util::readU8(stream, state.d) &&
+			util::readU8(stream, state.e) &&
+			util::readU8(stream, state.h) &&
+			util::readU8(stream, state.l) &&
+			util::readU16(stream, state.sp) &&
+			util::readU16(stream, state.pc) &&
+			util::readU8(stream, state.cc.all) &&
+			util::readU8(stream, interruptsEnabled) &&
+			util::readU64(stream, snapshot.numSteps) &&
+			util::readBytes(stream, snapshot.ram, Snapshot::kSizeRam) &&
+			util::readU16(stream, snapshot.shiftRegister) &&
+			util::readU8(stream, snapshot.shiftRegisterResultOffset) &&
+			util::readBytes(stream, snapshot.inputPorts, sizeof(snapshot.inputPorts)) &&
+			util::readU8(stream, snapshot.interruptNum) &&
+			util::readU64(stream, snapshot.numInterrupts);
+
+		if (isValid && (version >= 2)) {
+			isValid =
+				util::readU64(stream, snapshot.numCycles) &&
+				util::readU64(stream, snapshot.nextInterruptCycle) &&
+				util::readU64(stream, snapshot.frameStartCycle);
+		}
+
+		if (!isValid) {
+			printf("snapshot - truncated\n");
+			return false;
+		}
+
+		// values a machine can never hold - the shift register would be shifted out of range, or an interrupt
+		// taken to the wrong vector
+		if (snapshot.shiftRegisterResultOffset > 7) {
+			printf("snapshot - invalid shift register offset %u\n", snapshot.shiftRegisterResultOffset);
+			return false;
+		}
+
+		if ((snapshot.interruptNum != 1) && (snapshot.interruptNum != 2)) {
+			printf("snapshot - invalid interrupt %u\n", snapshot.interruptNum);
+			return false;
+		}
+
+		state.interruptsEnabled = (interruptsEnabled != 0);
+
+		outSnapshot = snapshot;
+
+		return true;
+	}
+
+	bool saveSnapshot(const char* filename, const Snapshot& snapshot) {
+		std::ofstream file;
+		file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			printf("snapshot - unable to open %s for writing\n", filename);
+			return false;
+		}
+
+		writeSnapshot(file, snapshot);
+
+		return bool(file);
+	}
+
+	bool loadSnapshot(const char* filename, Snapshot& outSnapshot) {
+		std::ifstream file;
+		file.open(filename, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			printf("snapshot - unable to open %s for reading\n", filename);
+			return false;
+		}
+
+		return readSnapshot(file, outSnapshot);
+	}
+}
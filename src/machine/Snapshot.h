@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+#include "cpu/State.h"
+
+namespace machine {
+
+	/// @struct Snapshot
+	/// @brief Complete state of a Space Invaders machine, captured between instructions
+	/// @note fixed size, so that capture + restore are a straight copy with no allocation
+	struct Snapshot {
+		Snapshot();
+
+		static const uint16_t kSizeRam = 0x2000;
+
+		// cpu
+		cpu::State state;
+		uint64_t numSteps;
+		uint64_t numCycles;
+
+		// memory (ROM is not captured)
+		uint8_t ram[kSizeRam];
+
+		// shift register hardware
+		uint16_t shiftRegister;
+		uint8_t shiftRegisterResultOffset;
+
+		// input ports 0, 1 + 2, as latched by the host
+		uint8_t inputPorts[3];
+
+		// interrupts
+		uint8_t interruptNum;
+		uint64_t numInterrupts;
+		uint64_t nextInterruptCycle;
+		uint64_t frameStartCycle;
+	};
+
+	// write snapshot to stream, in versioned binary format
+	void writeSnapshot(std::ostream& stream, const Snapshot& snapshot);
+
+	// read snapshot from stream
+	// - returns false if the stream is not a snapshot, or has an unsupported version
+	bool readSnapshot(std::istream& stream, Snapshot& outSnapshot);
+
+	// save snapshot to a binary file
+	bool saveSnapshot(const char* filename, const Snapshot& snapshot);
+
+	// load snapshot from a binary file
+	bool loadSnapshot(const char* filename, Snapshot& outSnapshot);
+}
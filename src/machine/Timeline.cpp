@@ -0,0 +1,215 @@
+#include "machine/Timeline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace machine {
+	namespace {
+		const uint64_t kNoStep = ~uint64_t(0);
+	}
+
+	Timeline::Config::Config() :
+		frameInterval(1),
+		maxSnapshots(1800)
+	{
+
+	}
+
+	Timeline::Timeline() : framesSinceSnapshot(0) {
+
+	}
+
+	void Timeline::configure(const Config& inConfig) {
+		config = inConfig;
+
+		clear();
+	}
+
+	void Timeline::update(const Machine& machine) {
+		assert(machine.isFrameStart());
+
+		const uint64_t numSteps = machine.getCPU().getNumSteps();
+
+		// inputs latched again for the same frame - replace the ones recorded for it
+		if (!inputs.empty() && (inputs.back().numSteps == numSteps)) {
+			for (uint8_t port = 0; port < 3; port++) {
+				inputs.back().inputPorts[port] = machine.getInputPort(port);
+			}
+
+			if (!snapshots.empty() && (snapshots.back().numSteps == numSteps)) {
+				memcpy(snapshots.back().inputPorts, inputs.back().inputPorts, sizeof(snapshots.back().inputPorts));
+			}
+			return;
+		}
+
+		if (!inputs.empty() && (inputs.back().numSteps > numSteps)) {
+			truncate(numSteps);
+		}
+
+		FrameInputs frameInputs;
+		frameInputs.numSteps = numSteps;
+		for (uint8_t port = 0; port < 3; port++) {
+			frameInputs.inputPorts[port] = machine.getInputPort(port);
+		}
+		inputs.push_back(frameInputs);
+
+		if (snapshots.empty() || (framesSinceSnapshot + 1 >= config.frameInterval)) {
+			snapshots.emplace_back();
+			machine.snapshot(snapshots.back());
+			breakpointHits.emplace_back();
+			machine.getCPU().saveBreakpointHits(breakpointHits.back());
+			framesSinceSnapshot = 0;
+
+			if (snapshots.size() > config.maxSnapshots) {
+				snapshots.pop_front();
+				breakpointHits.pop_front();
+
+				// inputs before the oldest snapshot can never be replayed
+				while (inputs.front().numSteps < snapshots.front().numSteps) {
+					inputs.pop_front();
+				}
+			}
+		}
+		else {
+			framesSinceSnapshot++;
+		}
+	}
+
+	void Timeline::clear() {
+		snapshots.clear();
+		breakpointHits.clear();
+		inputs.clear();
+		framesSinceSnapshot = 0;
+	}
+
+	bool Timeline::seek(Machine& machine, uint64_t numSteps) {
+		if (snapshots.empty() || (numSteps < snapshots.front().numSteps)) {
+			return false;
+		}
+
+		// latest snapshot at or before numSteps
+		const size_t index = size_t(std::upper_bound(snapshots.begin(), snapshots.end(), numSteps, [](uint64_t steps, const Snapshot& entry) {
+			return steps < entry.numSteps;
+		}) - snapshots.begin()) - 1;
+
+		// replay from the current state instead, if it is closer
+		const uint64_t currentSteps = machine.getCPU().getNumSteps();
+		if ((currentSteps > numSteps) || (currentSteps < snapshots[index].numSteps)) {
+			restore(machine, index);
+		}
+
+		replay(machine, numSteps, 0);
+
+		return true;
+	}
+
+	bool Timeline::stepBack(Machine& machine, uint64_t numSteps) {
+		const uint64_t currentSteps = machine.getCPU().getNumSteps();
+		const uint64_t firstSteps = getFirstStep();
+
+		if (snapshots.empty() || (currentSteps <= firstSteps)) {
+			return false;
+		}
+
+		return seek(machine, (currentSteps - firstSteps > numSteps) ? (currentSteps - numSteps) : firstSteps);
+	}
+
+	bool Timeline::reverseContinue(Machine& machine) {
+		const uint64_t currentSteps = machine.getCPU().getNumSteps();
+
+		if (snapshots.empty() || (currentSteps <= getFirstStep())) {
+			return false;
+		}
+
+		// replay the history between each pair of snapshots, newest first, until a breakpoint fires
+		size_t index = size_t(std::lower_bound(snapshots.begin(), snapshots.end(), currentSteps, [](const Snapshot& entry, uint64_t steps) {
+			return entry.numSteps < steps;
+		}) - snapshots.begin());
+
+		uint64_t endSteps = currentSteps;
+		while (index > 0) {
+			index--;
+
+			restore(machine, index);
+
+			const uint64_t breakSteps = replay(machine, endSteps, currentSteps);
+			if (breakSteps != kNoStep) {
+				return seek(machine, breakSteps);
+			}
+
+			endSteps = snapshots[index].numSteps;
+		}
+
+		restore(machine, 0);
+
+		return false;
+	}
+
+	uint64_t Timeline::getFirstStep() const {
+		return snapshots.empty() ? 0 : snapshots.front().numSteps;
+	}
+
+	uint64_t Timeline::getLastStep() const {
+		return inputs.empty() ? 0 : inputs.back().numSteps;
+	}
+
+	size_t Timeline::getNumSnapshots() const {
+		return snapshots.size();
+	}
+
+	void Timeline::truncate(uint64_t numSteps) {
+		while (!inputs.empty() && (inputs.back().numSteps > numSteps)) {
+			inputs.pop_back();
+		}
+
+		while (!snapshots.empty() && (snapshots.back().numSteps > numSteps)) {
+			snapshots.pop_back();
+			breakpointHits.pop_back();
+		}
+
+		// take a snapshot of the new history straight away
+		framesSinceSnapshot = config.frameInterval;
+	}
+
+	void Timeline::restore(Machine& machine, size_t index) const {
+		machine.restore(snapshots[index]);
+		machine.getCPU().restoreBreakpointHits(breakpointHits[index]);
+	}
+
+	uint64_t Timeline::replay(Machine& machine, uint64_t numSteps, uint64_t breakBeforeStep) {
+		cpu::CPU& processor = machine.getCPU();
+
+		// replaying is invisible to the host - its callbacks already ran when these steps were first run
+		const Machine::CallbackFrame callbackFrame = machine.getCallbackFrame();
+		const cpu::CPU::CallbackBreakpoint callbackBreakpoint = processor.getCallbackBreakpoint();
+
+		uint64_t breakSteps = kNoStep;
+		machine.setCallbackFrame(nullptr);
+		processor.setCallbackBreakpoint([&processor, &breakSteps, breakBeforeStep](const cpu::Breakpoint&, uint16_t) {
+			if (processor.getNumSteps() < breakBeforeStep) {
+				breakSteps = processor.getNumSteps();
+			}
+		});
+
+		auto frameInputs = std::lower_bound(inputs.begin(), inputs.end(), processor.getNumSteps(), [](const FrameInputs& entry, uint64_t steps) {
+			return entry.numSteps < steps;
+		});
+
+		while (processor.getNumSteps() < numSteps) {
+			if ((frameInputs != inputs.end()) && (frameInputs->numSteps == processor.getNumSteps())) {
+				for (uint8_t port = 0; port < 3; port++) {
+					machine.setInputPort(port, frameInputs->inputPorts[port]);
+				}
+				++frameInputs;
+			}
+
+			machine.step();
+		}
+
+		machine.setCallbackFrame(callbackFrame);
+		processor.setCallbackBreakpoint(callbackBreakpoint);
+
+		return breakSteps;
+	}
+}
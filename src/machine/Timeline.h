@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "machine/Machine.h"
+#include "machine/Snapshot.h"
+
+namespace machine {
+
+	/// @class Timeline
+	/// @brief Reverse execution for the debugger - step back, reverse continue to a breakpoint, or go to any step
+	/// @note records a snapshot every frameInterval frames, and the input ports latched at the start of every
+	///       frame. The machine is deterministic, so any step since the oldest snapshot is reached by restoring
+	///       the nearest snapshot before it, and replaying forward with the recorded inputs - a frame is around
+	///       4000 steps, so this takes well under a millisecond.
+	///
+	///       Frame + breakpoint callbacks are not invoked while replaying, and breakpoint hit counts are restored
+	///       with each snapshot, so steps are only counted as hits once. Recording new inputs at a step discards
+	///       the history that followed it.
+	class Timeline {
+	public:
+		Timeline();
+
+		struct Config {
+			Config();
+
+			// number of frames between each snapshot
+			uint32_t frameInterval;
+
+			// maximum number of snapshots - the oldest are discarded first
+			size_t maxSnapshots;
+		};
+
+		// configure the timeline, and discard any recorded history
+		void configure(const Config& config);
+
+		// call at the start of every frame, after the input ports are latched - may be called more than once for
+		// the same frame, if the inputs are latched again
+		void update(const Machine& machine);
+
+		// discard all recorded history (i.e. when a snapshot from elsewhere is restored)
+		void clear();
+
+		// move machine to step numSteps (CPU::getNumSteps()) - returns false if it is before the recorded history
+		bool seek(Machine& machine, uint64_t numSteps);
+
+		// move machine back numSteps steps
+		bool stepBack(Machine& machine, uint64_t numSteps);
+
+		// move machine back to the most recent step at which a breakpoint fired - returns false, leaving machine
+		// at the start of the recorded history, if no breakpoint fired since then
+		bool reverseContinue(Machine& machine);
+
+		// first step that can be reached, and the step at the start of the latest recorded frame
+		uint64_t getFirstStep() const;
+		uint64_t getLastStep() const;
+
+		size_t getNumSnapshots() const;
+
+	private:
+		struct FrameInputs {
+			uint64_t numSteps;
+			uint8_t inputPorts[3];
+		};
+
+		// discard history after numSteps
+		void truncate(uint64_t numSteps);
+
+		// restore machine to snapshot index, with the breakpoint hit counts taken along with it
+		void restore(Machine& machine, size_t index) const;
+
+		// step machine forward to step numSteps with the recorded inputs, and return the last step before
+		// breakBeforeStep at which a breakpoint fired (or ~0 if none did)
+		uint64_t replay(Machine& machine, uint64_t numSteps, uint64_t breakBeforeStep);
+
+		Config config;
+
+		std::deque<Snapshot> snapshots;
+		std::deque<cpu::CPU::BreakpointHits> breakpointHits;
+		std::deque<FrameInputs> inputs;
+
+		uint32_t framesSinceSnapshot;
+	};
+}
@@ -12,6 +12,12 @@
 #include <chrono>
 
 #include "cpu/CPU.h"
+#include "machine/Machine.h"
+#include "machine/Movie.h"
+#include "machine/Rewind.h"
+#include "machine/RunAhead.h"
+#include "machine/Timeline.h"
+#include "pacing/FramePacer.h"
 #include "memory/Memory.h"
 #include "util/Utils.h"
 
@@ -21,6 +27,22 @@
 namespace {
     const uint32_t kScreenWidth = 1000;
     const uint32_t kScreenHeight = 600;
+
+	const char* kSnapshotFilename = "./savestate.bin";
+	const char* kMovieFilename = "./movie.bin";
+
+	// fast forward speeds, cycled with PGUP/PGDN - 0 runs as fast as the host allows
+	const float kFastForwardSpeeds[] = { 2.0f, 4.0f, 8.0f, 16.0f, 0.0f };
+	const int kNumFastForwardSpeeds = sizeof(kFastForwardSpeeds) / sizeof(kFastForwardSpeeds[0]);
+
+	// maximum number of frames to run ahead, cycled with F7
+	const uint32_t kMaxRunAheadFrames = 4;
+
+	// longest a step over, step out or run to cursor runs before giving up - a minute of emulated time
+	const uint64_t kMaxRunFrames = 3600;
+
+	// lines of disassembly shown from PC, which the cursor moves through with UP/DOWN
+	const int kNumOpcodeLines = 10;
 }
 
 class SpaceInvaders : public olc::PixelGameEngine
@@ -42,24 +64,56 @@ public:
 #endif
 
 		// callback invoked when a breakpoint is reached
-		emulator.setCallbackBreakpoint([&](const cpu::Breakpoint& breakpoint, uint16_t value) {
+		machine.getCPU().setCallbackBreakpoint([&](const cpu::Breakpoint& breakpoint, uint16_t value) {
+			if (runAhead.isRunningAhead()) {
+				// run ahead frames are discarded, so break on the real frame instead
+				return;
+			}
+
 			switch (breakpoint.type) {
 			case cpu::Breakpoint::Type::MemoryWrite:
-				printf("PC [0x%04x] Memory Write - address [0x%04x] - changing value from [%u] to [%u]\n", emulator.getState().pc, breakpoint.address, memory.read(breakpoint.address), value);
+				printf("PC [0x%04x] Memory Write - address [0x%04x] - changing value from [%u] to [%u]\n", machine.getCPU().getState().pc, breakpoint.address, machine.getMemory().read(breakpoint.address), value);
 				break;
 			case cpu::Breakpoint::Type::Opcode:
 				printf("PC [0x%04x] Opcode\n", breakpoint.address);
 				break;
+			case cpu::Breakpoint::Type::MemoryRead:
+				printf("PC [0x%04x] Memory Read - address [0x%04x] - value [%u]\n", machine.getCPU().getState().pc, breakpoint.address, value);
+				break;
+			case cpu::Breakpoint::Type::PortIn:
+				printf("PC [0x%04x] IN - port [%u] - value [0x%02x]\n", machine.getCPU().getState().pc, breakpoint.address, value);
+				break;
+			case cpu::Breakpoint::Type::PortOut:
+				printf("PC [0x%04x] OUT - port [%u] - value [0x%02x]\n", machine.getCPU().getState().pc, breakpoint.address, value);
+				break;
 			default:
 				printf("unknown breakpoint\n");
 			}
 
 			mode = Mode::Debugger;
+			machine.stop();
+		});
+
+		// callback invoked at the end of each emulated frame
+		machine.setCallbackFrame([&]() {
+			if (runAhead.isRunningAhead()) {
+				return;
+			}
+
+			rewind.update(machine);
+			timeline.update(machine);
+
+			if (isRecordingMovie) {
+				movie.record(machine);
+			}
 		});
       		
-		
-		timeLastInterrupt = getCurrentTime();
-		interruptNum = 1;
+		isRecordingMovie = false;
+		markedStep = 0;
+		cursorLine = 0;
+
+		fastForwardSpeedIndex = 1;
+		configureFastForward();
 
         return true;
     }
@@ -67,6 +121,12 @@ public:
 	/// @brief called every frame
     bool OnUserUpdate(float fElapsedTime) override {
 		updateInput();
+
+		if (machine.isFrameStart()) {
+			// inputs only change between frames, so that movies replay deterministically
+			updateInputPorts();
+			timeline.update(machine);
+		}
 		
 		switch (mode) {
 			case Mode::Debugger:
@@ -79,12 +139,14 @@ public:
 	
         FillRect({ 0,0 }, { ScreenWidth(), ScreenHeight() }, olc::BLUE);
 
-		DrawString({ 10,10 }, PrepareString("Mode [%s]", (mode == Mode::Debugger) ? "DEBUGGER" : "RUN"));
+		DrawString({ 10,10 }, PrepareString("Mode [%s]%s", (mode == Mode::Debugger) ? "DEBUGGER" : "RUN", isRecordingMovie ? " [REC]" : ""));
+		DrawSpeed(10, 20);
         DrawCPU(10,40);
         DrawOpcodes(200,40);
-        DrawMemory("HL", emulator.getState().hl, 10, 200);
-        DrawMemory("DE", emulator.getState().de, 10, 300);
+        DrawMemory("HL", machine.getCPU().getState().hl, 10, 200);
+        DrawMemory("DE", machine.getCPU().getState().de, 10, 300);
         DrawStack(200, 200);
+        DrawRewind(10, 420);
 		
 #ifndef CPUDIAG
 		// space invaders
@@ -95,55 +157,113 @@ public:
     }
 
 	void updateFrame() {
-		bool isFrameComplete = false;
+		const uint32_t numFrames = pacer.beginUpdate();
 
-		while (!isFrameComplete) {
-			const int kNumStepsPerChunk = 10000;
+		// run ahead is only worthwhile for the frame that is presented, and not while fast forwarding
+		const bool isRunAhead = (runAhead.getNumFrames() > 0) && (pacer.getMode() == pacing::FramePacer::Mode::RealTime);
 
-			for (int i = 0; (i < kNumStepsPerChunk) && (mode == Mode::Run); i++) {
-				emulator.step();
-			}
+		for (uint32_t i = 0; i < numFrames; i++) {
+			const bool isFrameRun = (isRunAhead && (i == numFrames - 1)) ? runAhead.runFrame(machine) : machine.runFrame();
 
-			if (mode == Mode::Debugger) {
+			if (!isFrameRun) {
 				// a breakpoint was fired
-				break;
+				return;
 			}
 
-			auto currentTime = getCurrentTime();
-			const float elapsedTime = std::chrono::duration<float>(currentTime - timeLastInterrupt).count();
-			static const float kFrameDuration = 1.0f / 60.0f;
-			
-			// Space Invaders - vblank/vhalf interrupts
-			if (elapsedTime > (kFrameDuration/2)) {
-				timeLastInterrupt = currentTime;
-				
-				emulator.interrupt(interruptNum);
-
-				alternateInterruptNum();
-
-				isFrameComplete = true;
-			}
+			pacer.onFrame();
 		}
+
+		// hold emulation to real time (or to the fast forward speed)
+		pacer.endUpdate();
 	}
 
 	void updateStep() {
 		int numSteps = 0;
+		int numStepsBack = 0;
+		int numFrames = 0;
 
 		if (GetKey(olc::SPACE).bReleased) {
 			numSteps = 1;
 		}
+		else if (GetKey(olc::B).bReleased) {
+			numStepsBack = 1;
+		}
+		else if (GetKey(olc::F8).bReleased) {
+			numFrames = 1;
+		}
 
 		if (GetKey(olc::SHIFT).bHeld) {
 			numSteps *= 10;
+			numStepsBack *= 10;
+			numFrames *= 10;
 
 			if (GetKey(olc::CTRL).bHeld) {
 				numSteps *= 100;
+				numStepsBack *= 100;
+				numFrames *= 100;
 			}
 		}
 		
 		if (numSteps > 0) {
 			step(numSteps);
 		}
+
+		// step over, step out, run to cursor + run frames use the machine's own loop, so they take milliseconds
+		// even when millions of instructions are run
+		if (numFrames > 0) {
+			machine.runFrames(uint64_t(numFrames));
+		}
+
+		if (GetKey(olc::UP).bPressed) {
+			cursorLine = std::max(cursorLine - 1, 0);
+		}
+		else if (GetKey(olc::DOWN).bPressed) {
+			cursorLine = std::min(cursorLine + 1, kNumOpcodeLines - 1);
+		}
+
+		if (GetKey(olc::F10).bPressed) {
+			if (!machine.stepOver(kMaxRunFrames)) {
+				printf("debugger - step over stopped at PC [0x%04x] before the call returned\n", machine.getCPU().getState().pc);
+			}
+		}
+		else if (GetKey(olc::F11).bPressed) {
+			if (!machine.stepOut(kMaxRunFrames)) {
+				printf("debugger - step out stopped at PC [0x%04x] before the function returned\n", machine.getCPU().getState().pc);
+			}
+		}
+		else if (GetKey(olc::F4).bPressed) {
+			const uint16_t address = getCursorAddress();
+			if (!machine.runTo(address, 0, kMaxRunFrames)) {
+				printf("debugger - run to cursor stopped at PC [0x%04x] before reaching [0x%04x]\n", machine.getCPU().getState().pc, address);
+			}
+		}
+
+		if (numStepsBack > 0) {
+			if (!timeline.stepBack(machine, uint64_t(numStepsBack))) {
+				printf("timeline - no history before step %llu\n", machine.getCPU().getNumSteps());
+			}
+			truncateMovie();
+		}
+
+		// reverse continue, to the last step a breakpoint fired at
+		if (GetKey(olc::V).bPressed) {
+			if (!timeline.reverseContinue(machine)) {
+				printf("timeline - no breakpoint fired since step %llu\n", machine.getCPU().getNumSteps());
+			}
+			truncateMovie();
+		}
+
+		// mark the current step, then go back (or forward) to it
+		if (GetKey(olc::M).bPressed) {
+			markedStep = machine.getCPU().getNumSteps();
+			printf("timeline - marked step %llu\n", markedStep);
+		}
+		else if (GetKey(olc::G).bPressed) {
+			if (!timeline.seek(machine, markedStep)) {
+				printf("timeline - step %llu is before the recorded history\n", markedStep);
+			}
+			truncateMovie();
+		}
 	}
 
 	void updateInput() {
@@ -153,6 +273,77 @@ public:
 		else if (GetKey(olc::R).bPressed) {
 			mode = Mode::Run;
 		}
+
+		if (GetKey(olc::BACK).bHeld) {
+			// step backwards through history, one snapshot per update
+			if (rewind.rewind(machine)) {
+				mode = Mode::Debugger;
+				truncateMovie();
+			}
+		}
+
+		if (GetKey(olc::F5).bPressed) {
+			saveSnapshot();
+		}
+		else if (GetKey(olc::F9).bPressed) {
+			stopRecordingMovie();
+			loadSnapshot();
+		}
+
+		if (GetKey(olc::TAB).bPressed) {
+			const bool isFastForward = (pacer.getMode() == pacing::FramePacer::Mode::FastForward);
+			pacer.setMode(isFastForward ? pacing::FramePacer::Mode::RealTime : pacing::FramePacer::Mode::FastForward);
+		}
+		else if (GetKey(olc::PGUP).bPressed) {
+			fastForwardSpeedIndex = std::min(fastForwardSpeedIndex + 1, kNumFastForwardSpeeds - 1);
+			configureFastForward();
+		}
+		else if (GetKey(olc::PGDN).bPressed) {
+			fastForwardSpeedIndex = std::max(fastForwardSpeedIndex - 1, 0);
+			configureFastForward();
+		}
+
+		if (GetKey(olc::F7).bPressed) {
+			runAhead.setNumFrames((runAhead.getNumFrames() + 1) % (kMaxRunAheadFrames + 1));
+		}
+
+		if (GetKey(olc::F6).bPressed) {
+			if (isRecordingMovie) {
+				stopRecordingMovie();
+			}
+			else {
+				startRecordingMovie();
+			}
+		}
+	}
+
+	/// @brief latch the state of the controls into the machine's input ports, read by the IN opcode
+	void updateInputPorts() {
+		uint8_t port0 =
+			(1 << 1) |									// always 1
+			(1 << 2) |									// always 1
+			(1 << 3) |									// always 1
+			((GetKey(olc::SPACE).bHeld ? 1 : 0) << 4) |	// P1 Shoot
+			((GetKey(olc::LEFT).bHeld ? 1 : 0) << 5) |	// P1 Left
+			((GetKey(olc::RIGHT).bHeld ? 1 : 0) << 6);	// P1 Right
+
+		uint8_t port1 =
+			(GetKey(olc::C).bHeld ? 0 : 1) |			// Coin
+			((GetKey(olc::K2).bHeld ? 1 : 0) << 1) |		// P2 Start Button
+			((GetKey(olc::K1).bHeld ? 1 : 0) << 2) |		// P1 Start Button
+			(1 << 3) |									// always 1
+			((GetKey(olc::SPACE).bHeld ? 1 : 0) << 4) |	// P1 Shoot
+			((GetKey(olc::LEFT).bHeld ? 1 : 0) << 5) |	// P1 Left
+			((GetKey(olc::RIGHT).bHeld ? 1 : 0) << 6);	// P1 Right
+
+		uint8_t port2 =
+			((GetKey(olc::SHIFT).bHeld ? 1 : 0) << 4) |	// P2 Shoot
+			((GetKey(olc::Z).bHeld ? 1 : 0) << 5) |		// P2 Left
+			((GetKey(olc::X).bHeld ? 1 : 0) << 6);		// P2 Right
+
+		machine.setInputPort(0, port0);
+		machine.setInputPort(1, port1);
+		machine.setInputPort(2, port2);
 	}
 
 private:
@@ -160,6 +351,8 @@ private:
 		const char* kRomFilename = "./roms/cpudiag/cpudiag.bin";
 		const uint16_t kRomLoadAddress = 0x100;
 		
+		memory::Memory& memory = machine.getMemory();
+
 		memory::Memory::Config config;
 		config.isRomWriteable = true;
 		config.sizeRam = 4 * 1024;
@@ -179,7 +372,7 @@ private:
         memory.write(0x59d, 0xc2);
         memory.write(0x59e, 0x05);
 
-		emulator.init(&memory, kRomLoadAddress);
+		machine.getCPU().init(&memory, kRomLoadAddress);
 
 		// run enough steps to complete test
 		// expect to see "CPU IS OPERATIONAL" in console TTY
@@ -187,118 +380,120 @@ private:
 	}
 
 	void initSpaceInvaders() {
-		initIO();
-
 		const char* kRomFilename = "./roms/spaceinvaders/invaders.concatenated";
 
-		memory::Memory::Config config;
-		config.sizeRam = 0x2000;
-		config.sizeRom = uint16_t(util::getFileSize(kRomFilename));
-		config.isRomWriteable = false;
-		config.isRamMirrored = true;
-
-		memory.configure(config);
-		memory.load(kRomFilename);
-
-		uint16_t pcStart = 0;
-		emulator.init(&memory, pcStart);
+		machine.init(kRomFilename);
 
 # if 0		
 		// debugging 'credits' 
 
 		// address of 'credits' in memory discovered by using old school 'Game Genie' method of looking for byte that 
 		//   changed when number of credits was incremented / decremented
-		emulator.addBreakpoint(Breakpoint(Breakpoint::Type::MemoryWrite, 8192 + 235));
+		//   - a trace index now answers this directly, i.e. 'tracequery trace.bin.idx --address 0x20eb --pcs'
+		machine.getCPU().addBreakpoint(Breakpoint(Breakpoint::Type::MemoryWrite, 8192 + 235));
 
 		// PC where credits is incremented
-		emulator.addBreakpoint(Breakpoint(Breakpoint::Type::Opcode, 0x0038));
+		machine.getCPU().addBreakpoint(Breakpoint(Breakpoint::Type::Opcode, 0x0038));
 
 		// PC where credits is decremented
-		emulator.addBreakpoint(Breakpoint(Breakpoint::Type::Opcode, 0x079b));
+		machine.getCPU().addBreakpoint(Breakpoint(Breakpoint::Type::Opcode, 0x079b));
+
+		// credits incremented past 3, from the second time on - the condition is checked without stopping
+		Breakpoint moreCredits(Breakpoint::Type::Opcode, 0x0038);
+		moreCredits.condition.compile("[0x20eb] >= 3");
+		moreCredits.hitCount = 2;
+		machine.getCPU().addBreakpoint(moreCredits);
+
+		// anything drawn to the first 8 rows of video RAM, and sounds played through port 3
+		machine.getCPU().addBreakpoint(Breakpoint(Breakpoint::Type::MemoryWrite, 0x2400, 0x24ff));
+		machine.getCPU().addBreakpoint(Breakpoint(Breakpoint::Type::PortOut, 3));
 # endif	
+	}
 
-		emulator.init(&memory, 0);
+	void configureFastForward() {
+		pacing::FramePacer::Config config = pacer.getConfig();
+		config.speedMultiplier = kFastForwardSpeeds[fastForwardSpeedIndex];
+		pacer.configure(config);
 	}
 
-	/// @brief Initialise I/O as expected for Space Invaders arcade machine
-    void initIO() {
-		emulator.setCallbackIn([this](uint8_t port) -> uint8_t {
-			//printf("IN port %u\n", port);
-
-			uint8_t a = 0;
-			switch (port) {
-			case 0:
-				a = (1 << 1) |									// always 1
-					(1 << 2) |									// always 1
-					(1 << 3) |									// always 1
-					((GetKey(olc::SPACE).bHeld ? 1 : 0) << 4) |	// P1 Shoot
-					((GetKey(olc::LEFT).bHeld ? 1 : 0) << 5) |	// P1 Left
-					((GetKey(olc::RIGHT).bHeld ? 1 : 0) << 6);	// P1 Right
-				break;
-			case 1:
-				a =
-					(GetKey(olc::C).bHeld ? 0 : 1) |			// Coin
-					((GetKey(olc::K2).bHeld ? 1 : 0) << 1) |		// P2 Start Button
-					((GetKey(olc::K1).bHeld ? 1 : 0) << 2) |		// P1 Start Button
-					(1 << 3) |									// always 1
-					((GetKey(olc::SPACE).bHeld ? 1 : 0) << 4) |	// P1 Shoot
-					((GetKey(olc::LEFT).bHeld ? 1 : 0) << 5) |	// P1 Left
-					((GetKey(olc::RIGHT).bHeld ? 1 : 0) << 6);	// P1 Right
-				break;
-			case 2:
-				a =
-					(GetKey(olc::SHIFT).bHeld ? 1 : 0) << 4,	// P2 Shoot
-					(GetKey(olc::Z).bHeld ? 1 : 0) << 5,		// P2 Left
-					(GetKey(olc::X).bHeld ? 1 : 0) << 6;		// P2 Right
-				break;
-			case 3:
-				// read from shift register
-				{
-					uint8_t shiftAmount = 8 - shiftRegisterResultOffset;
-					uint16_t shiftedResult = shiftRegister >> shiftAmount;
-					a = uint8_t(shiftedResult & 0xff);
-				}
-				break;
-			default:
-				break;
-			}
+	void startRecordingMovie() {
+		if (!machine.isFrameStart()) {
+			printf("movie - recording can only start at the start of a frame\n");
+			return;
+		}
 
-			return a;
-		});
+		movie.start(machine);
+		isRecordingMovie = true;
 
-		emulator.setCallbackOut([this](uint8_t port, uint8_t value) -> void {
-			//printf("OUT port %u value %u\n", port, value);
+		printf("movie - recording started at frame %llu\n", machine.getNumFrames());
+	}
 
-			switch (port) {
-			case 2:
-				// 3 bit shift register offset
-				shiftRegisterResultOffset = value & 0x7;
-				break;
-			case 4:
-				// push to high byte of shift register
-				shiftRegister >>= 8;
-				shiftRegister |= (uint16_t(value) << 8);
-				break;
-			default:
-				break;
-			}
-		});
-    }
+	void stopRecordingMovie() {
+		if (!isRecordingMovie) {
+			return;
+		}
+
+		isRecordingMovie = false;
+
+		if (machine::saveMovie(kMovieFilename, movie)) {
+			printf("movie - saved %zu frames to %s\n", movie.frames.size(), kMovieFilename);
+		}
+	}
+
+	/// @brief discard frames of the movie that follow the current (rewound) state of the machine
+	void truncateMovie() {
+		if (!isRecordingMovie) {
+			return;
+		}
+
+		const uint64_t startFrame = movie.snapshot.numInterrupts / 2;
+		const uint64_t currentFrame = machine.getNumFrames();
+
+		if (currentFrame < startFrame) {
+			stopRecordingMovie();
+		}
+		else if ((currentFrame - startFrame) < movie.frames.size()) {
+			movie.frames.resize(size_t(currentFrame - startFrame));
+		}
+	}
+
+	void saveSnapshot() {
+		machine::Snapshot snapshot;
+		machine.snapshot(snapshot);
+
+		if (machine::saveSnapshot(kSnapshotFilename, snapshot)) {
+			printf("saved snapshot to %s at step %llu\n", kSnapshotFilename, snapshot.numSteps);
+		}
+	}
+
+	void loadSnapshot() {
+		machine::Snapshot snapshot;
+
+		if (machine::loadSnapshot(kSnapshotFilename, snapshot)) {
+			machine.restore(snapshot);
+			machine.getCPU().resetBreakpointHits();
+			timeline.clear();
+			printf("loaded snapshot from %s at step %llu\n", kSnapshotFilename, snapshot.numSteps);
+		}
+	}
 
     void step(int stepCount = 1) {
         for (int i = 0; i < stepCount; i++) {
-            emulator.step();
+            machine.step();
         }
     }
     
     void DrawCPU(int x, int y) {
         DrawString({ x, y }, "CPU State");
 
-        const cpu::State& state = emulator.getState();
-        uint64_t numSteps = emulator.getNumSteps();
+        const cpu::State& state = machine.getCPU().getState();
+        uint64_t numSteps = machine.getCPU().getNumSteps();
+        uint64_t numCycles = machine.getCPU().getNumCycles();
 
         std::vector<std::string> reports = {
             PrepareString("step: %llu", numSteps),
+            PrepareString(" cyc: %llu", numCycles),
+            PrepareString(" frm: %llu", machine.getNumFrames()),
             PrepareString("   a: 0x%02x", state.a),
             PrepareString("  bc: 0x%02x%02x", state.b, state.c),
             PrepareString("  de: 0x%02x%02x", state.d, state.e),
@@ -320,17 +515,33 @@ private:
 
     }
 
+	/// @brief address of the instruction at the cursor in the disassembly
+	uint16_t getCursorAddress() {
+		uint16_t pc = machine.getCPU().getState().pc;
+
+		for (int i = 0; i < cursorLine; i++) {
+			uint16_t opcodeSize;
+			Disassemble::stringFromOpcode(&machine.getMemory(), pc, opcodeSize);
+			pc += opcodeSize;
+		}
+
+		return pc;
+	}
+
     void DrawOpcodes(int x, int y) {
         DrawString({ x, y }, "Opcodes");
         
-        const cpu::State& state = emulator.getState();
+        const cpu::State& state = machine.getCPU().getState();
         uint16_t pc = state.pc;
 
         y += 10;
-        for (int i = 0; i < 10; i++) {
+        for (int i = 0; i < kNumOpcodeLines; i++) {
 			uint16_t opcodeSize;			
-			std::string strOpcode = Disassemble::stringFromOpcode(&memory, pc, opcodeSize);
+			std::string strOpcode = Disassemble::stringFromOpcode(&machine.getMemory(), pc, opcodeSize);
             
+			if (i == cursorLine) {
+				DrawString({ x, y }, ">");
+			}
             DrawString({ x + 10, y }, PrepareString("0x%04x %s", pc, strOpcode.c_str()));
             y += 10;
 
@@ -341,6 +552,8 @@ private:
     void DrawMemory(const char* label, uint16_t address, int x, int y) {
         DrawString({ x, y }, PrepareString("Memory (%s)", label));
 
+        const memory::Memory& memory = machine.getMemory();
+
         // 4 byte alignment
         address &= ~3;
 
@@ -358,10 +571,12 @@ private:
     void DrawStack(int x, int y) {
         DrawString({ x, y }, "Stack");
 
-        const cpu::State& state = emulator.getState();
+        const cpu::State& state = machine.getCPU().getState();
         uint16_t sp = state.sp;
         uint16_t address = sp & ~3;
 
+        const memory::Memory& memory = machine.getMemory();
+
         y += 10;
         for (int i = 0; i < 10; i++) {
 			if (address >= memory.size()) {
@@ -374,8 +589,49 @@ private:
         }
     }
 
+	void DrawSpeed(int x, int y) {
+		std::string fastForward = "OFF";
+		if (pacer.getMode() == pacing::FramePacer::Mode::FastForward) {
+			const float speedMultiplier = pacer.getConfig().speedMultiplier;
+			fastForward = (speedMultiplier > 0.0f) ? PrepareString("%.0fx", speedMultiplier) : std::string("MAX");
+		}
+
+		DrawString({ x, y }, PrepareString("Speed [%.1fx] Fast Forward [%s]", pacer.getSpeed(), fastForward.c_str()));
+
+		const pacing::FramePacer::Stats& stats = pacer.getStats();
+		DrawString({ x, y + 10 }, PrepareString("Skip [%llu] Late [%llu] Wake [%.0f/%.0fus] Run Ahead [%u] [%.0fus]", stats.numSkippedFrames, stats.numLateFrames, stats.meanWakeLatencyMicroseconds, stats.maxWakeLatencyMicroseconds, runAhead.getNumFrames(), runAhead.getCostMicroseconds()));
+	}
+
+	void DrawRewind(int x, int y) {
+		DrawString({ x, y }, "Rewind");
+
+		const machine::Rewind::Metrics& metrics = rewind.getMetrics();
+
+		std::vector<std::string> reports = {
+			PrepareString("snapshots: %zu", metrics.numSnapshots),
+			PrepareString("   frames: %llu", metrics.numFrames),
+			PrepareString("     size: %zu KB", metrics.numBytes / 1024),
+			PrepareString("   record: %.1f us", metrics.recordMicroseconds),
+			PrepareString("   rewind: %.1f us", metrics.rewindMicroseconds),
+			PrepareString(" timeline: %llu - %llu", timeline.getFirstStep(), timeline.getLastStep()),
+			PrepareString("     mark: %llu", markedStep),
+		};
+
+		y += 10;
+		for (auto it = reports.begin(); it != reports.end(); it++) {
+			DrawString({ x + 10, y }, *it);
+			y += 10;
+		}
+	}
+
 	void DrawVideoRam(int x, int y) {
 		const uint16_t kVideoRamStart = 0x2400;
+		const memory::Memory& memory = machine.getMemory();
+
+		// present the run ahead frame when there is one, so that inputs show up N frames sooner
+		const bool isRunAhead = (mode == Mode::Run) && (pacer.getMode() == pacing::FramePacer::Mode::RealTime) && runAhead.hasRam();
+		const uint8_t* runAheadRam = isRunAhead ? runAhead.getRam() : nullptr;
+		const uint16_t kRamStart = 0x2000;
 
 		int i = 0;
 		const int kVideoRamWidth = 224;
@@ -383,7 +639,8 @@ private:
 
 		for (int ix = 0; ix < kVideoRamWidth; ix++) {
 			for (int iy = 0; iy < kVideoRamHeight; iy +=8) {
-				uint8_t byte = memory.read(kVideoRamStart + i++);
+				const uint16_t address = kVideoRamStart + i++;
+				uint8_t byte = (runAheadRam != nullptr) ? runAheadRam[address - kRamStart] : memory.read(address);
 
 				for (int b = 0; b < 8; b++) {
 					FillRect({ x + ( ix << 1), y + ((kVideoRamHeight - (iy + b)) << 1) }, { 2,2 }, ((byte & 0x1) == 0x1) ? olc::WHITE : olc::BLACK);
@@ -405,22 +662,11 @@ private:
         return ret;
     }
 
-	std::chrono::time_point<std::chrono::system_clock> getCurrentTime() const {
-		return std::chrono::system_clock::now();
-	}
-
-	void alternateInterruptNum() {
-		// interruptNum 1 => simulate vsync when beam is near the middle of the screen
-		// interruptNum 2 => simulate vsync when beam is near the bottom of the screen
-
-		interruptNum = (interruptNum == 1) ? 2 : 1;
-	}
-    
-	cpu::CPU emulator;
-	memory::Memory memory;
-
-	uint8_t shiftRegisterResultOffset;
-	uint16_t shiftRegister;
+	machine::Machine machine;
+	machine::Rewind rewind;
+	machine::Timeline timeline;
+	uint64_t markedStep;
+	int cursorLine;
 	
 	enum class Mode {
 		Debugger,
@@ -428,8 +674,13 @@ private:
 	};
 	Mode mode;
 
-	std::chrono::time_point<std::chrono::system_clock> timeLastInterrupt;
-	int interruptNum;
+	machine::Movie movie;
+	bool isRecordingMovie;
+
+	pacing::FramePacer pacer;
+	int fastForwardSpeedIndex;
+
+	machine::RunAhead runAhead;
 };
 
 int main()
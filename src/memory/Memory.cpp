@@ -1,12 +1,45 @@
 #include "memory/Memory.h"
 #include "util/Utils.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 
 namespace memory {
-	Memory::Memory() {
+	namespace {
+		const uint16_t kPageMask = Memory::kPageSize - 1;
+
+		// random odd key per address, so changing any single byte always changes the hash
+		struct HashKeys {
+			HashKeys() {
+				for (size_t i = 0; i < 0x10000; i++) {
+					keys[i] = util::mix(i) | 1;
+				}
+			}
+
+			uint64_t keys[0x10000];
+		};
+
+		const HashKeys hashKeys;
+
+		uint64_t getKey(size_t address) {
+			return hashKeys.keys[address];
+		}
+
+		// change in hash when the byte at address changes from previous to value
+		uint64_t getHashDelta(size_t address, uint8_t previous, uint8_t value) {
+			return getKey(address) * (uint64_t(value) - uint64_t(previous));
+		}
+	}
+
+	Memory::Memory() :
+		numPageCopies(0),
+		hash(0)
+	{
 
 	}
 
@@ -21,9 +54,15 @@ namespace memory {
 	bool Memory::configure(const Config& inConfig) {
 		config = inConfig;
 
-		if (memory.size() != size()) {
-			memory.resize(size(), 0xfe);
+		const size_t numPages = (size_t(size()) + kPageSize - 1) / kPageSize;
+		while (pages.size() < numPages) {
+			std::shared_ptr<Page> page = std::make_shared<Page>();
+			memset(page->data, 0xfe, kPageSize);
+			pages.push_back(page);
 		}
+		pages.resize(numPages);
+
+		rehash();
 
 		return true;
 	}
@@ -44,9 +83,8 @@ namespace memory {
 
 		file.close();
 
-		for (size_t i = 0; i < size; i++) {
-			size_t writeAddress = size_t(address) + i;
-			memory[writeAddress] = data[i];
+		if (!load(data.data(), size, address)) {
+			return false;
 		}
 
 		std::cout << "Loaded " << filename << " with " << size << " bytes\n";
@@ -54,10 +92,115 @@ namespace memory {
 		return true;
 	}
 
+	bool Memory::load(const uint8_t* data, size_t size, uint16_t address) {
+		if (size_t(address) + size > this->size()) {
+			printf("Memory::load - %zu bytes at 0x%04x do not fit in memory\n", size, address);
+			return false;
+		}
+
+		copyIn(address, data, size);
+
+		return true;
+	}
+
 	uint16_t Memory::size() const {
 		return config.sizeRam + config.sizeRom;
 	}
 
+	uint16_t Memory::sizeRam() const {
+		return config.sizeRam;
+	}
+
+	void Memory::getRam(uint8_t* outData) const {
+		copyOut(config.sizeRom, outData, config.sizeRam);
+	}
+
+	void Memory::setRam(const uint8_t* data) {
+		copyIn(config.sizeRom, data, config.sizeRam);
+	}
+
+	void Memory::fork(const Memory& other) {
+		config = other.config;
+		pages = other.pages;
+		hash = other.hash;
+	}
+
+	uint64_t Memory::getNumPageCopies() const {
+		return numPageCopies;
+	}
+
+	size_t Memory::getNumSharedPages() const {
+		size_t numShared = 0;
+		for (const std::shared_ptr<Page>& page : pages) {
+			numShared += (page.use_count() > 1) ? 1 : 0;
+		}
+
+		return numShared;
+	}
+
+	uint64_t Memory::getHash() const {
+		return hash;
+	}
+
+	void Memory::copyIn(uint16_t address, const uint8_t* data, size_t size) {
+		size_t offset = 0;
+		while (offset < size) {
+			const size_t pageAddress = size_t(address) + offset;
+			const size_t pageOffset = pageAddress & kPageMask;
+			const size_t count = std::min(size - offset, size_t(kPageSize) - pageOffset);
+
+			uint8_t* page = pages[pageAddress / kPageSize]->data;
+
+			// leave pages that already hold the data shared
+			if (memcmp(page + pageOffset, data + offset, count) != 0) {
+				for (size_t i = 0; i < count; i++) {
+					hash += getHashDelta(pageAddress + i, page[pageOffset + i], data[offset + i]);
+				}
+
+				memcpy(getWritablePage(pageAddress / kPageSize) + pageOffset, data + offset, count);
+			}
+
+			offset += count;
+		}
+	}
+
+	void Memory::copyOut(uint16_t address, uint8_t* outData, size_t size) const {
+		size_t offset = 0;
+		while (offset < size) {
+			const size_t pageAddress = size_t(address) + offset;
+			const size_t pageOffset = pageAddress & kPageMask;
+			const size_t count = std::min(size - offset, size_t(kPageSize) - pageOffset);
+
+			memcpy(outData + offset, pages[pageAddress / kPageSize]->data + pageOffset, count);
+
+			offset += count;
+		}
+	}
+
+	uint8_t* Memory::getWritablePage(size_t index) {
+		std::shared_ptr<Page>& page = pages[index];
+
+		// only this memory map holds a reference to an unshared page, so the count can't rise behind our back
+		if (page.use_count() > 1) {
+			page = std::make_shared<Page>(*page);
+			numPageCopies++;
+		} else {
+			// use_count() is a relaxed load - pair it with the release of the last fork to drop the page, so that
+			// fork's reads of the page happen before we write to it
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+
+		return page->data;
+	}
+
+	void Memory::rehash() {
+		hash = 0;
+
+		for (size_t address = 0; address < pages.size() * kPageSize; address++) {
+			hash += getHashDelta(address, 0, pages[address / kPageSize]->data[address & kPageMask]);
+		}
+	}
+
 	uint16_t Memory::translate(uint16_t inAddress) const {
 		uint16_t address = inAddress;
 
@@ -73,7 +216,7 @@ namespace memory {
 	}
 
 	uint8_t Memory::read(uint16_t address) const {
-		return memory[address];
+		return pages[address / kPageSize]->data[address & kPageMask];
 	}
 
 	void Memory::write(uint16_t address, uint8_t value) {
@@ -84,6 +227,11 @@ namespace memory {
 			}
 		}
 
-		memory[address] = value;		
+		// writing the value that is already there leaves a shared page shared
+		const uint8_t previous = read(address);
+		if (previous != value) {
+			getWritablePage(address / kPageSize)[address & kPageMask] = value;
+			hash += getHashDelta(address, previous, value);
+		}
 	}
 }
\ No newline at end of file
@@ -2,14 +2,23 @@
 
 #include "memory/IMemory.h"
 
+#include <memory>
 #include <vector>
 
 namespace memory {
 
+	/// @class Memory
+	/// @brief Contiguous memory map of ROM followed by RAM
+	/// @note memory is held in pages, which are shared copy-on-write between forks of a memory map - a page
+	///       is copied the first time either fork writes a new value to it.
+	///       A hash of the contents is updated on every write, so it can be read at any time without touching
+	///       the pages - it is the sum of value * key(address) over every byte, with a random odd key per address.
 	class Memory : public IMemory {
 	public:
 		Memory();
 
+		static const uint16_t kPageSize = 0x100;
+
 		/// @struct Config
 		/// @brief Describe a contiguous memory map, starting with ROM and followed by RAM
 		struct Config {
@@ -27,17 +36,57 @@ namespace memory {
 		// Load a ROM from filename at specified address
 		bool load(const char* filename, uint16_t address = 0);
 
+		// Load a ROM from a block of data at specified address
+		bool load(const uint8_t* data, size_t size, uint16_t address = 0);
+
 		// Return total size of memory map
 		uint16_t size() const;
 
+		// Return size of RAM, which follows ROM in the memory map
+		uint16_t sizeRam() const;
+
+		// Copy contents of RAM to outData (sizeRam() bytes)
+		void getRam(uint8_t* outData) const;
+
+		// Overwrite contents of RAM with data (sizeRam() bytes)
+		void setRam(const uint8_t* data);
+
+		// Make this memory a copy of other, sharing every page until it is written to
+		// - other may be forked from several threads at once, but must not be written while any fork is in progress
+		void fork(const Memory& other);
+
+		// Return number of pages copied on write, and number of pages currently shared with another memory map
+		uint64_t getNumPageCopies() const;
+		size_t getNumSharedPages() const;
+
+		// Return hash of the entire memory map, maintained incrementally as memory is written
+		// - equal contents always have equal hashes, and memory maps that differ in a single byte never do
+		uint64_t getHash() const;
+
 	public: // IMemory
 		uint16_t translate(uint16_t address) const override;
 		void write(uint16_t address, uint8_t value) override;
 		uint8_t read(uint16_t address) const override;
 
 	private:
+		struct Page {
+			uint8_t data[kPageSize];
+		};
+
+		// copy a range of memory in or out, a page at a time
+		void copyIn(uint16_t address, const uint8_t* data, size_t size);
+		void copyOut(uint16_t address, uint8_t* outData, size_t size) const;
+
+		// return page data that is safe to write to, copying the page if it is shared
+		uint8_t* getWritablePage(size_t index);
+
+		// recalculate the hash from the contents of every page
+		void rehash();
+
 		Config config;
 
-		std::vector<uint8_t> memory;
+		std::vector<std::shared_ptr<Page>> pages;
+		uint64_t numPageCopies;
+		uint64_t hash;
 	};
 }
\ No newline at end of file
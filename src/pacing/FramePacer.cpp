@@ -0,0 +1,202 @@
+#include "pacing/FramePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+	#include <timeapi.h>
+	#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace pacing {
+	namespace {
+		const auto kFrameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / FramePacer::kFramesPerSecond));
+
+		// time spent outside of the run loop (i.e. in the debugger) longer than this is not caught up with
+		const double kMaxElapsedSeconds = 0.25;
+
+		// speed is measured over windows of this duration
+		const std::chrono::duration<double> kSpeedWindowDuration(0.5);
+
+		// limit frames per update in FastForward, so the host stays responsive when it can't keep up
+		const uint32_t kMaxFramesPerUpdate = 600;
+
+		// weight of each new sample in the mean wake latency
+		const float kWakeLatencySmoothing = 0.05f;
+	}
+
+	FramePacer::Config::Config() :
+		speedMultiplier(4.0f), renderInterval(10), maxCatchUpFrames(4),
+		waitMode(WaitMode::Sleep), spinMicroseconds(0)
+	{
+
+	}
+
+	FramePacer::Stats::Stats() :
+		numSkippedFrames(0), numLateFrames(0),
+		numWaits(0), meanWakeLatencyMicroseconds(0.0f), maxWakeLatencyMicroseconds(0.0f)
+	{
+
+	}
+
+	FramePacer::FramePacer() :
+		mode(Mode::RealTime),
+		frameAccumulator(0.0),
+		numFramesSpeedWindow(0),
+		speed(0.0f),
+		maxWakeLatencySpeedWindow(0.0f)
+	{
+#if defined(_WIN32)
+		// default timer resolution is ~15ms, which is too coarse to sleep until a frame deadline
+		timeBeginPeriod(1);
+#endif
+
+		timeLastUpdate = Clock::now();
+		nextUpdateDeadline = timeLastUpdate;
+		nextFrameDeadline = timeLastUpdate;
+		timeSpeedWindow = timeLastUpdate;
+	}
+
+	FramePacer::~FramePacer() {
+#if defined(_WIN32)
+		timeEndPeriod(1);
+#endif
+	}
+
+	void FramePacer::configure(const Config& inConfig) {
+		config = inConfig;
+		frameAccumulator = 0.0;
+	}
+
+	const FramePacer::Config& FramePacer::getConfig() const {
+		return config;
+	}
+
+	void FramePacer::setMode(Mode inMode) {
+		mode = inMode;
+		frameAccumulator = 0.0;
+		nextFrameDeadline = Clock::now();
+	}
+
+	FramePacer::Mode FramePacer::getMode() const {
+		return mode;
+	}
+
+	uint32_t FramePacer::beginUpdate() {
+		auto now = Clock::now();
+
+		// don't try to catch up with time spent outside of the run loop (i.e. in the debugger)
+		double elapsedSeconds = std::chrono::duration<double>(now - timeLastUpdate).count();
+		if (elapsedSeconds > kMaxElapsedSeconds) {
+			elapsedSeconds = kMaxElapsedSeconds;
+			nextFrameDeadline = now;
+
+			timeSpeedWindow = now;
+			numFramesSpeedWindow = 0;
+		}
+		timeLastUpdate = now;
+
+		uint32_t numFrames = 1;
+
+		if (mode == Mode::RealTime) {
+			// run every frame whose deadline has passed, up to the catch up limit
+			numFrames = 0;
+			while (now >= nextFrameDeadline) {
+				numFrames += 1;
+				nextFrameDeadline += kFrameDuration;
+			}
+
+			const uint32_t maxCatchUpFrames = std::max(config.maxCatchUpFrames, 1u);
+			if (numFrames > maxCatchUpFrames) {
+				stats.numLateFrames += numFrames - maxCatchUpFrames;
+				numFrames = maxCatchUpFrames;
+			}
+
+			if (numFrames > 1) {
+				stats.numSkippedFrames += numFrames - 1;
+			}
+		}
+		else {
+			if (config.speedMultiplier <= 0.0f) {
+				numFrames = std::max(config.renderInterval, 1u);
+			}
+			else {
+				frameAccumulator += elapsedSeconds * kFramesPerSecond * config.speedMultiplier;
+				numFrames = uint32_t(std::min(frameAccumulator, double(kMaxFramesPerUpdate)));
+				frameAccumulator -= numFrames;
+			}
+		}
+
+		return numFrames;
+	}
+
+	void FramePacer::onFrame() {
+		numFramesSpeedWindow += 1;
+
+		auto now = Clock::now();
+		const auto elapsed = now - timeSpeedWindow;
+		if (elapsed >= kSpeedWindowDuration) {
+			const double elapsedSeconds = std::chrono::duration<double>(elapsed).count();
+			speed = float(numFramesSpeedWindow / (elapsedSeconds * kFramesPerSecond));
+
+			timeSpeedWindow = now;
+			numFramesSpeedWindow = 0;
+
+			stats.maxWakeLatencyMicroseconds = maxWakeLatencySpeedWindow;
+			maxWakeLatencySpeedWindow = 0.0f;
+		}
+	}
+
+	void FramePacer::endUpdate() {
+		auto now = Clock::now();
+
+		if (mode == Mode::RealTime) {
+			waitUntil(nextFrameDeadline);
+			return;
+		}
+
+		const bool isUncapped = (config.speedMultiplier <= 0.0f);
+		if (isUncapped) {
+			nextUpdateDeadline = now;
+			return;
+		}
+
+		// host updates at 60Hz - resynchronise if we've fallen more than a frame behind
+		nextUpdateDeadline += kFrameDuration;
+		if (nextUpdateDeadline + kFrameDuration < now) {
+			nextUpdateDeadline = now;
+		}
+
+		waitUntil(nextUpdateDeadline);
+	}
+
+	float FramePacer::getSpeed() const {
+		return speed;
+	}
+
+	const FramePacer::Stats& FramePacer::getStats() const {
+		return stats;
+	}
+
+	void FramePacer::waitUntil(Clock::time_point deadline) {
+		if (Clock::now() >= deadline) {
+			// already late - no need to wait
+			return;
+		}
+
+		if (config.waitMode == Config::WaitMode::Sleep) {
+			std::this_thread::sleep_until(deadline - std::chrono::microseconds(config.spinMicroseconds));
+		}
+
+		while (Clock::now() < deadline) {
+		}
+
+		const float latencyMicroseconds = std::chrono::duration<float, std::micro>(Clock::now() - deadline).count();
+
+		stats.numWaits += 1;
+		stats.meanWakeLatencyMicroseconds += (latencyMicroseconds - stats.meanWakeLatencyMicroseconds) * kWakeLatencySmoothing;
+		maxWakeLatencySpeedWindow = std::max(maxWakeLatencySpeedWindow, latencyMicroseconds);
+	}
+}
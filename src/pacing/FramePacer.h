@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace pacing {
+
+	/// @class FramePacer
+	/// @brief Decide how many emulated frames to run for each host update, and hold the host to real time
+	/// @note usage per host update: beginUpdate(), then onFrame() after each emulated frame, then endUpdate()
+	class FramePacer {
+	public:
+		FramePacer();
+		~FramePacer();
+
+		enum class Mode {
+			// emulated frames are locked to real time at 60 frames per second
+			// - when the host falls behind, several frames are run in one update, and only the last is rendered
+			RealTime,
+
+			// emulated frames run faster than real time - only the last frame of each update is rendered
+			FastForward
+		};
+
+		struct Config {
+			Config();
+
+			// FastForward: emulated speed as a multiple of real time, or 0 to run as fast as the host allows
+			float speedMultiplier;
+
+			// FastForward (uncapped): number of emulated frames per host update, so that only every Nth frame is rendered
+			uint32_t renderInterval;
+
+			// RealTime: maximum number of frames to run in one update, when catching up with real time
+			uint32_t maxCatchUpFrames;
+
+			// how to wait for the next update
+			// - Sleep: yield the core to the OS, waking at the deadline (minus spinMicroseconds)
+			// - Spin: poll the clock until the deadline (lowest jitter, but occupies a core)
+			enum class WaitMode {
+				Sleep,
+				Spin
+			};
+			WaitMode waitMode;
+
+			// Sleep: wake this long before the deadline, and spin for the remainder to reduce jitter
+			uint32_t spinMicroseconds;
+		};
+
+		void configure(const Config& config);
+		const Config& getConfig() const;
+
+		void setMode(Mode mode);
+		Mode getMode() const;
+
+		// start a host update - returns the number of emulated frames to run
+		uint32_t beginUpdate();
+
+		// report that an emulated frame has been completed
+		void onFrame();
+
+		// finish a host update - waits until the next host update is due
+		void endUpdate();
+
+		// achieved emulated speed as a multiple of real time, measured over recent updates
+		float getSpeed() const;
+
+		struct Stats {
+			Stats();
+
+			// frames that were run without being rendered, while catching up with real time
+			uint64_t numSkippedFrames;
+
+			// frames that were not run at all, because the host fell further behind than maxCatchUpFrames
+			uint64_t numLateFrames;
+
+			// time between a deadline and the host waking up for it, in microseconds
+			uint64_t numWaits;
+			float meanWakeLatencyMicroseconds;
+			float maxWakeLatencyMicroseconds;
+		};
+
+		const Stats& getStats() const;
+
+		// emulated frames per second
+		static const uint32_t kFramesPerSecond = 60;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		void waitUntil(Clock::time_point deadline);
+
+		Config config;
+		Mode mode;
+
+		Clock::time_point timeLastUpdate;
+		Clock::time_point nextUpdateDeadline;
+
+		// RealTime: time at which the next emulated frame is due
+		Clock::time_point nextFrameDeadline;
+
+		// fractional number of frames owed to FastForward with a speed multiplier
+		double frameAccumulator;
+
+		// speed measurement
+		Clock::time_point timeSpeedWindow;
+		uint32_t numFramesSpeedWindow;
+		float speed;
+
+		// maximum wake latency within the current speed window
+		float maxWakeLatencySpeedWindow;
+
+		Stats stats;
+	};
+}
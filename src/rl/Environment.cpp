@@ -0,0 +1,238 @@
+#include "rl/Environment.h"
+#include "rl/Game.h"
+#include "machine/Machine.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	uint64_t splitMix64(uint64_t& state) {
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// independent random sequence for each environment, derived from the seed
+	uint64_t getRandomState(uint64_t seed, size_t index) {
+		return seed ^ (uint64_t(index) * 0xd1b54a32d192ed03ull);
+	}
+}
+
+namespace rl {
+	Environment::Config::Config() :
+		numEnvironments(64),
+		engine(batch::BatchRunner::Engine::Scalar),
+		numThreads(0),
+		frameSkip(4),
+		maxNoopFrames(30),
+		observation(Observation::VideoRam)
+	{
+
+	}
+
+	Environment::Metrics::Metrics() :
+		numSteps(0),
+		numEpisodes(0),
+		seconds(0.0),
+		stepsPerSecond(0.0)
+	{
+
+	}
+
+	Environment::Environment() {
+
+	}
+
+	bool Environment::init(const char* romFilename, const Config& inConfig) {
+		config = inConfig;
+
+		if (!createStartSnapshots(romFilename)) {
+			return false;
+		}
+
+		batch::BatchRunner::Config runnerConfig;
+		runnerConfig.numMachines = config.numEnvironments;
+		runnerConfig.engine = config.engine;
+		runnerConfig.numThreads = config.numThreads;
+
+		if (!runner.init(romFilename, runnerConfig)) {
+			return false;
+		}
+
+		if ((config.observation == Observation::Stacked) && !preprocessor.init(config.preprocessor, config.numEnvironments)) {
+			return false;
+		}
+
+		videoRam.assign(config.numEnvironments * Preprocessor::kSizeVideoRam, 0);
+		randomStates.assign(config.numEnvironments, 0);
+		scores.assign(config.numEnvironments, 0);
+		isDone.assign(config.numEnvironments, 0);
+
+		metrics = Metrics();
+
+		reset(0, nullptr);
+
+		return true;
+	}
+
+	bool Environment::createStartSnapshots(const char* romFilename) {
+		machine::Machine machine;
+		if (!machine.init(romFilename)) {
+			return false;
+		}
+
+		if (!startGame(machine)) {
+			return false;
+		}
+
+		// one start snapshot for each number of no-op frames, so reset() is a single restore
+		startSnapshots.resize(size_t(config.maxNoopFrames) + 1);
+		for (machine::Snapshot& snapshot : startSnapshots) {
+			machine.snapshot(snapshot);
+			machine.runFrame();
+		}
+
+		return true;
+	}
+
+	size_t Environment::size() const {
+		return config.numEnvironments;
+	}
+
+	size_t Environment::getObservationSize() const {
+		return (config.observation == Observation::Stacked) ? preprocessor.getStackSize() : Preprocessor::kSizeVideoRam;
+	}
+
+	void Environment::reset(uint64_t seed, uint8_t* outObservations) {
+		for (size_t i = 0; i < config.numEnvironments; i++) {
+			randomStates[i] = getRandomState(seed, i);
+			startEpisode(i);
+		}
+
+		updateObservations(outObservations);
+	}
+
+	void Environment::reset(uint64_t seed, size_t begin, size_t end) {
+		assert((begin <= end) && (end <= config.numEnvironments));
+
+		for (size_t i = begin; i < end; i++) {
+			randomStates[i] = getRandomState(seed, i);
+			startEpisode(i);
+
+			readVideoRam(i);
+
+			if (config.observation == Observation::Stacked) {
+				preprocessor.reset(i, videoRam.data() + i * Preprocessor::kSizeVideoRam);
+			}
+		}
+	}
+
+	void Environment::startEpisode(size_t index) {
+		const size_t noopFrames = size_t(splitMix64(randomStates[index]) % startSnapshots.size());
+		runner.restore(index, startSnapshots[noopFrames]);
+
+		scores[index] = getScore(index);
+		isDone[index] = 0;
+
+		if (config.observation == Observation::Stacked) {
+			// frames from the previous episode are replaced by the first frame of this one
+			preprocessor.clear(index);
+		}
+	}
+
+	void Environment::step(const uint8_t* actions, uint8_t* outObservations, float* outRewards, uint8_t* outDones) {
+		assert(actions && outRewards && outDones);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < config.numEnvironments; i++) {
+			if (isDone[i]) {
+				startEpisode(i);
+				metrics.numEpisodes++;
+			}
+
+			runner.setInputPort(i, 1, getActionPort(actions[i]));
+		}
+
+		for (uint32_t frame = 0; frame < config.frameSkip; frame++) {
+			runner.runFrame();
+		}
+
+		for (size_t i = 0; i < config.numEnvironments; i++) {
+			const uint32_t score = getScore(i);
+
+			// 4 digit score wraps around at 10000
+			const uint32_t delta = (score >= scores[i]) ? (score - scores[i]) : (score + 10000 - scores[i]);
+			outRewards[i] = float(delta);
+			scores[i] = score;
+
+			isDone[i] = isGameOver(i) ? 1 : 0;
+			outDones[i] = isDone[i];
+		}
+
+		updateObservations(outObservations);
+
+		metrics.numSteps += config.numEnvironments;
+		metrics.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		metrics.stepsPerSecond = (metrics.seconds > 0.0) ? (double(metrics.numSteps) / metrics.seconds) : 0.0;
+	}
+
+	void Environment::readVideoRam(size_t index) {
+		runner.readRam(index, kAddressVideoRam, Preprocessor::kSizeVideoRam, videoRam.data() + index * Preprocessor::kSizeVideoRam);
+	}
+
+	void Environment::updateObservations(uint8_t* outObservations) {
+		for (size_t i = 0; i < config.numEnvironments; i++) {
+			readVideoRam(i);
+		}
+
+		if (config.observation == Observation::Stacked) {
+			preprocessor.push(videoRam.data());
+		}
+
+		if (outObservations) {
+			const size_t observationSize = getObservationSize();
+			for (size_t i = 0; i < config.numEnvironments; i++) {
+				memcpy(outObservations + i * observationSize, getObservation(i), observationSize);
+			}
+		}
+	}
+
+	const uint8_t* Environment::getObservation(size_t index) const {
+		assert(index < config.numEnvironments);
+		return (config.observation == Observation::Stacked) ? preprocessor.getStack(index) : (videoRam.data() + index * Preprocessor::kSizeVideoRam);
+	}
+
+	size_t Environment::getObservationStride() const {
+		return (config.observation == Observation::Stacked) ? preprocessor.getStackStride() : Preprocessor::kSizeVideoRam;
+	}
+
+	bool Environment::isGameOver(size_t index) const {
+		uint8_t gameMode = 0;
+		runner.readRam(index, kAddressGameMode, 1, &gameMode);
+		return gameMode == 0;
+	}
+
+	uint32_t Environment::getScore(size_t index) const {
+		uint8_t score[2] = {};
+		runner.readRam(index, kAddressScoreP1, 2, score);
+		return decodeScore(score);
+	}
+
+	uint8_t Environment::getShips(size_t index) const {
+		uint8_t ships = 0;
+		runner.readRam(index, kAddressShipsP1, 1, &ships);
+		return ships;
+	}
+
+	const Environment::Metrics& Environment::getMetrics() const {
+		return metrics;
+	}
+
+	const batch::BatchRunner& Environment::getBatchRunner() const {
+		return runner;
+	}
+}
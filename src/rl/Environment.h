@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "batch/BatchRunner.h"
+#include "machine/Snapshot.h"
+#include "rl/Game.h"
+#include "rl/Preprocessor.h"
+
+namespace rl {
+
+	// observation returned for each environment
+	enum class Observation : uint8_t {
+		VideoRam,	// raw 1bpp video RAM, 224 columns of 256 pixels (32 bytes), bottom to top
+		Stacked		// the most recent frames, downsampled to grayscale (see Preprocessor)
+	};
+
+	/// @class Environment
+	/// @brief Reinforcement learning environment - a batch of Space Invaders games, stepped together
+	/// @note every episode starts from a game in progress (coin inserted, 1 player game started), after a
+	///       random number of no-op frames chosen from the seed. Reward is the increase in player 1 score,
+	///       and an episode is done when the game is over (all lives lost).
+	///
+	///       Observations, rewards + dones are written to caller owned buffers with one entry per environment,
+	///       so a batch can be passed straight to a training framework without copies.
+	class Environment {
+	public:
+		/// @struct Config
+		/// @brief Size of the batch, and how each step is run
+		struct Config {
+			Config();
+
+			size_t numEnvironments;
+
+			batch::BatchRunner::Engine engine;
+
+			// number of worker threads - 0 uses one thread per hardware thread
+			size_t numThreads;
+
+			// number of frames each action is held for
+			uint32_t frameSkip;
+
+			// maximum number of no-op frames at the start of an episode
+			uint32_t maxNoopFrames;
+
+			Observation observation;
+
+			// frame size + stack size, for Observation::Stacked
+			Preprocessor::Config preprocessor;
+		};
+
+		/// @struct Metrics
+		/// @brief Throughput of the environment, in environment steps (one action for one environment)
+		struct Metrics {
+			Metrics();
+
+			uint64_t numSteps;
+			uint64_t numEpisodes;
+			double seconds;
+			double stepsPerSecond;
+		};
+
+		Environment();
+
+		bool init(const char* romFilename, const Config& config);
+
+		size_t size() const;
+
+		// bytes in the observation of one environment
+		size_t getObservationSize() const;
+
+		// start a new episode in every environment - seed chooses the number of no-op frames for each one
+		// - outObservations receives size() * getObservationSize() bytes, and may be null
+		void reset(uint64_t seed, uint8_t* outObservations);
+
+		// start a new episode in environments [begin, end) only, updating their observations - seed chooses
+		// the number of no-op frames in the same way as reset(), so the same seed gives the same episodes
+		void reset(uint64_t seed, size_t begin, size_t end);
+
+		// hold actions[i] (see Action) in each environment for frameSkip frames
+		// - outRewards receives the score gained by each environment during the step
+		// - outDones receives 1 for each environment whose game ended during the step - that environment
+		//   starts a new episode at the beginning of its next step (the observation is from the new episode)
+		// - outObservations receives size() * getObservationSize() bytes, and may be null
+		void step(const uint8_t* actions, uint8_t* outObservations, float* outRewards, uint8_t* outDones);
+
+		// observation of an environment after the last reset() or step(), without a copy - observations of
+		// consecutive environments are getObservationStride() bytes apart
+		const uint8_t* getObservation(size_t index) const;
+		size_t getObservationStride() const;
+
+		// current player 1 score + number of ships in reserve for an environment
+		uint32_t getScore(size_t index) const;
+		uint8_t getShips(size_t index) const;
+
+		const Metrics& getMetrics() const;
+
+		// access to the underlying batch (i.e. for preprocessing observations)
+		const batch::BatchRunner& getBatchRunner() const;
+
+	private:
+		bool createStartSnapshots(const char* romFilename);
+		void startEpisode(size_t index);
+		void readVideoRam(size_t index);
+		void updateObservations(uint8_t* outObservations);
+		bool isGameOver(size_t index) const;
+
+		Config config;
+
+		batch::BatchRunner runner;
+
+		// snapshots of a new game, after 0 .. maxNoopFrames no-op frames
+		std::vector<machine::Snapshot> startSnapshots;
+
+		// video RAM of every environment, read after each step
+		std::vector<uint8_t> videoRam;
+
+		Preprocessor preprocessor;
+
+		std::vector<uint64_t> randomStates;
+		std::vector<uint32_t> scores;
+		std::vector<uint8_t> isDone;
+
+		Metrics metrics;
+	};
+}
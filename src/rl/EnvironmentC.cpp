@@ -0,0 +1,128 @@
+#include "rl/EnvironmentC.h"
+#include "rl/Environment.h"
+#include "rl/SharedEnvironment.h"
+
+struct si_env {
+	rl::Environment environment;
+};
+
+struct si_env_client {
+	rl::SharedEnvironmentClient client;
+};
+
+extern "C" {
+	void si_env_default_config(si_env_config* config) {
+		const rl::Environment::Config defaults;
+
+		config->num_environments = defaults.numEnvironments;
+		config->engine = (defaults.engine == batch::BatchRunner::Engine::Lockstep) ? 1 : 0;
+		config->num_threads = defaults.numThreads;
+		config->frame_skip = defaults.frameSkip;
+		config->max_noop_frames = defaults.maxNoopFrames;
+		config->observation = (defaults.observation == rl::Observation::Stacked) ? 1 : 0;
+		config->observation_width = defaults.preprocessor.width;
+		config->observation_height = defaults.preprocessor.height;
+		config->stack_size = defaults.preprocessor.stackSize;
+	}
+
+	si_env* si_env_create(const char* rom_filename, const si_env_config* config) {
+		rl::Environment::Config environmentConfig;
+		if (config) {
+			environmentConfig.numEnvironments = config->num_environments;
+			environmentConfig.engine = (config->engine == 1) ? batch::BatchRunner::Engine::Lockstep : batch::BatchRunner::Engine::Scalar;
+			environmentConfig.numThreads = config->num_threads;
+			environmentConfig.frameSkip = config->frame_skip;
+			environmentConfig.maxNoopFrames = config->max_noop_frames;
+			environmentConfig.observation = (config->observation == 1) ? rl::Observation::Stacked : rl::Observation::VideoRam;
+			environmentConfig.preprocessor.width = config->observation_width;
+			environmentConfig.preprocessor.height = config->observation_height;
+			environmentConfig.preprocessor.stackSize = config->stack_size;
+		}
+
+		si_env* env = new si_env();
+		if (!env->environment.init(rom_filename, environmentConfig)) {
+			delete env;
+			return nullptr;
+		}
+
+		return env;
+	}
+
+	void si_env_destroy(si_env* env) {
+		delete env;
+	}
+
+	size_t si_env_size(const si_env* env) {
+		return env->environment.size();
+	}
+
+	size_t si_env_observation_size(const si_env* env) {
+		return env->environment.getObservationSize();
+	}
+
+	size_t si_env_num_actions(void) {
+		return rl::kNumActions;
+	}
+
+	void si_env_reset(si_env* env, uint64_t seed, uint8_t* observations) {
+		env->environment.reset(seed, observations);
+	}
+
+	void si_env_step(si_env* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones) {
+		env->environment.step(actions, observations, rewards, dones);
+	}
+
+	const uint8_t* si_env_observations(const si_env* env, size_t* stride) {
+		if (stride) {
+			*stride = env->environment.getObservationStride();
+		}
+
+		return env->environment.getObservation(0);
+	}
+
+	si_env_client* si_env_client_open(const char* name, size_t slice) {
+		si_env_client* client = new si_env_client();
+		if (!client->client.open(name, slice)) {
+			delete client;
+			return nullptr;
+		}
+
+		return client;
+	}
+
+	void si_env_client_close(si_env_client* client) {
+		delete client;
+	}
+
+	size_t si_env_client_size(const si_env_client* client) {
+		return client->client.size();
+	}
+
+	size_t si_env_client_observation_size(const si_env_client* client) {
+		return client->client.getObservationSize();
+	}
+
+	uint8_t* si_env_client_actions(si_env_client* client) {
+		return client->client.getActions();
+	}
+
+	const uint8_t* si_env_client_observations(const si_env_client* client) {
+		return client->client.getObservations();
+	}
+
+	const float* si_env_client_rewards(const si_env_client* client) {
+		return client->client.getRewards();
+	}
+
+	const uint8_t* si_env_client_dones(const si_env_client* client) {
+		return client->client.getDones();
+	}
+
+	int si_env_client_reset(si_env_client* client, uint64_t seed) {
+		return client->client.reset(seed) ? 1 : 0;
+	}
+
+	int si_env_client_step(si_env_client* client) {
+		return client->client.step() ? 1 : 0;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// C interface to rl::Environment, for use from other languages (i.e. Python via ctypes / cffi)
+// - define SI_ENV_EXPORTS to export the functions from a Windows DLL, otherwise link statically
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SI_ENV_EXPORTS)
+	#define SI_ENV_API __declspec(dllexport)
+#elif defined(__GNUC__)
+	#define SI_ENV_API __attribute__((visibility("default")))
+#else
+	#define SI_ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct si_env si_env;
+
+typedef struct si_env_config {
+	size_t num_environments;
+	int engine;				// 0 = scalar, 1 = lockstep
+	size_t num_threads;		// 0 = one thread per hardware thread
+	uint32_t frame_skip;
+	uint32_t max_noop_frames;
+	int observation;		// 0 = raw 1bpp video RAM, 1 = stacked grayscale frames
+	uint16_t observation_width;
+	uint16_t observation_height;
+	uint32_t stack_size;
+} si_env_config;
+
+// fill config with the default settings
+SI_ENV_API void si_env_default_config(si_env_config* config);
+
+// create a batch of environments running the ROM loaded from rom_filename - returns NULL on failure
+SI_ENV_API si_env* si_env_create(const char* rom_filename, const si_env_config* config);
+SI_ENV_API void si_env_destroy(si_env* env);
+
+SI_ENV_API size_t si_env_size(const si_env* env);
+SI_ENV_API size_t si_env_observation_size(const si_env* env);
+SI_ENV_API size_t si_env_num_actions(void);
+
+// start a new episode in every environment - observations receives si_env_size() * si_env_observation_size() bytes,
+// and may be NULL
+SI_ENV_API void si_env_reset(si_env* env, uint64_t seed, uint8_t* observations);
+
+// step every environment with one action each - see rl::Environment::step()
+SI_ENV_API void si_env_step(si_env* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+// observations of the whole batch after the last reset / step, without a copy - the observation of environment i
+// starts at i * stride bytes (i.e. wrap as a strided array), and is only valid until the next reset / step
+SI_ENV_API const uint8_t* si_env_observations(const si_env* env, size_t* stride);
+
+// client for a batch of environments served by another process through shared memory (see
+// rl::SharedEnvironmentServer) - each client owns one slice of the batch
+typedef struct si_env_client si_env_client;
+
+// attach to a slice of the shared environment called name - returns NULL on failure
+SI_ENV_API si_env_client* si_env_client_open(const char* name, size_t slice);
+SI_ENV_API void si_env_client_close(si_env_client* client);
+
+SI_ENV_API size_t si_env_client_size(const si_env_client* client);
+SI_ENV_API size_t si_env_client_observation_size(const si_env_client* client);
+
+// buffers for the slice, in shared memory - write actions before each step, read the others after it
+SI_ENV_API uint8_t* si_env_client_actions(si_env_client* client);
+SI_ENV_API const uint8_t* si_env_client_observations(const si_env_client* client);
+SI_ENV_API const float* si_env_client_rewards(const si_env_client* client);
+SI_ENV_API const uint8_t* si_env_client_dones(const si_env_client* client);
+
+// returns 0 if the server has shut down
+SI_ENV_API int si_env_client_reset(si_env_client* client, uint64_t seed);
+SI_ENV_API int si_env_client_step(si_env_client* client);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+#include "rl/Game.h"
+#include "machine/Machine.h"
+
+#include <cstdio>
+
+namespace {
+	const uint8_t kActionPorts[rl::kNumActions] = {
+		rl::kPort1Default,
+		rl::kPort1Default | rl::kPort1Fire,
+		rl::kPort1Default | rl::kPort1Left,
+		rl::kPort1Default | rl::kPort1Right,
+		rl::kPort1Default | rl::kPort1Left | rl::kPort1Fire,
+		rl::kPort1Default | rl::kPort1Right | rl::kPort1Fire,
+	};
+
+	// frames to wait for each stage of starting a game before giving up
+	const uint32_t kMaxStartFrames = 600;
+
+	uint32_t decodeBcd(uint8_t value) {
+		return uint32_t(value >> 4) * 10 + (value & 0x0f);
+	}
+
+	uint8_t read(const machine::Machine& machine, uint16_t address) {
+		const memory::Memory& memory = machine.getMemory();
+		return memory.read(memory.translate(address));
+	}
+
+	// run frames until condition returns true, or give up after kMaxStartFrames
+	template<typename Condition>
+	bool runUntil(machine::Machine& machine, Condition condition) {
+		for (uint32_t i = 0; i < kMaxStartFrames; i++) {
+			if (condition()) {
+				return true;
+			}
+			machine.runFrame();
+		}
+
+		return false;
+	}
+}
+
+namespace rl {
+	uint8_t getActionPort(uint8_t action) {
+		return kActionPorts[(action < kNumActions) ? action : uint8_t(Action::Noop)];
+	}
+
+	bool startGame(machine::Machine& machine) {
+		// wait for the attract mode to settle, then insert a coin - ports power on as 0, which reads as the
+		// coin switch held closed, so release it first
+		machine.setInputPort(1, kPort1Default);
+		for (uint32_t i = 0; i < 30; i++) {
+			machine.runFrame();
+		}
+
+		machine.setInputPort(1, kPort1Default & ~kPort1Coin);
+		for (uint32_t i = 0; i < 4; i++) {
+			machine.runFrame();
+		}
+		machine.setInputPort(1, kPort1Default);
+
+		if (!runUntil(machine, [&machine]() { return read(machine, kAddressCredits) != 0; })) {
+			printf("startGame - coin was not accepted\n");
+			return false;
+		}
+
+		// start is only read once the game has shown the credit, so hold it until the game starts
+		machine.setInputPort(1, kPort1Default | kPort1Start);
+		if (!runUntil(machine, [&machine]() { return read(machine, kAddressGameMode) != 0; })) {
+			printf("startGame - game did not start\n");
+			return false;
+		}
+		machine.setInputPort(1, kPort1Default);
+
+		if (!runUntil(machine, [&machine]() { return read(machine, kAddressShipsP1) != kShipsNotSet; })) {
+			printf("startGame - ships were not set up\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	uint32_t decodeScore(const uint8_t score[2]) {
+		return decodeBcd(score[1]) * 100 + decodeBcd(score[0]);
+	}
+
+	uint32_t getScore(const machine::Machine& machine) {
+		const uint8_t score[2] = { read(machine, kAddressScoreP1), read(machine, kAddressScoreP1 + 1) };
+		return decodeScore(score);
+	}
+
+	uint8_t getShips(const machine::Machine& machine) {
+		return read(machine, kAddressShipsP1);
+	}
+
+	bool isGameOver(const machine::Machine& machine) {
+		return read(machine, kAddressGameMode) == 0;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace machine {
+	class Machine;
+}
+
+namespace rl {
+	// Space Invaders RAM addresses
+	const uint16_t kAddressCredits = 0x20eb;
+	const uint16_t kAddressGameMode = 0x20ef;	// 1 while a game is in play
+	const uint16_t kAddressScoreP1 = 0x20f8;	// 2 bytes BCD, LSB first
+	const uint16_t kAddressShipsP1 = 0x21ff;
+	const uint16_t kAddressVideoRam = 0x2400;
+
+	// ships are not set up until a few frames after a game starts
+	const uint8_t kShipsNotSet = 0xfe;
+
+	// input port 1 - bit 3 is always set, coin bit is 0 while the coin switch is closed
+	const uint8_t kPort1Default = (1 << 3) | (1 << 0);
+	const uint8_t kPort1Coin = (1 << 0);
+	const uint8_t kPort1Start = (1 << 2);
+	const uint8_t kPort1Fire = (1 << 4);
+	const uint8_t kPort1Left = (1 << 5);
+	const uint8_t kPort1Right = (1 << 6);
+
+	// actions available to the agent, mapped to the player 1 controls
+	enum class Action : uint8_t {
+		Noop,
+		Fire,
+		Left,
+		Right,
+		LeftFire,
+		RightFire
+	};
+
+	const size_t kNumActions = 6;
+
+	// value of input port 1 while action is held - out of range actions are a no-op
+	uint8_t getActionPort(uint8_t action);
+
+	// insert a coin and start a 1 player game on a machine that has just been initialised, running until the
+	// player's ships are set up - returns false if the game did not start
+	bool startGame(machine::Machine& machine);
+
+	// player 1 score, from the two BCD bytes at kAddressScoreP1
+	uint32_t decodeScore(const uint8_t score[2]);
+
+	// player 1 score, ships in reserve, and whether the game is over, read from the RAM of machine
+	uint32_t getScore(const machine::Machine& machine);
+	uint8_t getShips(const machine::Machine& machine);
+	bool isGameOver(const machine::Machine& machine);
+}
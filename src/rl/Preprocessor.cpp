@@ -0,0 +1,196 @@
+#include "rl/Preprocessor.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	// each byte of video RAM expanded to 8 bytes of 0 / 1, top pixel first - bit 7 is the highest pixel
+	struct ExpandTable {
+		ExpandTable() {
+			for (int value = 0; value < 256; value++) {
+				for (int i = 0; i < 8; i++) {
+					pixels[value][i] = uint8_t((value >> (7 - i)) & 1);
+				}
+			}
+		}
+
+		uint8_t pixels[256][8];
+	};
+
+	const ExpandTable kExpandTable;
+
+	const uint16_t kBytesPerColumn = rl::Preprocessor::kScreenHeight / 8;
+
+	// add a column of video RAM (bottom to top) to the number of lit pixels in each screen row (top to bottom)
+	// - each byte expands to 8 pixel counts, which are added 8 at a time as a 64 bit value. A count is at most
+	//   the screen width (224), so the bytes never carry into each other
+	void addColumn(const uint8_t* column, uint8_t* counts) {
+		for (uint16_t i = 0; i < kBytesPerColumn; i++) {
+			uint8_t* rows = counts + (kBytesPerColumn - 1 - i) * 8;
+
+			uint64_t pixels;
+			uint64_t total;
+			memcpy(&pixels, kExpandTable.pixels[column[i]], 8);
+			memcpy(&total, rows, 8);
+			total += pixels;
+			memcpy(rows, &total, 8);
+		}
+	}
+}
+
+namespace rl {
+	Preprocessor::Config::Config() :
+		width(84),
+		height(84),
+		stackSize(4)
+	{
+
+	}
+
+	Preprocessor::Preprocessor() :
+		numMachines(0),
+		numPushes(0)
+	{
+
+	}
+
+	bool Preprocessor::init(const Config& inConfig, size_t inNumMachines) {
+		config = inConfig;
+		numMachines = inNumMachines;
+
+		if ((config.width == 0) || (config.width > kScreenWidth) || (config.height == 0) || (config.height > kScreenHeight)) {
+			printf("Preprocessor - unsupported frame size %ux%u (maximum %ux%u)\n", config.width, config.height, kScreenWidth, kScreenHeight);
+			return false;
+		}
+
+		if (config.stackSize == 0) {
+			printf("Preprocessor - stack size must be at least 1\n");
+			return false;
+		}
+
+		columnBegin.resize(size_t(config.width) + 1);
+		for (size_t i = 0; i <= config.width; i++) {
+			columnBegin[i] = uint16_t(i * kScreenWidth / config.width);
+		}
+
+		rowBegin.resize(size_t(config.height) + 1);
+		for (size_t i = 0; i <= config.height; i++) {
+			rowBegin[i] = uint16_t(i * kScreenHeight / config.height);
+		}
+
+		// round the scale up, so a fully lit area is 255
+		scales.resize(getFrameSize());
+		for (size_t y = 0; y < config.height; y++) {
+			for (size_t x = 0; x < config.width; x++) {
+				const uint32_t area = uint32_t(columnBegin[x + 1] - columnBegin[x]) * uint32_t(rowBegin[y + 1] - rowBegin[y]);
+				scales[y * config.width + x] = ((255u << 16) + area - 1) / area;
+			}
+		}
+
+		frames.assign(numMachines * getStackStride(), 0);
+		isCleared.assign(numMachines, 1);
+		numPushes = 0;
+
+		return true;
+	}
+
+	size_t Preprocessor::size() const {
+		return numMachines;
+	}
+
+	void Preprocessor::process(const uint8_t* videoRam, uint8_t* outFrame) const {
+		uint8_t counts[kScreenHeight];
+
+		for (size_t x = 0; x < config.width; x++) {
+			// number of lit pixels in each screen row, over the screen columns of this output column
+			memset(counts, 0, sizeof(counts));
+
+			for (uint16_t column = columnBegin[x]; column < columnBegin[x + 1]; column++) {
+				addColumn(videoRam + column * kBytesPerColumn, counts);
+			}
+
+			for (size_t y = 0; y < config.height; y++) {
+				uint32_t count = 0;
+				for (uint16_t row = rowBegin[y]; row < rowBegin[y + 1]; row++) {
+					count += counts[row];
+				}
+
+				const size_t offset = y * config.width + x;
+				outFrame[offset] = uint8_t((count * scales[offset]) >> 16);
+			}
+		}
+	}
+
+	void Preprocessor::push(const uint8_t* videoRam) {
+		const size_t frameSize = getFrameSize();
+		const size_t slot = size_t(numPushes % config.stackSize);
+
+		for (size_t i = 0; i < numMachines; i++) {
+			uint8_t* ring = frames.data() + i * getStackStride();
+			uint8_t* frame = ring + slot * frameSize;
+
+			process(videoRam + i * kSizeVideoRam, frame);
+
+			if (isCleared[i]) {
+				// no history yet, so every frame in the stack is the new frame
+				for (size_t j = 0; j < 2 * size_t(config.stackSize); j++) {
+					if (j != slot) {
+						memcpy(ring + j * frameSize, frame, frameSize);
+					}
+				}
+
+				isCleared[i] = 0;
+			}
+			else {
+				memcpy(frame + config.stackSize * frameSize, frame, frameSize);
+			}
+		}
+
+		numPushes++;
+	}
+
+	void Preprocessor::clear(size_t index) {
+		assert(index < numMachines);
+		isCleared[index] = 1;
+	}
+
+	void Preprocessor::reset(size_t index, const uint8_t* videoRam) {
+		assert(index < numMachines);
+
+		const size_t frameSize = getFrameSize();
+		uint8_t* ring = frames.data() + index * getStackStride();
+
+		process(videoRam, ring);
+		for (size_t j = 1; j < 2 * size_t(config.stackSize); j++) {
+			memcpy(ring + j * frameSize, ring, frameSize);
+		}
+
+		isCleared[index] = 0;
+	}
+
+	const uint8_t* Preprocessor::getStack(size_t index) const {
+		assert(index < numMachines);
+
+		// most recent frame is in slot (numPushes - 1) % stackSize and the same slot + stackSize, so the stack
+		// starts at the slot after the first copy
+		const size_t slot = size_t((numPushes + config.stackSize - 1) % config.stackSize) + 1;
+		return frames.data() + index * getStackStride() + slot * getFrameSize();
+	}
+
+	size_t Preprocessor::getStackStride() const {
+		return 2 * getStackSize();
+	}
+
+	size_t Preprocessor::getFrameSize() const {
+		return size_t(config.width) * config.height;
+	}
+
+	size_t Preprocessor::getStackSize() const {
+		return getFrameSize() * config.stackSize;
+	}
+
+	const Preprocessor::Config& Preprocessor::getConfig() const {
+		return config;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rl {
+
+	/// @class Preprocessor
+	/// @brief Convert the 1bpp video RAM of a batch of machines into downsampled grayscale frames, stacked
+	///        with the most recent frames of each machine
+	/// @note video RAM holds 224 columns of 256 pixels, bottom to top - each frame is rotated upright, and each
+	///       output pixel is the fraction of lit pixels in its area of the screen (0 - 255). Bits are expanded
+	///       with a lookup table and summed 8 pixels at a time in 64 bit words, without a per pixel pass.
+	///
+	///       Each machine has a ring buffer of 2 * stackSize frames, and every frame is written twice (at slot i
+	///       and i + stackSize), so the most recent stackSize frames are always contiguous, oldest first. Every
+	///       machine is pushed at the same time, so the stacks of a batch are a single strided array - one
+	///       stack every getStackStride() bytes, starting at getStack(0).
+	class Preprocessor {
+	public:
+		/// @struct Config
+		/// @brief Size of each output frame, and how many frames are stacked
+		struct Config {
+			Config();
+
+			// output frame size, up to the 224x256 size of the screen
+			uint16_t width;
+			uint16_t height;
+
+			// number of frames in each stack
+			uint32_t stackSize;
+		};
+
+		// size of the video RAM of a machine
+		static const uint16_t kSizeVideoRam = 0x1c00;
+
+		// size of the screen, after rotating it upright
+		static const uint16_t kScreenWidth = 224;
+		static const uint16_t kScreenHeight = 256;
+
+		Preprocessor();
+
+		bool init(const Config& config, size_t numMachines);
+
+		size_t size() const;
+
+		// preprocess one frame for every machine, from numMachines * kSizeVideoRam bytes of video RAM
+		void push(const uint8_t* videoRam);
+
+		// fill the whole stack of a machine with its next pushed frame (i.e. at the start of an episode)
+		void clear(size_t index);
+
+		// fill the whole stack of a machine with one frame of kSizeVideoRam bytes of video RAM, without a push
+		// (i.e. when one machine starts an episode between pushes)
+		void reset(size_t index, const uint8_t* videoRam);
+
+		// most recent stackSize frames of a machine, oldest first, each height rows of width pixels
+		// - only valid until the next push()
+		const uint8_t* getStack(size_t index) const;
+
+		// bytes between the stacks of consecutive machines
+		size_t getStackStride() const;
+
+		// bytes in one frame + one stack
+		size_t getFrameSize() const;
+		size_t getStackSize() const;
+
+		const Config& getConfig() const;
+
+		// preprocess a single frame of video RAM into width * height bytes
+		void process(const uint8_t* videoRam, uint8_t* outFrame) const;
+
+	private:
+		Config config;
+		size_t numMachines;
+
+		// first screen column + row of each output column + row, with an extra entry for the end of the last
+		std::vector<uint16_t> columnBegin;
+		std::vector<uint16_t> rowBegin;
+
+		// 16.16 fixed point scale from number of lit pixels to 0 - 255, for each output pixel
+		std::vector<uint32_t> scales;
+
+		// ring buffers of 2 * stackSize frames for every machine
+		std::vector<uint8_t> frames;
+		std::vector<uint8_t> isCleared;
+		uint64_t numPushes;
+	};
+}
@@ -0,0 +1,409 @@
+#include "rl/SharedEnvironment.h"
+#include "rl/Environment.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace {
+	const uint32_t kMagic = 0x56454953;	// 'SIEV'
+	const uint32_t kVersion = 2;
+
+	const size_t kMaxSlices = 64;
+
+	// sections of the shared region start on a cache line
+	const size_t kAlignment = 64;
+
+	// longest wait before checking for shutdown
+	const uint32_t kWaitMilliseconds = 100;
+
+	enum Command : uint32_t {
+		kCommandStep,
+		kCommandReset
+	};
+
+	// one slice of the batch, owned by one client - aligned so clients don't share cache lines
+	struct alignas(64) SharedSlice {
+		// process id of the client that owns the slice, or 0 when no client is attached
+		std::atomic<uint32_t> owner;
+
+		// request is bumped by the client after writing command + seed, response by the server when served
+		std::atomic<uint32_t> requestSequence;
+		std::atomic<uint32_t> responseSequence;
+
+		uint32_t command;
+		uint64_t seed;
+
+		uint64_t begin;
+		uint64_t count;
+	};
+
+	struct SharedHeader {
+		uint32_t magic;
+		uint32_t version;
+
+		uint64_t numEnvironments;
+		uint64_t numSlices;
+		uint64_t observationSize;
+
+		// offsets from the start of the region - one entry per environment
+		uint64_t offsetObservations;
+		uint64_t offsetRewards;
+		uint64_t offsetDones;
+		uint64_t offsetActions;
+
+		// bumped by clients whenever the server has something to do
+		std::atomic<uint32_t> serverSignal;
+		std::atomic<uint32_t> isShutdown;
+
+		SharedSlice slices[kMaxSlices];
+	};
+
+	size_t align(size_t offset) {
+		return (offset + kAlignment - 1) & ~(kAlignment - 1);
+	}
+
+	SharedHeader* getHeader(const util::SharedMemory& sharedMemory) {
+		return reinterpret_cast<SharedHeader*>(sharedMemory.data());
+	}
+
+	void signalServer(SharedHeader* header) {
+		header->serverSignal.fetch_add(1, std::memory_order_release);
+		util::wakeAddress(header->serverSignal);
+	}
+}
+
+namespace rl {
+	SharedEnvironmentServer::SharedEnvironmentServer() :
+		environment(nullptr),
+		numSlices(0),
+		numServed(0)
+	{
+
+	}
+
+	SharedEnvironmentServer::~SharedEnvironmentServer() {
+		shutdown();
+	}
+
+	bool SharedEnvironmentServer::init(const char* name, size_t inNumSlices, Environment* inEnvironment) {
+		assert(inEnvironment);
+
+		environment = inEnvironment;
+		numSlices = inNumSlices;
+		numServed = 0;
+
+		const size_t numEnvironments = environment->size();
+		if ((numSlices == 0) || (numSlices > kMaxSlices) || (numSlices > numEnvironments)) {
+			printf("SharedEnvironmentServer - unsupported number of slices %zu (1 - %zu, and no more than %zu environments)\n", numSlices, kMaxSlices, numEnvironments);
+			return false;
+		}
+
+		const size_t observationSize = environment->getObservationSize();
+
+		const size_t offsetObservations = align(sizeof(SharedHeader));
+		const size_t offsetRewards = align(offsetObservations + numEnvironments * observationSize);
+		const size_t offsetDones = align(offsetRewards + numEnvironments * sizeof(float));
+		const size_t offsetActions = align(offsetDones + numEnvironments);
+		const size_t size = align(offsetActions + numEnvironments);
+
+		if (!sharedMemory.create(name, size)) {
+			return false;
+		}
+
+		SharedHeader* header = new (sharedMemory.data()) SharedHeader();
+		header->magic = kMagic;
+		header->version = kVersion;
+		header->numEnvironments = numEnvironments;
+		header->numSlices = numSlices;
+		header->observationSize = observationSize;
+		header->offsetObservations = offsetObservations;
+		header->offsetRewards = offsetRewards;
+		header->offsetDones = offsetDones;
+		header->offsetActions = offsetActions;
+
+		for (size_t i = 0; i < numSlices; i++) {
+			SharedSlice& slice = header->slices[i];
+			slice.begin = i * numEnvironments / numSlices;
+			slice.count = ((i + 1) * numEnvironments / numSlices) - slice.begin;
+		}
+
+		actions.assign(numEnvironments, uint8_t(Action::Noop));
+
+		// observations of the episodes started by Environment::init()
+		writeObservations();
+
+		return true;
+	}
+
+	bool SharedEnvironmentServer::serve(uint32_t timeoutMilliseconds) {
+		if (!sharedMemory.data()) {
+			return false;
+		}
+
+		SharedHeader* header = getHeader(sharedMemory);
+		const uint32_t signal = header->serverSignal.load(std::memory_order_acquire);
+
+		// the batch is stepped together, so wait for a request from every attached slice
+		uint32_t requests[kMaxSlices];
+		bool isRequested[kMaxSlices];
+		size_t numRequests = 0;
+		bool isWaiting = false;
+
+		for (size_t i = 0; i < numSlices; i++) {
+			SharedSlice& slice = header->slices[i];
+
+			requests[i] = slice.requestSequence.load(std::memory_order_acquire);
+			isRequested[i] = (requests[i] != slice.responseSequence.load(std::memory_order_relaxed));
+
+			if (isRequested[i]) {
+				numRequests++;
+				continue;
+			}
+
+			uint32_t owner = slice.owner.load(std::memory_order_acquire);
+			if (owner == 0) {
+				continue;
+			}
+
+			// a client that exited without detaching (i.e. crashed) would be waited for forever, so detach it
+			if (!util::isProcessRunning(owner)) {
+				if (slice.owner.compare_exchange_strong(owner, 0)) {
+					printf("SharedEnvironmentServer - client of slice %zu (process %u) has exited, detached it\n", i, owner);
+				}
+				continue;
+			}
+
+			isWaiting = true;
+		}
+
+		if ((numRequests == 0) || isWaiting) {
+			util::waitOnAddress(header->serverSignal, signal, timeoutMilliseconds);
+			return false;
+		}
+
+		uint8_t* sharedActions = sharedMemory.data() + header->offsetActions;
+		float* rewards = reinterpret_cast<float*>(sharedMemory.data() + header->offsetRewards);
+		uint8_t* dones = sharedMemory.data() + header->offsetDones;
+
+		// slices that are resetting, or have no request, are stepped with no-ops
+		bool isStep = false;
+		for (size_t i = 0; i < numSlices; i++) {
+			const SharedSlice& slice = header->slices[i];
+
+			if (isRequested[i] && (slice.command == kCommandStep)) {
+				memcpy(actions.data() + slice.begin, sharedActions + slice.begin, slice.count);
+				isStep = true;
+			}
+			else {
+				memset(actions.data() + slice.begin, uint8_t(Action::Noop), slice.count);
+			}
+		}
+
+		if (isStep) {
+			environment->step(actions.data(), nullptr, rewards, dones);
+		}
+
+		// resets are applied after the step, so the reset environments start from the first frame of an episode
+		for (size_t i = 0; i < numSlices; i++) {
+			const SharedSlice& slice = header->slices[i];
+
+			if (isRequested[i] && (slice.command == kCommandReset)) {
+				environment->reset(slice.seed, slice.begin, slice.begin + slice.count);
+
+				memset(rewards + slice.begin, 0, slice.count * sizeof(float));
+				memset(dones + slice.begin, 0, slice.count);
+			}
+		}
+
+		writeObservations();
+
+		for (size_t i = 0; i < numSlices; i++) {
+			if (isRequested[i]) {
+				SharedSlice& slice = header->slices[i];
+				slice.responseSequence.store(requests[i], std::memory_order_release);
+				util::wakeAddress(slice.responseSequence);
+			}
+		}
+
+		numServed++;
+
+		return true;
+	}
+
+	void SharedEnvironmentServer::writeObservations() {
+		SharedHeader* header = getHeader(sharedMemory);
+		uint8_t* observations = sharedMemory.data() + header->offsetObservations;
+
+		const size_t observationSize = environment->getObservationSize();
+		for (size_t i = 0; i < environment->size(); i++) {
+			memcpy(observations + i * observationSize, environment->getObservation(i), observationSize);
+		}
+	}
+
+	void SharedEnvironmentServer::shutdown() {
+		if (!sharedMemory.data()) {
+			return;
+		}
+
+		SharedHeader* header = getHeader(sharedMemory);
+		header->isShutdown.store(1, std::memory_order_release);
+
+		for (size_t i = 0; i < numSlices; i++) {
+			util::wakeAddress(header->slices[i].responseSequence);
+		}
+
+		sharedMemory.close();
+	}
+
+	size_t SharedEnvironmentServer::getNumSlices() const {
+		return numSlices;
+	}
+
+	size_t SharedEnvironmentServer::getNumAttached() const {
+		if (!sharedMemory.data()) {
+			return 0;
+		}
+
+		const SharedHeader* header = getHeader(sharedMemory);
+
+		size_t numAttached = 0;
+		for (size_t i = 0; i < numSlices; i++) {
+			numAttached += (header->slices[i].owner.load(std::memory_order_acquire) != 0) ? 1 : 0;
+		}
+
+		return numAttached;
+	}
+
+	uint64_t SharedEnvironmentServer::getNumServed() const {
+		return numServed;
+	}
+
+	SharedEnvironmentClient::SharedEnvironmentClient() :
+		sliceIndex(0)
+	{
+
+	}
+
+	SharedEnvironmentClient::~SharedEnvironmentClient() {
+		close();
+	}
+
+	bool SharedEnvironmentClient::open(const char* name, size_t inSliceIndex) {
+		close();
+
+		if (!sharedMemory.open(name)) {
+			return false;
+		}
+
+		SharedHeader* header = getHeader(sharedMemory);
+		if ((sharedMemory.size() < sizeof(SharedHeader)) || (header->magic != kMagic) || (header->version != kVersion)) {
+			printf("SharedEnvironmentClient - '%s' is not a shared environment (version %u)\n", name, kVersion);
+			sharedMemory.close();
+			return false;
+		}
+
+		if (inSliceIndex >= header->numSlices) {
+			printf("SharedEnvironmentClient - slice %zu out of range (%llu slices)\n", inSliceIndex, (unsigned long long)header->numSlices);
+			sharedMemory.close();
+			return false;
+		}
+
+		// a slice left attached by a client that has exited is taken over
+		SharedSlice& slice = header->slices[inSliceIndex];
+		const uint32_t processId = util::getProcessId();
+
+		uint32_t owner = 0;
+		while (!slice.owner.compare_exchange_strong(owner, processId)) {
+			if ((owner == processId) || util::isProcessRunning(owner)) {
+				printf("SharedEnvironmentClient - slice %zu is owned by another client (process %u)\n", inSliceIndex, owner);
+				sharedMemory.close();
+				return false;
+			}
+		}
+
+		sliceIndex = inSliceIndex;
+		signalServer(header);
+
+		return true;
+	}
+
+	void SharedEnvironmentClient::close() {
+		if (!sharedMemory.data()) {
+			return;
+		}
+
+		SharedHeader* header = getHeader(sharedMemory);
+		header->slices[sliceIndex].owner.store(0, std::memory_order_release);
+		signalServer(header);
+
+		sharedMemory.close();
+	}
+
+	size_t SharedEnvironmentClient::size() const {
+		return size_t(getHeader(sharedMemory)->slices[sliceIndex].count);
+	}
+
+	size_t SharedEnvironmentClient::getBegin() const {
+		return size_t(getHeader(sharedMemory)->slices[sliceIndex].begin);
+	}
+
+	size_t SharedEnvironmentClient::getObservationSize() const {
+		return size_t(getHeader(sharedMemory)->observationSize);
+	}
+
+	uint8_t* SharedEnvironmentClient::getActions() const {
+		return sharedMemory.data() + getHeader(sharedMemory)->offsetActions + getBegin();
+	}
+
+	const uint8_t* SharedEnvironmentClient::getObservations() const {
+		return sharedMemory.data() + getHeader(sharedMemory)->offsetObservations + getBegin() * getObservationSize();
+	}
+
+	const float* SharedEnvironmentClient::getRewards() const {
+		return reinterpret_cast<const float*>(sharedMemory.data() + getHeader(sharedMemory)->offsetRewards) + getBegin();
+	}
+
+	const uint8_t* SharedEnvironmentClient::getDones() const {
+		return sharedMemory.data() + getHeader(sharedMemory)->offsetDones + getBegin();
+	}
+
+	bool SharedEnvironmentClient::step() {
+		return submit(kCommandStep, 0);
+	}
+
+	bool SharedEnvironmentClient::reset(uint64_t seed) {
+		return submit(kCommandReset, seed);
+	}
+
+	bool SharedEnvironmentClient::submit(uint32_t command, uint64_t seed) {
+		if (!sharedMemory.data()) {
+			return false;
+		}
+
+		SharedHeader* header = getHeader(sharedMemory);
+		SharedSlice& slice = header->slices[sliceIndex];
+
+		slice.command = command;
+		slice.seed = seed;
+
+		const uint32_t sequence = slice.requestSequence.load(std::memory_order_relaxed) + 1;
+		slice.requestSequence.store(sequence, std::memory_order_release);
+		signalServer(header);
+
+		for (;;) {
+			const uint32_t response = slice.responseSequence.load(std::memory_order_acquire);
+			if (response == sequence) {
+				return true;
+			}
+
+			if (header->isShutdown.load(std::memory_order_acquire)) {
+				return false;
+			}
+
+			util::waitOnAddress(slice.responseSequence, response, kWaitMilliseconds);
+		}
+	}
+}
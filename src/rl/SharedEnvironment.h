@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "util/SharedMemory.h"
+
+namespace rl {
+
+	class Environment;
+
+	/// @class SharedEnvironmentServer
+	/// @brief Serve a batch of environments to other processes on the same host, through shared memory
+	/// @note the batch is split into slices, and each slice is owned by one client process. Actions,
+	///       observations, rewards and dones live in the shared region, so they are never serialized or copied
+	///       between processes - clients read + write them in place.
+	///
+	///       A client submits a step or reset for its slice by bumping a request sequence number. Once every
+	///       attached client has submitted, the whole batch is stepped together, and each slice's response
+	///       sequence number is bumped - waits are on a futex (Linux), so idle processes sleep. Slices without
+	///       a client are stepped with no-ops. Each slice records the process id of its client, so a client that
+	///       exits without detaching (i.e. crashes) is detached by the server, and its slice can be opened again.
+	class SharedEnvironmentServer {
+	public:
+		SharedEnvironmentServer();
+		~SharedEnvironmentServer();
+
+		// create the shared region for an initialised environment, split into numSlices slices
+		bool init(const char* name, size_t numSlices, Environment* environment);
+
+		// wait up to timeoutMilliseconds for every attached client to submit a request, then serve them all
+		// - returns true if requests were served
+		bool serve(uint32_t timeoutMilliseconds);
+
+		// tell clients that no more requests will be served
+		void shutdown();
+
+		size_t getNumSlices() const;
+		size_t getNumAttached() const;
+
+		// number of batches served
+		uint64_t getNumServed() const;
+
+	private:
+		void writeObservations();
+
+		util::SharedMemory sharedMemory;
+		Environment* environment;
+
+		size_t numSlices;
+		uint64_t numServed;
+
+		// one action per environment, gathered from the slices for each step
+		std::vector<uint8_t> actions;
+	};
+
+	/// @class SharedEnvironmentClient
+	/// @brief Attach to one slice of a SharedEnvironmentServer in another process
+	/// @note write actions into getActions(), then step() - observations, rewards + dones are valid until
+	///       the next step() or reset().
+	class SharedEnvironmentClient {
+	public:
+		SharedEnvironmentClient();
+		~SharedEnvironmentClient();
+
+		// attach to a slice - fails if the slice is owned by another client that is still running
+		bool open(const char* name, size_t sliceIndex);
+
+		// detach from the slice, so the server no longer waits for it
+		void close();
+
+		// number of environments in the slice, and index of the first one in the batch
+		size_t size() const;
+		size_t getBegin() const;
+
+		size_t getObservationSize() const;
+
+		uint8_t* getActions() const;
+		const uint8_t* getObservations() const;
+		const float* getRewards() const;
+		const uint8_t* getDones() const;
+
+		// submit actions + wait for the step to complete - returns false if the server has shut down
+		bool step();
+
+		// start new episodes in every environment of the slice (see Environment::reset())
+		bool reset(uint64_t seed);
+
+	private:
+		bool submit(uint32_t command, uint64_t seed);
+
+		util::SharedMemory sharedMemory;
+		size_t sliceIndex;
+	};
+}
@@ -0,0 +1,95 @@
+#include "tools/Tools.h"
+
+#include "batch/BatchRunner.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	// drive a machine with its own deterministic inputs: insert a coin, start a game, then move + fire
+	uint8_t getInputPort1(size_t index, uint64_t frame) {
+		const uint64_t coinFrame = 30 + (index % 60);
+		const uint64_t startFrame = coinFrame + 30;
+
+		// coin bit is 0 while the coin switch is closed
+		uint8_t port1 = (1 << 3) | ((frame >= coinFrame && frame < coinFrame + 4) ? 0 : 1);
+
+		if (frame >= startFrame && frame < startFrame + 4) {
+			port1 |= (1 << 2);
+		}
+
+		if (frame >= startFrame + 4) {
+			// new controls every 8 frames, from a hash of machine index + frame
+			uint32_t value = uint32_t(index * 2654435761u) ^ uint32_t((frame >> 3) * 40503u);
+			value ^= value >> 13;
+			value *= 0x5bd1e995;
+			value ^= value >> 15;
+
+			port1 |= uint8_t(value & 0x70);	// fire, left, right
+		}
+
+		return port1;
+	}
+}
+
+namespace tools {
+	void updateBatchInputPorts(batch::BatchRunner& runner, uint64_t frame) {
+		for (size_t i = 0; i < runner.size(); i++) {
+			runner.setInputPort(i, 1, getInputPort1(i, frame));
+		}
+	}
+
+	uint64_t hashBatch(const batch::BatchRunner& runner) {
+		uint64_t hash = 0;
+		for (size_t i = 0; i < runner.size(); i++) {
+			hash = (hash * 31) ^ runner.hashRam(i);
+		}
+
+		return hash;
+	}
+
+	int runBatch(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const uint64_t numFrames = strtoull(findOption(argc, argv, "--frames", "600"), nullptr, 10);
+
+		batch::BatchRunner::Config config;
+		config.numMachines = size_t(strtoull(findOption(argc, argv, "--machines", "256"), nullptr, 10));
+		config.numThreads = size_t(strtoull(findOption(argc, argv, "--threads", "0"), nullptr, 10));
+		config.grainSize = size_t(strtoull(findOption(argc, argv, "--grain", "8"), nullptr, 10));
+
+		const char* engineName = findOption(argc, argv, "--engine", "scalar");
+		if (strcmp(engineName, "scalar") == 0) {
+			config.engine = batch::BatchRunner::Engine::Scalar;
+		}
+		else if (strcmp(engineName, "lockstep") == 0) {
+			config.engine = batch::BatchRunner::Engine::Lockstep;
+		}
+		else {
+			printf("unknown engine '%s' - expected scalar or lockstep\n", engineName);
+			return 1;
+		}
+
+		batch::BatchRunner runner;
+		if (!runner.init(romFilename, config)) {
+			return 1;
+		}
+
+		for (uint64_t frame = 0; frame < numFrames; frame++) {
+			updateBatchInputPorts(runner, frame);
+			runner.runFrame();
+		}
+
+		// combined hash of every machine, which should not depend on the number of threads or the engine
+		const uint64_t hash = hashBatch(runner);
+
+		const batch::BatchRunner::Metrics& metrics = runner.getMetrics();
+
+		printf("ran %zu machines x %llu frames in %.3f seconds (%s engine)\n", runner.size(), (unsigned long long)numFrames, metrics.seconds, engineName);
+		printf("aggregate %.0f frames/s (%.1fx real time), %llu chunks stolen\n",
+			metrics.framesPerSecond, metrics.framesPerSecond / 60.0, (unsigned long long)metrics.numSteals);
+		printf("hash 0x%016llx\n", (unsigned long long)hash);
+
+		return 0;
+	}
+}
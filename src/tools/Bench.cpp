@@ -0,0 +1,94 @@
+#include "tools/Tools.h"
+
+#include "batch/BatchRunner.h"
+#include "batch/LockstepEngine.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	struct BenchResult {
+		double framesPerSecond;
+		double stepsPerDispatch;
+		uint64_t hash;
+	};
+
+	bool runEngine(const char* romFilename, const batch::BatchRunner::Config& config, uint64_t numFrames, bool isAttract, BenchResult& outResult) {
+		batch::BatchRunner runner;
+		if (!runner.init(romFilename, config)) {
+			return false;
+		}
+
+		for (uint64_t frame = 0; frame < numFrames; frame++) {
+			if (!isAttract) {
+				tools::updateBatchInputPorts(runner, frame);
+			}
+
+			runner.runFrame();
+		}
+
+		const batch::BatchRunner::Metrics& metrics = runner.getMetrics();
+		outResult.framesPerSecond = metrics.framesPerSecond;
+		outResult.stepsPerDispatch = metrics.stepsPerDispatch;
+		outResult.hash = tools::hashBatch(runner);
+
+		return true;
+	}
+
+	bool hasFlag(int argc, char** argv, const char* name) {
+		for (int i = 0; i < argc; i++) {
+			if (strcmp(argv[i], name) == 0) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+namespace tools {
+	int runBench(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const uint64_t numFrames = strtoull(findOption(argc, argv, "--frames", "600"), nullptr, 10);
+
+		// attract mode - no inputs, so every machine runs the same code at the same time
+		const bool isAttract = hasFlag(argc, argv, "--attract");
+
+		batch::BatchRunner::Config config;
+		config.numMachines = size_t(strtoull(findOption(argc, argv, "--machines", "256"), nullptr, 10));
+		config.numThreads = size_t(strtoull(findOption(argc, argv, "--threads", "0"), nullptr, 10));
+		config.grainSize = 16;
+
+		printf("%zu machines x %llu frames, %s\n", config.numMachines, (unsigned long long)numFrames, isAttract ? "attract mode" : "playing with per-machine inputs");
+
+		BenchResult scalar;
+		config.engine = batch::BatchRunner::Engine::Scalar;
+		if (!runEngine(romFilename, config, numFrames, isAttract, scalar)) {
+			return 1;
+		}
+
+		BenchResult lockstep;
+		config.engine = batch::BatchRunner::Engine::Lockstep;
+		if (!runEngine(romFilename, config, numFrames, isAttract, lockstep)) {
+			return 1;
+		}
+
+		printf("  scalar   %10.0f frames/s  %5.2f steps/dispatch  hash 0x%016llx\n", scalar.framesPerSecond, scalar.stepsPerDispatch, (unsigned long long)scalar.hash);
+		printf("  lockstep %10.0f frames/s  %5.2f steps/dispatch  hash 0x%016llx\n", lockstep.framesPerSecond, lockstep.stepsPerDispatch, (unsigned long long)lockstep.hash);
+
+		// which engine wins depends on the workload + the CPU, so report the winner rather than assume it
+		const double speedup = (scalar.framesPerSecond > 0.0) ? (lockstep.framesPerSecond / scalar.framesPerSecond) : 0.0;
+		printf("  lockstep %.2fx scalar (%s lane loops) - %s is faster here\n", speedup,
+			batch::LockstepEngine::isAvx2Supported() ? "AVX2" : "portable", (speedup > 1.0) ? "lockstep" : "scalar");
+
+		if (scalar.hash != lockstep.hash) {
+			printf("FAILED - engines produced different RAM\n");
+			return 1;
+		}
+
+		printf("OK - engines match\n");
+
+		return 0;
+	}
+}
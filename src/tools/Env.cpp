@@ -0,0 +1,249 @@
+#include "tools/Tools.h"
+
+#include "rl/Environment.h"
+#include "rl/EnvironmentC.h"
+#include "rl/SharedEnvironment.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+	rl::Environment::Config parseConfig(int argc, char** argv) {
+		rl::Environment::Config config;
+		config.numEnvironments = size_t(strtoull(tools::findOption(argc, argv, "--envs", "64"), nullptr, 10));
+		config.numThreads = size_t(strtoull(tools::findOption(argc, argv, "--threads", "0"), nullptr, 10));
+		config.frameSkip = uint32_t(strtoul(tools::findOption(argc, argv, "--frameskip", "4"), nullptr, 10));
+
+		if (strcmp(tools::findOption(argc, argv, "--engine", "scalar"), "lockstep") == 0) {
+			config.engine = batch::BatchRunner::Engine::Lockstep;
+		}
+
+		if (strcmp(tools::findOption(argc, argv, "--observation", "raw"), "stacked") == 0) {
+			config.observation = rl::Observation::Stacked;
+		}
+
+		config.preprocessor.width = uint16_t(strtoul(tools::findOption(argc, argv, "--width", "84"), nullptr, 10));
+		config.preprocessor.height = uint16_t(strtoul(tools::findOption(argc, argv, "--height", "84"), nullptr, 10));
+		config.preprocessor.stackSize = uint32_t(strtoul(tools::findOption(argc, argv, "--stack", "4"), nullptr, 10));
+
+		return config;
+	}
+
+	// uniformly random actions
+	void randomActions(uint32_t& random, uint8_t* actions, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			actions[i] = uint8_t(random % rl::kNumActions);
+		}
+	}
+
+	// rewards + completed episodes of a set of environments
+	class Totals {
+	public:
+		explicit Totals(size_t count) :
+			numEpisodes(0),
+			totalReward(0.0),
+			episodeReward(0.0),
+			rewardsInEpisode(count, 0.0)
+		{
+
+		}
+
+		void add(const float* rewards, const uint8_t* dones) {
+			for (size_t i = 0; i < rewardsInEpisode.size(); i++) {
+				totalReward += rewards[i];
+				rewardsInEpisode[i] += rewards[i];
+
+				if (dones[i]) {
+					numEpisodes++;
+					episodeReward += rewardsInEpisode[i];
+					rewardsInEpisode[i] = 0.0;
+				}
+			}
+		}
+
+		// frameSkip of 0 if unknown
+		void print(const uint8_t* observations, size_t observationSize, size_t stride, uint64_t numSteps, uint32_t frameSkip, double seconds) const {
+			const size_t numEnvs = rewardsInEpisode.size();
+			const double numEnvSteps = double(numEnvs) * double(numSteps);
+
+			// average pixel value over the final observations, as a check that they are being produced
+			double observationTotal = 0.0;
+			for (size_t i = 0; i < numEnvs; i++) {
+				for (size_t j = 0; j < observationSize; j++) {
+					observationTotal += observations[i * stride + j];
+				}
+			}
+
+			const double stepsPerSecond = (seconds > 0.0) ? (numEnvSteps / seconds) : 0.0;
+
+			printf("ran %zu environments x %llu steps in %.3f seconds\n", numEnvs, (unsigned long long)numSteps, seconds);
+			if (frameSkip > 0) {
+				printf("%.0f environment steps/s, %.0f frames/s (frame skip %u)\n", stepsPerSecond, stepsPerSecond * frameSkip, frameSkip);
+			}
+			else {
+				printf("%.0f environment steps/s\n", stepsPerSecond);
+			}
+			printf("observation %zu bytes, mean value %.2f\n", observationSize, observationTotal / double(numEnvs * observationSize));
+			printf("total reward %.0f, %llu episodes completed, mean episode score %.1f\n",
+				totalReward, (unsigned long long)numEpisodes, (numEpisodes > 0) ? (episodeReward / double(numEpisodes)) : 0.0);
+		}
+
+	private:
+		uint64_t numEpisodes;
+		double totalReward;
+		double episodeReward;
+		std::vector<double> rewardsInEpisode;
+	};
+
+	// step one slice of a shared environment served by another process
+	int runClient(const char* name, size_t slice, uint64_t numSteps, uint64_t seed) {
+		si_env_client* client = si_env_client_open(name, slice);
+		if (!client) {
+			return 1;
+		}
+
+		const size_t numEnvs = si_env_client_size(client);
+		Totals totals(numEnvs);
+		uint32_t random = uint32_t(seed) | 1;
+
+		si_env_client_reset(client, seed);
+
+		auto start = std::chrono::steady_clock::now();
+
+		uint64_t step = 0;
+		for (; step < numSteps; step++) {
+			randomActions(random, si_env_client_actions(client), numEnvs);
+
+			if (!si_env_client_step(client)) {
+				printf("server shut down\n");
+				break;
+			}
+
+			totals.add(si_env_client_rewards(client), si_env_client_dones(client));
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const size_t observationSize = si_env_client_observation_size(client);
+		printf("slice %zu of '%s'\n", slice, name);
+		totals.print(si_env_client_observations(client), observationSize, observationSize, step, 0, seconds);
+
+		si_env_client_close(client);
+
+		return 0;
+	}
+}
+
+namespace tools {
+	int runEnv(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const uint64_t numSteps = strtoull(findOption(argc, argv, "--steps", "1000"), nullptr, 10);
+		const uint64_t seed = strtoull(findOption(argc, argv, "--seed", "1"), nullptr, 10);
+
+		const char* sharedName = findOption(argc, argv, "--shared", nullptr);
+		if (sharedName) {
+			const size_t slice = size_t(strtoull(findOption(argc, argv, "--slice", "0"), nullptr, 10));
+			return runClient(sharedName, slice, numSteps, seed);
+		}
+
+		// drive the environment through the C interface, as a training framework would
+		const rl::Environment::Config environmentConfig = parseConfig(argc, argv);
+
+		si_env_config config;
+		si_env_default_config(&config);
+		config.num_environments = environmentConfig.numEnvironments;
+		config.num_threads = environmentConfig.numThreads;
+		config.frame_skip = environmentConfig.frameSkip;
+		config.engine = (environmentConfig.engine == batch::BatchRunner::Engine::Lockstep) ? 1 : 0;
+		config.observation = (environmentConfig.observation == rl::Observation::Stacked) ? 1 : 0;
+		config.observation_width = environmentConfig.preprocessor.width;
+		config.observation_height = environmentConfig.preprocessor.height;
+		config.stack_size = environmentConfig.preprocessor.stackSize;
+
+		si_env* env = si_env_create(romFilename, &config);
+		if (!env) {
+			return 1;
+		}
+
+		const size_t numEnvs = si_env_size(env);
+		std::vector<uint8_t> actions(numEnvs);
+		std::vector<float> rewards(numEnvs);
+		std::vector<uint8_t> dones(numEnvs);
+
+		Totals totals(numEnvs);
+		uint32_t random = uint32_t(seed) | 1;
+
+		// observations are read in place with si_env_observations(), rather than copied out
+		si_env_reset(env, seed, nullptr);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint64_t step = 0; step < numSteps; step++) {
+			randomActions(random, actions.data(), numEnvs);
+			si_env_step(env, actions.data(), nullptr, rewards.data(), dones.data());
+			totals.add(rewards.data(), dones.data());
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		size_t stride = 0;
+		const uint8_t* observations = si_env_observations(env, &stride);
+		totals.print(observations, si_env_observation_size(env), stride, numSteps, config.frame_skip, seconds);
+
+		si_env_destroy(env);
+
+		return 0;
+	}
+
+	int runServe(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const char* name = findOption(argc, argv, "--name", "/spaceinvaders");
+		const size_t numSlices = size_t(strtoull(findOption(argc, argv, "--slices", "1"), nullptr, 10));
+
+		rl::Environment environment;
+		if (!environment.init(romFilename, parseConfig(argc, argv))) {
+			return 1;
+		}
+
+		rl::SharedEnvironmentServer server;
+		if (!server.init(name, numSlices, &environment)) {
+			return 1;
+		}
+
+		printf("serving %zu environments in %zu slices as '%s' - waiting for clients\n", environment.size(), numSlices, name);
+
+		// serve until every client that attached has detached again
+		bool hasAttached = false;
+		auto start = std::chrono::steady_clock::now();
+
+		for (;;) {
+			server.serve(100);
+
+			if (server.getNumAttached() > 0) {
+				if (!hasAttached) {
+					start = std::chrono::steady_clock::now();
+					hasAttached = true;
+				}
+			}
+			else if (hasAttached) {
+				break;
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double numEnvSteps = double(server.getNumServed()) * double(environment.size());
+
+		server.shutdown();
+
+		printf("served %llu batches in %.3f seconds, %.0f environment steps/s\n",
+			(unsigned long long)server.getNumServed(), seconds, (seconds > 0.0) ? (numEnvSteps / seconds) : 0.0);
+
+		return 0;
+	}
+}
@@ -0,0 +1,56 @@
+#include "tools/Tools.h"
+
+#include "machine/GdbStub.h"
+#include "machine/Machine.h"
+#include "machine/Snapshot.h"
+#include "rl/Game.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+	// longest update() waits for a packet while the machine is stopped
+	const uint32_t kWaitMilliseconds = 100;
+}
+
+namespace tools {
+	int runGdb(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const char* snapshotFilename = findOption(argc, argv, "--snapshot", nullptr);
+		const uint16_t port = uint16_t(strtoul(findOption(argc, argv, "--port", "1234"), nullptr, 10));
+
+		machine::Machine machine;
+		if (!machine.init(romFilename)) {
+			return 1;
+		}
+
+		if (snapshotFilename) {
+			machine::Snapshot snapshot;
+			if (!machine::loadSnapshot(snapshotFilename, snapshot)) {
+				return 1;
+			}
+			machine.restore(snapshot);
+		}
+		else {
+			machine.setInputPort(1, rl::kPort1Default);
+		}
+
+		machine::GdbStub stub;
+		if (!stub.start(port)) {
+			return 1;
+		}
+
+		printf("waiting for gdb on 127.0.0.1:%u - connect with 'set architecture z80' + 'target remote :%u'\n", port, port);
+
+		// the machine only runs while a client has continued it - it stays attached for the next client after one detaches
+		while (stub.update(machine, kWaitMilliseconds)) {
+
+		}
+
+		stub.shutdown();
+
+		printf("killed by gdb at step %llu, PC [0x%04x]\n", (unsigned long long)machine.getCPU().getNumSteps(), machine.getCPU().getState().pc);
+
+		return 0;
+	}
+}
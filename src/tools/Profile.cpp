@@ -0,0 +1,87 @@
+#include "tools/Tools.h"
+
+#include "cpu/Profiler.h"
+#include "machine/Machine.h"
+#include "machine/Movie.h"
+#include "rl/Game.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace tools {
+	uint64_t playRandomGame(machine::Machine& machine, uint64_t numFrames, uint64_t seed) {
+		uint32_t random = uint32_t(seed) | 1;
+
+		uint64_t frame = 0;
+		for (; (frame < numFrames) && !rl::isGameOver(machine); frame++) {
+			if (frame % 8 == 0) {
+				random ^= random << 13;
+				random ^= random >> 17;
+				random ^= random << 5;
+				machine.setInputPort(1, rl::getActionPort(uint8_t(random % rl::kNumActions)));
+			}
+
+			machine.runFrame();
+		}
+
+		return frame;
+	}
+
+	int runProfile(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const char* movieFilename = findOption(argc, argv, "--movie", nullptr);
+		const uint64_t numFrames = strtoull(findOption(argc, argv, "--frames", "3600"), nullptr, 10);
+		const uint64_t seed = strtoull(findOption(argc, argv, "--seed", "1"), nullptr, 10);
+		const size_t numHotspots = size_t(strtoull(findOption(argc, argv, "--top", "32"), nullptr, 10));
+		const char* foldedFilename = findOption(argc, argv, "--folded", nullptr);
+
+		machine::Machine machine;
+		if (!machine.init(romFilename)) {
+			return 1;
+		}
+
+		cpu::Profiler profiler;
+		uint64_t numFramesRun = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		if (movieFilename) {
+			machine::Movie movie;
+			if (!machine::loadMovie(movieFilename, movie)) {
+				return 1;
+			}
+
+			machine.getCPU().setProfiler(&profiler);
+
+			machine::ReplayResult result;
+			machine::replayMovie(machine, movie, result);
+			numFramesRun = result.numFrames;
+		}
+		else {
+			// only the game itself is profiled, not inserting a coin + starting it
+			if (!rl::startGame(machine)) {
+				return 1;
+			}
+
+			machine.getCPU().setProfiler(&profiler);
+			numFramesRun = playRandomGame(machine, numFrames, seed);
+		}
+
+		machine.getCPU().setProfiler(nullptr);
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("profiled %llu frames in %.3f seconds\n", (unsigned long long)numFramesRun, seconds);
+		profiler.print(&machine.getMemory(), numHotspots);
+
+		if (foldedFilename) {
+			if (!profiler.writeFoldedStacks(foldedFilename)) {
+				return 1;
+			}
+			printf("saved folded call stacks to %s\n", foldedFilename);
+		}
+
+		return 0;
+	}
+}
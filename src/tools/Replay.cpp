@@ -0,0 +1,54 @@
+#include "tools/Tools.h"
+
+#include "machine/Machine.h"
+#include "machine/Movie.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace tools {
+	int runReplay(int argc, char** argv) {
+		if (argc < 2) {
+			printf("usage: replay <movie> [--rom <filename>]\n");
+			return 1;
+		}
+
+		const char* movieFilename = argv[1];
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+
+		machine::Movie movie;
+		if (!machine::loadMovie(movieFilename, movie)) {
+			return 1;
+		}
+
+		machine::Machine machine;
+		if (!machine.init(romFilename)) {
+			return 1;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		machine::ReplayResult result;
+		bool isVerified = machine::replayMovie(machine, movie, result);
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double framesPerSecond = (seconds > 0.0) ? (double(result.numFrames) / seconds) : 0.0;
+
+		printf("replayed %llu / %zu frames in %.3f seconds (%.0f frames/s, %.1fx real time)\n",
+			(unsigned long long)result.numFrames, movie.frames.size(), seconds, framesPerSecond, framesPerSecond / 60.0);
+
+		if (!isVerified) {
+			if (result.firstMismatchFrame >= 0) {
+				printf("FAILED - RAM hash mismatch at frame %lld\n", (long long)result.firstMismatchFrame);
+			}
+			else {
+				printf("FAILED - replay stopped early\n");
+			}
+			return 1;
+		}
+
+		printf("OK - all frames match\n");
+
+		return 0;
+	}
+}
@@ -0,0 +1,335 @@
+#include "tools/Tools.h"
+
+#include "machine/Machine.h"
+#include "machine/Movie.h"
+#include "machine/Snapshot.h"
+#include "rl/Game.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+	enum class Objective {
+		Score,		// highest score, then most ships
+		Survival	// most frames before the game is over, then most ships, then highest score
+	};
+
+	// no parent, for the entry at the root of the search
+	const uint32_t kNoParent = ~uint32_t(0);
+
+	// one action held for framesPerAction frames, and the step it followed
+	struct HistoryEntry {
+		uint32_t parent;
+		uint8_t action;
+	};
+
+	// how far the game got at the end of a step
+	struct Result {
+		uint64_t hash;
+		uint32_t score;
+		uint8_t ships;
+		bool isGameOver;
+
+		// frames run since the start of the search
+		uint32_t numFrames;
+
+		// index of the last step in the history
+		uint32_t history;
+	};
+
+	// state at the end of a step - the machine is kept so the node can be expanded in the next layer
+	struct Node {
+		std::unique_ptr<machine::Machine> machine;
+		Result result;
+	};
+
+	// the input port is latched again before the next step runs, so reset it first - otherwise states that
+	// differ only in the action that led to them would never be pruned as duplicates
+	Result evaluate(machine::Machine& machine, uint32_t numFrames) {
+		machine.setInputPort(1, rl::kPort1Default);
+
+		Result result;
+		result.hash = machine.hashState();
+		result.score = rl::getScore(machine);
+		result.isGameOver = rl::isGameOver(machine);
+		result.ships = result.isGameOver ? 0 : rl::getShips(machine);
+		result.numFrames = numFrames;
+		result.history = 0;
+
+		return result;
+	}
+
+	// true if a is a better result than b - ties are broken by hash, so the order does not depend on the
+	// order nodes were expanded in, and the beam is not filled with the children of the first few parents
+	bool isBetter(const Result& a, const Result& b, Objective objective) {
+		if (objective == Objective::Score) {
+			if (a.score != b.score) {
+				return a.score > b.score;
+			}
+			if (a.ships != b.ships) {
+				return a.ships > b.ships;
+			}
+			if (a.numFrames != b.numFrames) {
+				return a.numFrames > b.numFrames;
+			}
+		}
+		else {
+			if (a.numFrames != b.numFrames) {
+				return a.numFrames > b.numFrames;
+			}
+			if (a.ships != b.ships) {
+				return a.ships > b.ships;
+			}
+			if (a.score != b.score) {
+				return a.score > b.score;
+			}
+		}
+
+		return a.hash < b.hash;
+	}
+
+	// create the machine at the root of the search - from a savestate if one is supplied, otherwise at the
+	// start of a new game
+	bool createRoot(const char* romFilename, const char* snapshotFilename, machine::Machine& outMachine) {
+		if (!outMachine.init(romFilename)) {
+			return false;
+		}
+
+		if (!snapshotFilename) {
+			return rl::startGame(outMachine);
+		}
+
+		machine::Snapshot snapshot;
+		if (!machine::loadSnapshot(snapshotFilename, snapshot)) {
+			return false;
+		}
+		outMachine.restore(snapshot);
+
+		// inputs are only changed at the start of a frame, so finish a frame that was saved part way through
+		if (!outMachine.isFrameStart()) {
+			outMachine.runFrame();
+		}
+
+		return true;
+	}
+
+	// actions from the root of the search to the step at index
+	std::vector<uint8_t> getActions(const std::vector<HistoryEntry>& history, uint32_t index) {
+		std::vector<uint8_t> actions;
+		for (; history[index].parent != kNoParent; index = history[index].parent) {
+			actions.push_back(history[index].action);
+		}
+		std::reverse(actions.begin(), actions.end());
+
+		return actions;
+	}
+
+	// replay actions from root into a movie, returning the hash of the final state
+	uint64_t recordMovie(const machine::Machine& root, const std::vector<uint8_t>& actions, uint32_t framesPerAction, uint32_t numFrames, machine::Movie& outMovie) {
+		machine::Machine machine;
+		root.fork(machine);
+
+		outMovie.start(machine);
+
+		for (uint32_t i = 0; (i < numFrames) && (i / framesPerAction < actions.size()); i++) {
+			machine.setInputPort(1, rl::getActionPort(actions[i / framesPerAction]));
+			machine.runFrame();
+			outMovie.record(machine);
+		}
+
+		machine.setInputPort(1, rl::kPort1Default);
+
+		return machine.hashState();
+	}
+}
+
+namespace tools {
+	int runSearch(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const char* snapshotFilename = findOption(argc, argv, "--snapshot", nullptr);
+		const char* movieFilename = findOption(argc, argv, "--out", "./search.bin");
+		const uint32_t maxDepth = uint32_t(strtoul(findOption(argc, argv, "--depth", "100"), nullptr, 10));
+		const size_t beamWidth = size_t(strtoull(findOption(argc, argv, "--beam", "256"), nullptr, 10));
+		const uint32_t framesPerAction = uint32_t(strtoul(findOption(argc, argv, "--frames", "8"), nullptr, 10));
+		const size_t numThreads = size_t(strtoull(findOption(argc, argv, "--threads", "0"), nullptr, 10));
+
+		Objective objective = Objective::Score;
+		const char* objectiveName = findOption(argc, argv, "--objective", "score");
+		if (strcmp(objectiveName, "survival") == 0) {
+			objective = Objective::Survival;
+		}
+		else if (strcmp(objectiveName, "score") != 0) {
+			printf("unknown objective '%s' - expected score or survival\n", objectiveName);
+			return 1;
+		}
+
+		if ((beamWidth == 0) || (framesPerAction == 0)) {
+			printf("beam width and frames per action must be at least 1\n");
+			return 1;
+		}
+
+		machine::Machine root;
+		if (!createRoot(romFilename, snapshotFilename, root)) {
+			return 1;
+		}
+
+		util::ThreadPool pool(numThreads);
+
+		std::vector<HistoryEntry> history;
+		history.push_back({ kNoParent, uint8_t(rl::Action::Noop) });
+
+		std::vector<Node> beam(1);
+		beam[0].machine.reset(new machine::Machine());
+		root.fork(*beam[0].machine);
+		beam[0].result = evaluate(*beam[0].machine, 0);
+
+		// every state seen so far - a state reached again is pruned, as its subtree has already been searched
+		std::unordered_set<uint64_t> seen;
+		seen.insert(beam[0].result.hash);
+
+		// the best result is taken from the children only - the root may not have spawned the player yet, so
+		// its ships can't be compared with theirs. The root is only reported if it has no children
+		Result best = beam[0].result;
+		bool isBestChild = false;
+
+		// machines are reused from layer to layer - a fork only replaces their state
+		std::vector<Node> children;
+		std::vector<std::unique_ptr<machine::Machine>> spareMachines;
+		std::vector<size_t> order;
+
+		uint64_t numExpanded = 0;
+		uint64_t numDuplicates = 0;
+
+		printf("searching %u steps of %u frames, beam width %zu, %zu threads, objective %s\n",
+			maxDepth, framesPerAction, beamWidth, pool.getNumThreads(), objectiveName);
+
+		auto start = std::chrono::steady_clock::now();
+
+		uint32_t depth = 0;
+		for (; (depth < maxDepth) && !beam.empty(); depth++) {
+			const size_t numChildren = beam.size() * rl::kNumActions;
+			children.resize(numChildren);
+			for (Node& child : children) {
+				if (!child.machine && !spareMachines.empty()) {
+					child.machine = std::move(spareMachines.back());
+					spareMachines.pop_back();
+				}
+				else if (!child.machine) {
+					child.machine.reset(new machine::Machine());
+				}
+			}
+
+			const uint32_t numFrames = (depth + 1) * framesPerAction;
+
+			pool.parallelFor(numChildren, 1, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					const Node& parent = beam[i / rl::kNumActions];
+					Node& child = children[i];
+
+					parent.machine->fork(*child.machine);
+					child.machine->setInputPort(1, rl::getActionPort(uint8_t(i % rl::kNumActions)));
+
+					uint32_t frame = 0;
+					while ((frame < framesPerAction) && ((frame == 0) || !rl::isGameOver(*child.machine))) {
+						child.machine->runFrame();
+						frame++;
+					}
+
+					child.result = evaluate(*child.machine, parent.result.numFrames + frame);
+				}
+			});
+
+			numExpanded += numChildren;
+
+			// prune duplicates in expansion order, so the result does not depend on the number of threads
+			order.clear();
+			for (size_t i = 0; i < numChildren; i++) {
+				Result& result = children[i].result;
+				if (!seen.insert(result.hash).second) {
+					numDuplicates++;
+					continue;
+				}
+
+				result.history = uint32_t(history.size());
+				history.push_back({ beam[i / rl::kNumActions].result.history, uint8_t(i % rl::kNumActions) });
+
+				if (!isBestChild || isBetter(result, best, objective)) {
+					best = result;
+					isBestChild = true;
+				}
+
+				// a game that is over can not be continued
+				if (!result.isGameOver) {
+					order.push_back(i);
+				}
+			}
+
+			const size_t numKept = std::min(order.size(), beamWidth);
+			std::partial_sort(order.begin(), order.begin() + numKept, order.end(), [&children, objective](size_t a, size_t b) {
+				return isBetter(children[a].result, children[b].result, objective);
+			});
+
+			// move the kept children into the beam - the old beam's machines are reused as children
+			for (Node& node : beam) {
+				spareMachines.push_back(std::move(node.machine));
+			}
+
+			beam.resize(numKept);
+			for (size_t i = 0; i < numKept; i++) {
+				beam[i] = std::move(children[order[i]]);
+			}
+
+			if (((depth + 1) % 10 == 0) || (depth + 1 == maxDepth) || beam.empty()) {
+				printf("step %u (frame %u): %zu states in beam, %llu expanded, %llu duplicates, best score %u with %u ships at frame %u\n",
+					depth + 1, numFrames, beam.size(), (unsigned long long)numExpanded, (unsigned long long)numDuplicates, best.score, best.ships, best.numFrames);
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const uint64_t numFramesRun = numExpanded * framesPerAction;
+
+		uint64_t numPageCopies = 0;
+		for (const std::vector<Node>* nodes : { &beam, &children }) {
+			for (const Node& node : *nodes) {
+				if (node.machine) {
+					numPageCopies += node.machine->getMemory().getNumPageCopies();
+				}
+			}
+		}
+		for (const std::unique_ptr<machine::Machine>& spareMachine : spareMachines) {
+			numPageCopies += spareMachine->getMemory().getNumPageCopies();
+		}
+
+		printf("expanded %llu states in %.3f seconds (%.0f states/s, %.0f frames/s), %.1f pages copied per state\n",
+			(unsigned long long)numExpanded, seconds, (seconds > 0.0) ? (double(numExpanded) / seconds) : 0.0,
+			(seconds > 0.0) ? (double(numFramesRun) / seconds) : 0.0, (numExpanded > 0) ? (double(numPageCopies) / double(numExpanded)) : 0.0);
+		printf("pruned %llu duplicate states (%.1f%%)\n",
+			(unsigned long long)numDuplicates, (numExpanded > 0) ? (100.0 * double(numDuplicates) / double(numExpanded)) : 0.0);
+
+		// replay the best path into a movie - the final state must match the one found by the search
+		machine::Movie movie;
+		const uint64_t hash = recordMovie(root, getActions(history, best.history), framesPerAction, best.numFrames, movie);
+
+		if (hash != best.hash) {
+			printf("FAILED - replaying the best path did not reach the state found by the search\n");
+			return 1;
+		}
+
+		if (!machine::saveMovie(movieFilename, movie)) {
+			return 1;
+		}
+
+		printf("best: score %u, %u ships, %s after %u frames - saved %zu frame movie to %s\n",
+			best.score, best.ships, best.isGameOver ? "game over" : "still playing", best.numFrames, movie.frames.size(), movieFilename);
+
+		return 0;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+namespace batch {
+	class BatchRunner;
+}
+
+namespace machine {
+	class Machine;
+}
+
+namespace tools {
+	// default location of the Space Invaders ROM, relative to the working directory
+	extern const char* kDefaultRomFilename;
+
+	// find the value that follows a named option (i.e. "--rom <filename>"), or return defaultValue
+	const char* findOption(int argc, char** argv, const char* name, const char* defaultValue);
+
+	// replay a movie headless, at uncapped speed, verifying RAM hashes for every frame
+	int runReplay(int argc, char** argv);
+
+	// run a batch of machines headless on a thread pool, reporting aggregate frames per second
+	int runBatch(int argc, char** argv);
+
+	// compare throughput of the scalar + lockstep batch engines, verifying that they produce the same results
+	int runBench(int argc, char** argv);
+
+	// step a batch of reinforcement learning environments with random actions, through the C interface - in
+	// process, or as a client of one slice of a batch served by another process
+	int runEnv(int argc, char** argv);
+
+	// serve a batch of reinforcement learning environments to other processes through shared memory
+	int runServe(int argc, char** argv);
+
+	// search for the inputs that maximise score or survival from a savestate, expanding forked machines in
+	// parallel with duplicate states pruned by hash, and save the best inputs found as a movie
+	int runSearch(int argc, char** argv);
+
+	// count executions + cycles per opcode, per address and per call path while playing a movie or a random game,
+	// and report the hottest addresses disassembled - call paths can be saved for a flame graph
+	int runProfile(int argc, char** argv);
+
+	// record a compact binary trace of every instruction executed while playing a movie or a random game - to a
+	// file as it runs, or into a ring buffer that keeps only the most recent instructions
+	int runTrace(int argc, char** argv);
+
+	// print the records of a trace, disassembled, with the registers + memory writes of each one
+	int runTraceDump(int argc, char** argv);
+
+	// index the memory writes + port I/O of a trace by address and port, into a file that is mapped to query it
+	int runTraceIndex(int argc, char** argv);
+
+	// find the writes to an address, or the I/O on a port, in a range of frames or steps from a trace index -
+	// listing each one, or counting them by PC
+	int runTraceQuery(int argc, char** argv);
+
+	// serve a headless machine to GDB over a loopback socket (the GDB remote serial protocol), from power on or a
+	// savestate, until the client kills it
+	int runGdb(int argc, char** argv);
+
+	// play a game with random actions, each held for 8 frames, until numFrames have run or the game is over
+	// - returns the number of frames run
+	uint64_t playRandomGame(machine::Machine& machine, uint64_t numFrames, uint64_t seed);
+
+	// set deterministic inputs for every machine in a batch - each machine inserts a coin, starts a game, then plays
+	void updateBatchInputPorts(batch::BatchRunner& runner, uint64_t frame);
+
+	// combined hash of the RAM of every machine in a batch
+	uint64_t hashBatch(const batch::BatchRunner& runner);
+}
@@ -0,0 +1,68 @@
+#include "tools/Tools.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	struct Command {
+		const char* name;
+		const char* usage;
+		int (*run)(int argc, char** argv);
+	};
+
+	const Command kCommands[] = {
+		{ "replay", "replay <movie> [--rom <filename>]", tools::runReplay },
+		{ "batch", "batch [--machines <n>] [--threads <n>] [--grain <n>] [--frames <n>] [--rom <filename>]", tools::runBatch },
+		{ "bench", "bench [--machines <n>] [--threads <n>] [--frames <n>] [--attract] [--rom <filename>]", tools::runBench },
+		{ "env", "env [--envs <n>] [--threads <n>] [--steps <n>] [--frameskip <n>] [--seed <n>] [--engine scalar|lockstep] [--observation raw|stacked] [--width <n>] [--height <n>] [--stack <n>] [--shared <name> --slice <n>] [--rom <filename>]", tools::runEnv },
+		{ "serve", "serve [--name <name>] [--slices <n>] [--envs <n>] [--threads <n>] [--frameskip <n>] [--engine scalar|lockstep] [--observation raw|stacked] [--width <n>] [--height <n>] [--stack <n>] [--rom <filename>]", tools::runServe },
+		{ "search", "search [--snapshot <filename>] [--depth <n>] [--beam <n>] [--frames <n>] [--objective score|survival] [--threads <n>] [--out <movie>] [--rom <filename>]", tools::runSearch },
+		{ "profile", "profile [--movie <movie>] [--frames <n>] [--seed <n>] [--top <n>] [--folded <filename>] [--rom <filename>]", tools::runProfile },
+		{ "trace", "trace --out <filename> [--movie <movie>] [--frames <n>] [--seed <n>] [--ring <MB>] [--rom <filename>]", tools::runTrace },
+		{ "tracedump", "tracedump <filename> [--from <step>] [--count <n>]", tools::runTraceDump },
+		{ "traceindex", "traceindex <trace> [--out <filename>]", tools::runTraceIndex },
+		{ "tracequery", "tracequery <index> (--address <address> | --in <port> | --out <port>) [--frames <from>:<to>] [--steps <from>:<to>] [--changed] [--pcs] [--count <n>]", tools::runTraceQuery },
+		{ "gdb", "gdb [--port <n>] [--snapshot <filename>] [--rom <filename>]", tools::runGdb },
+	};
+
+	void printUsage() {
+		printf("usage: SpaceInvaders8080Tools <command> [arguments]\n");
+		for (const Command& command : kCommands) {
+			printf("  %s\n", command.usage);
+		}
+	}
+}
+
+namespace tools {
+	const char* kDefaultRomFilename = "./roms/spaceinvaders/invaders.concatenated";
+
+	const char* findOption(int argc, char** argv, const char* name, const char* defaultValue) {
+		for (int i = 0; i + 1 < argc; i++) {
+			if (strcmp(argv[i], name) == 0) {
+				return argv[i + 1];
+			}
+		}
+
+		return defaultValue;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		printUsage();
+		return 1;
+	}
+
+	for (const Command& command : kCommands) {
+		if (strcmp(argv[1], command.name) == 0) {
+			// command receives its own arguments, starting with its name
+			return command.run(argc - 1, argv + 1);
+		}
+	}
+
+	printf("unknown command '%s'\n", argv[1]);
+	printUsage();
+
+	return 1;
+}
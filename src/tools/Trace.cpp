@@ -0,0 +1,369 @@
+#include "tools/Tools.h"
+
+#include "Disassemble.h"
+#include "cpu/TraceIndex.h"
+#include "cpu/TraceReader.h"
+#include "cpu/TraceRecorder.h"
+#include "machine/Machine.h"
+#include "machine/Movie.h"
+#include "memory/IMemory.h"
+#include "rl/Game.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	// the bytes of a single traced instruction, at its address - enough to disassemble it
+	class InstructionMemory : public memory::IMemory {
+	public:
+		explicit InstructionMemory(const cpu::TraceRecord& inRecord) :
+			record(inRecord)
+		{
+
+		}
+
+		uint16_t translate(uint16_t address) const override {
+			return address;
+		}
+
+		void write(uint16_t address, uint8_t value) override {
+			(void)address;
+			(void)value;
+		}
+
+		uint8_t read(uint16_t address) const override {
+			const uint16_t offset = uint16_t(address - record.pc);
+			return (offset < 3) ? record.bytes[offset] : 0;
+		}
+
+	private:
+		const cpu::TraceRecord& record;
+	};
+
+	void printRecord(const cpu::TraceRecord& record) {
+		std::string text;
+
+		if (record.isInterrupt) {
+			text = "interrupt " + std::to_string(record.interruptNum) + (record.isInterruptTaken ? "" : " (disabled)");
+			printf("%10llu %6llu  %04x  %-9s %-16s", (unsigned long long)record.numSteps, (unsigned long long)(record.numInterrupts / 2),
+				record.pc, "", text.c_str());
+		}
+		else {
+			InstructionMemory instructionMemory(record);
+			uint16_t opcodeSize = 0;
+			text = Disassemble::stringFromOpcode(&instructionMemory, record.pc, opcodeSize);
+
+			char bytes[16] = "";
+			for (uint8_t i = 0; i < record.size; i++) {
+				snprintf(bytes + i * 3, sizeof(bytes) - i * 3, "%02x ", record.bytes[i]);
+			}
+
+			printf("%10llu %6llu  %04x  %-9s %-16s", (unsigned long long)record.numSteps, (unsigned long long)(record.numInterrupts / 2),
+				record.pc, bytes, text.c_str());
+		}
+
+		const cpu::TraceRegisters& registers = record.registers;
+		printf("  a=%02x bc=%02x%02x de=%02x%02x hl=%02x%02x f=%02x sp=%04x%s",
+			registers.a, registers.b, registers.c, registers.d, registers.e, registers.h, registers.l, registers.flags,
+			registers.sp, registers.interruptsEnabled ? " ei" : "");
+
+		for (size_t i = 0; i < record.numWrites; i++) {
+			printf("  [%04x]=%02x", record.writes[i].address, record.writes[i].value);
+		}
+		if (record.hasIn) {
+			printf("  in(%u)=%02x", record.inPort, record.inValue);
+		}
+		if (record.hasOut) {
+			printf("  out(%u)=%02x", record.outPort, record.outValue);
+		}
+
+		printf("\n");
+	}
+
+	// parse "<from>:<to>" - either may be left out, to leave that end of the range open
+	void parseRange(const char* text, uint64_t& outFrom, uint64_t& outTo) {
+		if (!text) {
+			return;
+		}
+
+		char* end = nullptr;
+		const char* separator = strchr(text, ':');
+
+		if (separator != text) {
+			outFrom = strtoull(text, &end, 0);
+		}
+		if (!separator) {
+			outTo = outFrom;
+		}
+		else if (separator[1] != '\0') {
+			outTo = strtoull(separator + 1, &end, 0);
+		}
+	}
+}
+
+namespace tools {
+	int runTrace(int argc, char** argv) {
+		const char* romFilename = findOption(argc, argv, "--rom", kDefaultRomFilename);
+		const char* traceFilename = findOption(argc, argv, "--out", nullptr);
+		const char* movieFilename = findOption(argc, argv, "--movie", nullptr);
+		const uint64_t numFrames = strtoull(findOption(argc, argv, "--frames", "3600"), nullptr, 10);
+		const uint64_t seed = strtoull(findOption(argc, argv, "--seed", "1"), nullptr, 10);
+		const size_t ringSize = size_t(strtoull(findOption(argc, argv, "--ring", "0"), nullptr, 10));
+
+		if (!traceFilename) {
+			printf("usage: trace --out <filename> [--movie <movie>] [--frames <n>] [--seed <n>] [--ring <MB>] [--rom <filename>]\n");
+			return 1;
+		}
+
+		machine::Machine machine;
+		if (!machine.init(romFilename)) {
+			return 1;
+		}
+
+		machine::Movie movie;
+		if (movieFilename) {
+			if (!machine::loadMovie(movieFilename, movie)) {
+				return 1;
+			}
+
+			// the trace starts from the movie's savestate, so restore it before recording
+			if (movie.hasSnapshot) {
+				machine.restore(movie.snapshot);
+				movie.hasSnapshot = false;
+			}
+		}
+		else if (!rl::startGame(machine)) {
+			return 1;
+		}
+
+		// without a ring buffer, blocks are written to the file as they fill, so only one is needed
+		cpu::TraceRecorder::Config config;
+		if (ringSize == 0) {
+			config.bufferSize = config.blockSize;
+		}
+		else {
+			config.bufferSize = ringSize * 1024 * 1024;
+		}
+
+		cpu::TraceRecorder recorder;
+		if (!recorder.init(config)) {
+			return 1;
+		}
+
+		cpu::CPU& cpu = machine.getCPU();
+		recorder.start(cpu.getState(), cpu.getNumSteps(), machine.getNumInterrupts());
+
+		if ((ringSize == 0) && !recorder.open(traceFilename)) {
+			return 1;
+		}
+
+		cpu.setTracer(&recorder);
+
+		auto start = std::chrono::steady_clock::now();
+
+		uint64_t numFramesRun = 0;
+		if (movieFilename) {
+			machine::ReplayResult result;
+			machine::replayMovie(machine, movie, result);
+			numFramesRun = result.numFrames;
+		}
+		else {
+			numFramesRun = playRandomGame(machine, numFrames, seed);
+		}
+
+		cpu.setTracer(nullptr);
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const bool isSaved = (ringSize == 0) ? recorder.close() : recorder.save(traceFilename);
+		if (!isSaved) {
+			printf("unable to write %s\n", traceFilename);
+			return 1;
+		}
+
+		const uint64_t numRecords = recorder.getNumRecords();
+		const uint64_t numBytes = recorder.getNumBytes();
+
+		printf("traced %llu frames in %.3f seconds: %llu records, %llu bytes (%.2f bytes per record)\n",
+			(unsigned long long)numFramesRun, seconds, (unsigned long long)numRecords, (unsigned long long)numBytes,
+			(numRecords > 0) ? (double(numBytes) / double(numRecords)) : 0.0);
+
+		if (recorder.getNumDiscardedBlocks() > 0) {
+			printf("ring buffer full - the oldest %llu blocks were discarded\n", (unsigned long long)recorder.getNumDiscardedBlocks());
+		}
+
+		printf("saved trace to %s\n", traceFilename);
+
+		return 0;
+	}
+
+	int runTraceDump(int argc, char** argv) {
+		if (argc < 2) {
+			printf("usage: tracedump <filename> [--from <step>] [--count <n>]\n");
+			return 1;
+		}
+
+		const char* traceFilename = argv[1];
+		const uint64_t fromStep = strtoull(findOption(argc, argv, "--from", "0"), nullptr, 10);
+		const uint64_t count = strtoull(findOption(argc, argv, "--count", "100"), nullptr, 10);
+
+		cpu::TraceReader reader;
+		if (!reader.open(traceFilename) || !reader.skipTo(fromStep)) {
+			return 1;
+		}
+
+		printf("%10s %6s  %-4s  %-9s %-16s  registers after\n", "step", "frame", "pc", "bytes", "instruction");
+
+		cpu::TraceRecord record;
+		uint64_t numPrinted = 0;
+		while ((numPrinted < count) && reader.next(record)) {
+			if (record.numSteps < fromStep) {
+				continue;
+			}
+
+			printRecord(record);
+			numPrinted++;
+		}
+
+		return 0;
+	}
+
+	int runTraceIndex(int argc, char** argv) {
+		if (argc < 2) {
+			printf("usage: traceindex <trace> [--out <filename>]\n");
+			return 1;
+		}
+
+		const char* traceFilename = argv[1];
+		const std::string defaultIndexFilename = std::string(traceFilename) + ".idx";
+		const char* indexFilename = findOption(argc, argv, "--out", defaultIndexFilename.c_str());
+
+		auto start = std::chrono::steady_clock::now();
+
+		if (!cpu::TraceIndex::build(traceFilename, indexFilename)) {
+			return 1;
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		cpu::TraceIndex index;
+		if (!index.open(indexFilename)) {
+			return 1;
+		}
+
+		printf("indexed steps %llu - %llu (frames %llu - %llu) in %.3f seconds, saved to %s\n",
+			(unsigned long long)index.getFirstStep(), (unsigned long long)index.getLastStep(),
+			(unsigned long long)index.getFirstFrame(), (unsigned long long)index.getLastFrame(), seconds, indexFilename);
+
+		return 0;
+	}
+
+	int runTraceQuery(int argc, char** argv) {
+		if (argc < 2) {
+			printf("usage: tracequery <index> (--address <address> | --in <port> | --out <port>) [--frames <from>:<to>] [--steps <from>:<to>] [--changed] [--pcs] [--count <n>]\n");
+			return 1;
+		}
+
+		const char* indexFilename = argv[1];
+		const char* address = findOption(argc, argv, "--address", nullptr);
+		const char* inPort = findOption(argc, argv, "--in", nullptr);
+		const char* outPort = findOption(argc, argv, "--out", nullptr);
+		const uint64_t count = strtoull(findOption(argc, argv, "--count", "100"), nullptr, 10);
+
+		// flags without a value
+		bool isChangedOnly = false;
+		bool isByPc = false;
+		for (int i = 2; i < argc; i++) {
+			isChangedOnly |= (strcmp(argv[i], "--changed") == 0);
+			isByPc |= (strcmp(argv[i], "--pcs") == 0);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		cpu::TraceIndex index;
+		if (!index.open(indexFilename)) {
+			return 1;
+		}
+
+		cpu::TraceIndex::Entries entries;
+		if (address) {
+			entries = index.getWrites(uint16_t(strtoul(address, nullptr, 0)));
+		}
+		else if (inPort) {
+			entries = index.getIns(uint8_t(strtoul(inPort, nullptr, 0)));
+		}
+		else if (outPort) {
+			entries = index.getOuts(uint8_t(strtoul(outPort, nullptr, 0)));
+		}
+		else {
+			printf("expected one of --address, --in or --out\n");
+			return 1;
+		}
+
+		// frames are inclusive - the steps of the last frame end where the frame after it starts
+		uint64_t fromFrame = index.getFirstFrame();
+		uint64_t toFrame = index.getLastFrame();
+		parseRange(findOption(argc, argv, "--frames", nullptr), fromFrame, toFrame);
+
+		uint64_t fromStep = std::max(index.getFrameStep(fromFrame), index.getFirstStep());
+		uint64_t toStep = (toFrame < index.getLastFrame()) ? (index.getFrameStep(toFrame + 1) - 1) : index.getLastStep();
+		parseRange(findOption(argc, argv, "--steps", nullptr), fromStep, toStep);
+
+		const size_t begin = entries.find(fromStep);
+		const size_t end = (toStep == ~uint64_t(0)) ? entries.size : entries.find(toStep + 1);
+
+		// PCs that made the writes, and how often
+		std::map<uint16_t, uint64_t> pcCounts;
+		std::vector<size_t> matches;
+
+		for (size_t i = begin; i < end; i++) {
+			if (isChangedOnly && (i > 0) && (entries.values[i] == entries.values[i - 1])) {
+				continue;
+			}
+
+			if (isByPc) {
+				pcCounts[entries.pcs[i]]++;
+			}
+			else if (matches.size() < count) {
+				matches.push_back(i);
+			}
+			else {
+				break;
+			}
+		}
+
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		printf("%zu of %zu entries in steps %llu - %llu, found in %.3f ms\n", end - begin, entries.size,
+			(unsigned long long)fromStep, (unsigned long long)toStep, milliseconds);
+
+		if (isByPc) {
+			std::vector<std::pair<uint64_t, uint16_t>> pcs;
+			for (const auto& pcCount : pcCounts) {
+				pcs.push_back({ pcCount.second, pcCount.first });
+			}
+			std::sort(pcs.rbegin(), pcs.rend());
+
+			printf("%6s  %10s\n", "pc", "count");
+			for (const auto& pc : pcs) {
+				printf("  %04x  %10llu\n", pc.second, (unsigned long long)pc.first);
+			}
+		}
+		else {
+			printf("%10s %6s  %-4s  %s\n", "step", "frame", "pc", "value");
+			for (size_t i : matches) {
+				printf("%10llu %6llu  %04x  %02x\n", (unsigned long long)entries.steps[i], (unsigned long long)index.getFrame(entries.steps[i]),
+					entries.pcs[i], entries.values[i]);
+			}
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,101 @@
+#include "util/BinaryStream.h"
+
+namespace util {
+	namespace {
+		template <typename T>
+		void writeLittleEndian(std::ostream& stream, T value) {
+			char bytes[sizeof(T)];
+			for (size_t i = 0; i < sizeof(T); i++) {
+				bytes[i] = char((value >> (8 * i)) & 0xff);
+			}
+
+			stream.write(bytes, sizeof(T));
+		}
+
+		template <typename T>
+		bool readLittleEndian(std::istream& stream, T& outValue) {
+			char bytes[sizeof(T)];
+			if (!stream.read(bytes, sizeof(T))) {
+				return false;
+			}
+
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); i++) {
+				value |= T(uint8_t(bytes[i])) << (8 * i);
+			}
+
+			outValue = value;
+
+			return true;
+		}
+	}
+
+	void writeU8(std::ostream& stream, uint8_t value) {
+		writeLittleEndian(stream, value);
+	}
+
+	void writeU16(std::ostream& stream, uint16_t value) {
+		writeLittleEndian(stream, value);
+	}
+
+	void writeU32(std::ostream& stream, uint32_t value) {
+		writeLittleEndian(stream, value);
+	}
+
+	void writeU64(std::ostream& stream, uint64_t value) {
+		writeLittleEndian(stream, value);
+	}
+
+	void writeBytes(std::ostream& stream, const uint8_t* data, size_t size) {
+		stream.write(reinterpret_cast<const char*>(data), size);
+	}
+
+	void writeVarint(std::ostream& stream, uint64_t value) {
+		while (value >= 0x80) {
+			writeU8(stream, uint8_t(value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+
+		writeU8(stream, uint8_t(value));
+	}
+
+	bool readU8(std::istream& stream, uint8_t& outValue) {
+		return readLittleEndian(stream, outValue);
+	}
+
+	bool readU16(std::istream& stream, uint16_t& outValue) {
+		return readLittleEndian(stream, outValue);
+	}
+
+	bool readU32(std::istream& stream, uint32_t& outValue) {
+		return readLittleEndian(stream, outValue);
+	}
+
+	bool readU64(std::istream& stream, uint64_t& outValue) {
+		return readLittleEndian(stream, outValue);
+	}
+
+	bool readBytes(std::istream& stream, uint8_t* outData, size_t size) {
+		return bool(stream.read(reinterpret_cast<char*>(outData), size));
+	}
+
+	bool readVarint(std::istream& stream, uint64_t& outValue) {
+		uint64_t value = 0;
+
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte;
+			if (!readU8(stream, byte)) {
+				return false;
+			}
+
+			value |= uint64_t(byte & 0x7f) << shift;
+
+			if ((byte & 0x80) == 0) {
+				outValue = value;
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
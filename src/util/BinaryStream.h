@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+namespace util {
+	// write little-endian values to a binary stream
+	void writeU8(std::ostream& stream, uint8_t value);
+	void writeU16(std::ostream& stream, uint16_t value);
+	void writeU32(std::ostream& stream, uint32_t value);
+	void writeU64(std::ostream& stream, uint64_t value);
+	void writeBytes(std::ostream& stream, const uint8_t* data, size_t size);
+
+	// write an unsigned value using 7 bits per byte, so small values take a single byte
+	void writeVarint(std::ostream& stream, uint64_t value);
+
+	// read little-endian values from a binary stream
+	// - return false if the stream ended before the value was read
+	bool readU8(std::istream& stream, uint8_t& outValue);
+	bool readU16(std::istream& stream, uint16_t& outValue);
+	bool readU32(std::istream& stream, uint32_t& outValue);
+	bool readU64(std::istream& stream, uint64_t& outValue);
+	bool readBytes(std::istream& stream, uint8_t* outData, size_t size);
+	bool readVarint(std::istream& stream, uint64_t& outValue);
+}
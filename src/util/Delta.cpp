@@ -0,0 +1,87 @@
+#include "util/Delta.h"
+
+namespace util {
+	namespace {
+		void writeVarint(std::vector<uint8_t>& out, size_t value) {
+			while (value >= 0x80) {
+				out.push_back(uint8_t(value & 0x7f) | 0x80);
+				value >>= 7;
+			}
+
+			out.push_back(uint8_t(value));
+		}
+
+		bool readVarint(const std::vector<uint8_t>& in, size_t& offset, size_t& outValue) {
+			size_t value = 0;
+			int shift = 0;
+
+			while (offset < in.size()) {
+				uint8_t byte = in[offset++];
+				value |= size_t(byte & 0x7f) << shift;
+
+				if ((byte & 0x80) == 0) {
+					outValue = value;
+					return true;
+				}
+
+				shift += 7;
+			}
+
+			return false;
+		}
+	}
+
+	void encodeXorDelta(const uint8_t* from, const uint8_t* to, size_t size, std::vector<uint8_t>& outDelta) {
+		outDelta.clear();
+
+		size_t i = 0;
+		while (i < size) {
+			size_t zeroRun = 0;
+			while ((i < size) && (from[i] == to[i])) {
+				zeroRun += 1;
+				i += 1;
+			}
+
+			if (i == size) {
+				// trailing zeros are implied
+				break;
+			}
+
+			// a literal run ends at the next pair of unchanged bytes, so isolated matches don't split it
+			size_t literalStart = i;
+			while ((i < size) && ((from[i] != to[i]) || ((i + 1 < size) && (from[i + 1] != to[i + 1])))) {
+				i += 1;
+			}
+
+			writeVarint(outDelta, zeroRun);
+			writeVarint(outDelta, i - literalStart);
+			for (size_t j = literalStart; j < i; j++) {
+				outDelta.push_back(from[j] ^ to[j]);
+			}
+		}
+	}
+
+	bool applyXorDelta(uint8_t* data, size_t size, const std::vector<uint8_t>& delta) {
+		size_t offset = 0;
+		size_t i = 0;
+
+		while (offset < delta.size()) {
+			size_t zeroRun;
+			size_t literalCount;
+			if (!readVarint(delta, offset, zeroRun) || !readVarint(delta, offset, literalCount)) {
+				return false;
+			}
+
+			i += zeroRun;
+			if ((i + literalCount > size) || (offset + literalCount > delta.size())) {
+				return false;
+			}
+
+			for (size_t j = 0; j < literalCount; j++) {
+				data[i++] ^= delta[offset++];
+			}
+		}
+
+		return true;
+	}
+}
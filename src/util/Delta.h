@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+	// encode the XOR of two equally sized buffers as a run-length encoded delta
+	// - delta is a sequence of [varint zero run][varint literal count][literal count bytes]
+	// - XOR is symmetric, so the same delta converts 'from' to 'to', and 'to' to 'from'
+	void encodeXorDelta(const uint8_t* from, const uint8_t* to, size_t size, std::vector<uint8_t>& outDelta);
+
+	// apply a delta created by encodeXorDelta to data in place
+	// - returns false if the delta is malformed, or does not match size
+	bool applyXorDelta(uint8_t* data, size_t size, const std::vector<uint8_t>& delta);
+}
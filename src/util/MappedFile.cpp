@@ -0,0 +1,126 @@
+#include "util/MappedFile.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace util {
+	MappedFile::MappedFile() :
+		memory(nullptr),
+		sizeMemory(0),
+		handle(nullptr),
+		mapping(nullptr)
+	{
+
+	}
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	bool MappedFile::open(const char* filename) {
+		return map(filename, 0, false);
+	}
+
+	bool MappedFile::create(const char* filename, size_t size) {
+		return map(filename, size, true);
+	}
+
+	bool MappedFile::map(const char* filename, size_t size, bool isWritable) {
+		close();
+
+#if defined(_WIN32)
+		handle = CreateFileA(filename, isWritable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, nullptr,
+			isWritable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE) {
+			handle = nullptr;
+			printf("MappedFile - unable to open %s (error %lu)\n", filename, GetLastError());
+			return false;
+		}
+
+		if (!isWritable) {
+			LARGE_INTEGER fileSize;
+			size = GetFileSizeEx(handle, &fileSize) ? size_t(fileSize.QuadPart) : 0;
+		}
+
+		if (size > 0) {
+			const uint64_t size64 = size;
+			mapping = CreateFileMappingA(handle, nullptr, isWritable ? PAGE_READWRITE : PAGE_READONLY, DWORD(size64 >> 32), DWORD(size64 & 0xffffffff), nullptr);
+		}
+
+		if (mapping) {
+			memory = static_cast<uint8_t*>(MapViewOfFile(mapping, isWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+		}
+#else
+		const int fd = isWritable ? ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644) : ::open(filename, O_RDONLY);
+		if (fd < 0) {
+			printf("MappedFile - unable to open %s\n", filename);
+			return false;
+		}
+
+		struct stat status;
+		if (!isWritable) {
+			size = (fstat(fd, &status) == 0) ? size_t(status.st_size) : 0;
+		}
+
+		void* view = MAP_FAILED;
+		if ((size > 0) && (!isWritable || (ftruncate(fd, off_t(size)) == 0))) {
+			view = mmap(nullptr, size, isWritable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+
+		memory = (view != MAP_FAILED) ? static_cast<uint8_t*>(view) : nullptr;
+#endif
+
+		sizeMemory = size;
+
+		if (!memory) {
+			printf("MappedFile - unable to map %s (%zu bytes)\n", filename, size);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::close() {
+#if defined(_WIN32)
+		if (memory) {
+			UnmapViewOfFile(memory);
+		}
+
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+
+		if (handle) {
+			CloseHandle(handle);
+		}
+#else
+		if (memory) {
+			munmap(memory, sizeMemory);
+		}
+#endif
+
+		memory = nullptr;
+		sizeMemory = 0;
+		handle = nullptr;
+		mapping = nullptr;
+	}
+
+	uint8_t* MappedFile::data() const {
+		return memory;
+	}
+
+	size_t MappedFile::size() const {
+		return sizeMemory;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+	/// @class MappedFile
+	/// @brief File mapped into memory, so it can be read in place without loading it
+	/// @note mmap on POSIX, a file mapping on Windows. Pages are only read from disk when they are touched, so
+	///       files larger than physical memory can be mapped.
+	class MappedFile {
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// map an existing file, read only
+		bool open(const char* filename);
+
+		// create a file of size bytes, replacing any existing file, and map it for writing
+		bool create(const char* filename, size_t size);
+
+		// unmap the file - changes to a created file are written back
+		void close();
+
+		uint8_t* data() const;
+		size_t size() const;
+
+	private:
+		bool map(const char* filename, size_t size, bool isWritable);
+
+		uint8_t* memory;
+		size_t sizeMemory;
+
+		// file + file mapping handles (Windows only)
+		void* handle;
+		void* mapping;
+	};
+}
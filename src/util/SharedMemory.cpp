@@ -0,0 +1,239 @@
+#include "util/SharedMemory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <csignal>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+	#include <climits>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+#endif
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomics in shared memory must be lock free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomics in shared memory must have the same layout as uint32_t");
+
+namespace util {
+	namespace {
+		// POSIX names start with a single '/', Windows names are local to the session
+		std::string getPlatformName(const char* name) {
+			const char* base = (name[0] == '/') ? (name + 1) : name;
+#if defined(_WIN32)
+			return std::string("Local\\") + base;
+#else
+			return std::string("/") + base;
+#endif
+		}
+	}
+
+	SharedMemory::SharedMemory() :
+		memory(nullptr),
+		sizeMemory(0),
+		isOwner(false),
+		handle(nullptr)
+	{
+
+	}
+
+	SharedMemory::~SharedMemory() {
+		close();
+	}
+
+	bool SharedMemory::create(const char* inName, size_t size) {
+		close();
+
+		name = getPlatformName(inName);
+
+#if defined(_WIN32)
+		const uint64_t size64 = size;
+		handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(size64 >> 32), DWORD(size64 & 0xffffffff), name.c_str());
+		if (!handle) {
+			printf("SharedMemory - unable to create '%s' (error %lu)\n", name.c_str(), GetLastError());
+			return false;
+		}
+
+		memory = static_cast<uint8_t*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+		// remove a region left behind by a process that did not shut down cleanly
+		shm_unlink(name.c_str());
+
+		const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0) {
+			printf("SharedMemory - unable to create '%s'\n", name.c_str());
+			return false;
+		}
+
+		void* mapping = MAP_FAILED;
+		if (ftruncate(fd, off_t(size)) == 0) {
+			mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+
+		memory = (mapping != MAP_FAILED) ? static_cast<uint8_t*>(mapping) : nullptr;
+#endif
+
+		isOwner = true;
+		sizeMemory = size;
+
+		if (!memory) {
+			printf("SharedMemory - unable to map '%s' (%zu bytes)\n", name.c_str(), size);
+			close();
+			return false;
+		}
+
+		// new regions are zero filled on every platform, but a replaced region may not be
+		memset(memory, 0, size);
+
+		return true;
+	}
+
+	bool SharedMemory::open(const char* inName) {
+		close();
+
+		name = getPlatformName(inName);
+
+#if defined(_WIN32)
+		handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+		if (!handle) {
+			printf("SharedMemory - unable to open '%s' (error %lu)\n", name.c_str(), GetLastError());
+			return false;
+		}
+
+		memory = static_cast<uint8_t*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+
+		MEMORY_BASIC_INFORMATION info;
+		if (memory && VirtualQuery(memory, &info, sizeof(info))) {
+			sizeMemory = info.RegionSize;
+		}
+#else
+		const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+		if (fd < 0) {
+			printf("SharedMemory - unable to open '%s'\n", name.c_str());
+			return false;
+		}
+
+		struct stat status;
+		void* mapping = MAP_FAILED;
+		if ((fstat(fd, &status) == 0) && (status.st_size > 0)) {
+			sizeMemory = size_t(status.st_size);
+			mapping = mmap(nullptr, sizeMemory, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+
+		memory = (mapping != MAP_FAILED) ? static_cast<uint8_t*>(mapping) : nullptr;
+#endif
+
+		if (!memory) {
+			printf("SharedMemory - unable to map '%s'\n", name.c_str());
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void SharedMemory::close() {
+#if defined(_WIN32)
+		if (memory) {
+			UnmapViewOfFile(memory);
+		}
+
+		if (handle) {
+			CloseHandle(handle);
+		}
+#else
+		if (memory) {
+			munmap(memory, sizeMemory);
+		}
+
+		if (isOwner) {
+			shm_unlink(name.c_str());
+		}
+#endif
+
+		memory = nullptr;
+		sizeMemory = 0;
+		isOwner = false;
+		handle = nullptr;
+	}
+
+	uint8_t* SharedMemory::data() const {
+		return memory;
+	}
+
+	size_t SharedMemory::size() const {
+		return sizeMemory;
+	}
+
+	void waitOnAddress(const std::atomic<uint32_t>& value, uint32_t expected, uint32_t timeoutMilliseconds) {
+#if defined(__linux__)
+		// shared futex (not FUTEX_PRIVATE_FLAG), so it can be woken from another process
+		struct timespec timeout;
+		timeout.tv_sec = timeoutMilliseconds / 1000;
+		timeout.tv_nsec = long(timeoutMilliseconds % 1000) * 1000000;
+
+		syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&value), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+		// WaitOnAddress() only works within a process, so poll - spin briefly, then yield the core
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+		for (uint32_t i = 0; value.load(std::memory_order_acquire) == expected; i++) {
+			if (i < 1000) {
+				std::this_thread::yield();
+			}
+			else if (std::chrono::steady_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+			else {
+				break;
+			}
+		}
+#endif
+	}
+
+	void wakeAddress(std::atomic<uint32_t>& value) {
+#if defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+		(void)value;
+#endif
+	}
+
+	uint32_t getProcessId() {
+#if defined(_WIN32)
+		return uint32_t(GetCurrentProcessId());
+#else
+		return uint32_t(getpid());
+#endif
+	}
+
+	bool isProcessRunning(uint32_t processId) {
+#if defined(_WIN32)
+		HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, DWORD(processId));
+		if (!process) {
+			// a process that can't be opened for another reason is still running
+			return GetLastError() == ERROR_ACCESS_DENIED;
+		}
+
+		const bool isRunning = (WaitForSingleObject(process, 0) == WAIT_TIMEOUT);
+		CloseHandle(process);
+
+		return isRunning;
+#else
+		// signal 0 checks the process exists, without signalling it
+		return (kill(pid_t(processId), 0) == 0) || (errno == EPERM);
+#endif
+	}
+}
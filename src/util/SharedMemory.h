@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace util {
+
+	/// @class SharedMemory
+	/// @brief Named region of memory, shared between processes on the same host
+	/// @note POSIX shared memory (shm_open + mmap), or a named file mapping on Windows. The region is removed
+	///       when the process that created it closes it - processes that opened it keep their mapping.
+	class SharedMemory {
+	public:
+		SharedMemory();
+		~SharedMemory();
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		// create a zero filled region of size bytes, replacing any existing region with the same name
+		bool create(const char* name, size_t size);
+
+		// open a region created by another process
+		bool open(const char* name);
+
+		void close();
+
+		uint8_t* data() const;
+		size_t size() const;
+
+	private:
+		uint8_t* memory;
+		size_t sizeMemory;
+		std::string name;
+		bool isOwner;
+
+		// file mapping handle (Windows only)
+		void* handle;
+	};
+
+	// block while value is equal to expected, until woken by wakeAddress() or timeoutMilliseconds have passed
+	// - value may be in shared memory, and woken from another process. Uses a futex on Linux, and polls on
+	//   other platforms. May return early, so callers should check value again
+	void waitOnAddress(const std::atomic<uint32_t>& value, uint32_t expected, uint32_t timeoutMilliseconds);
+
+	// wake every thread (in any process) blocked in waitOnAddress() on value
+	void wakeAddress(std::atomic<uint32_t>& value);
+
+	// id of the calling process, to record in shared memory
+	uint32_t getProcessId();
+
+	// true while the process with id processId is running - so a process that exits without cleaning up its
+	// shared state (i.e. crashes) can be detected by the others
+	bool isProcessRunning(uint32_t processId);
+}
@@ -0,0 +1,174 @@
+#include "util/Socket.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#pragma comment(lib, "ws2_32.lib")
+
+	typedef int socklen_t;
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+#endif
+
+namespace util {
+	namespace {
+#if defined(_WIN32)
+		typedef SOCKET Handle;
+
+		// Winsock is started once, and left running until the process exits
+		bool startup() {
+			static const bool isStarted = []() {
+				WSADATA data;
+				return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+			}();
+
+			return isStarted;
+		}
+
+		int pollHandle(Handle handle, uint32_t timeoutMilliseconds) {
+			WSAPOLLFD descriptor = { handle, POLLRDNORM, 0 };
+			return WSAPoll(&descriptor, 1, int(timeoutMilliseconds));
+		}
+
+		void closeHandle(Handle handle) {
+			closesocket(handle);
+		}
+#else
+		typedef int Handle;
+
+		bool startup() {
+			return true;
+		}
+
+		int pollHandle(Handle handle, uint32_t timeoutMilliseconds) {
+			pollfd descriptor = { handle, POLLIN, 0 };
+			return poll(&descriptor, 1, int(timeoutMilliseconds));
+		}
+
+		void closeHandle(Handle handle) {
+			::close(handle);
+		}
+#endif
+	}
+
+	Socket::Socket() :
+		handle(kInvalid)
+	{
+
+	}
+
+	Socket::~Socket() {
+		close();
+	}
+
+	bool Socket::listen(uint16_t port) {
+		close();
+
+		if (!startup()) {
+			printf("Socket - unable to start sockets\n");
+			return false;
+		}
+
+		const Handle listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (listener == Handle(kInvalid)) {
+			printf("Socket - unable to create socket\n");
+			return false;
+		}
+
+		// a port left in TIME_WAIT by a previous run can be listened on straight away
+		const int isReused = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&isReused), sizeof(isReused));
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if ((::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) || (::listen(listener, 1) != 0)) {
+			printf("Socket - unable to listen on 127.0.0.1:%u\n", port);
+			closeHandle(listener);
+			return false;
+		}
+
+		handle = intptr_t(listener);
+
+		return true;
+	}
+
+	bool Socket::accept(Socket& outConnection, uint32_t timeoutMilliseconds) {
+		if (!isOpen() || (pollHandle(Handle(handle), timeoutMilliseconds) <= 0)) {
+			return false;
+		}
+
+		const Handle connection = ::accept(Handle(handle), nullptr, nullptr);
+		if (connection == Handle(kInvalid)) {
+			return false;
+		}
+
+		// packets are small + answered one at a time, so send them without waiting to fill a segment
+		const int isNoDelay = 1;
+		setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&isNoDelay), sizeof(isNoDelay));
+
+		outConnection.close();
+		outConnection.handle = intptr_t(connection);
+
+		return true;
+	}
+
+	int Socket::receive(uint8_t* data, size_t size, uint32_t timeoutMilliseconds) {
+		if (!isOpen()) {
+			return -1;
+		}
+
+		const int numReady = pollHandle(Handle(handle), timeoutMilliseconds);
+		if (numReady == 0) {
+			return 0;
+		}
+
+		const int numReceived = (numReady > 0) ? int(::recv(Handle(handle), reinterpret_cast<char*>(data), int(size), 0)) : -1;
+
+		return (numReceived > 0) ? numReceived : -1;
+	}
+
+	bool Socket::send(const uint8_t* data, size_t size) {
+		// a connection closed by the other end is reported as an error, rather than raising SIGPIPE
+#if defined(MSG_NOSIGNAL)
+		const int flags = MSG_NOSIGNAL;
+#else
+		const int flags = 0;
+#endif
+
+		while (isOpen() && (size > 0)) {
+			const int numSent = int(::send(Handle(handle), reinterpret_cast<const char*>(data), int(size), flags));
+			if (numSent <= 0) {
+				return false;
+			}
+
+			data += numSent;
+			size -= size_t(numSent);
+		}
+
+		return (size == 0);
+	}
+
+	void Socket::close() {
+		if (isOpen()) {
+			closeHandle(Handle(handle));
+			handle = kInvalid;
+		}
+	}
+
+	bool Socket::isOpen() const {
+		return (handle != kInvalid);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+	/// @class Socket
+	/// @brief TCP socket on the loopback interface - a listener that accepts connections, or one connection
+	/// @note BSD sockets, or Winsock on Windows. Only 127.0.0.1 is listened on, so nothing is exposed beyond
+	///       the host. Receiving + sending may happen on different threads.
+	class Socket {
+	public:
+		Socket();
+		~Socket();
+
+		Socket(const Socket&) = delete;
+		Socket& operator=(const Socket&) = delete;
+
+		// listen for connections on 127.0.0.1:port
+		bool listen(uint16_t port);
+
+		// wait up to timeoutMilliseconds for a connection to a listening socket - returns false on timeout
+		bool accept(Socket& outConnection, uint32_t timeoutMilliseconds);
+
+		// wait up to timeoutMilliseconds for data - returns the number of bytes received, 0 on timeout, or
+		// -1 once the connection is closed
+		int receive(uint8_t* data, size_t size, uint32_t timeoutMilliseconds);
+
+		// send all of data, blocking until it is sent
+		bool send(const uint8_t* data, size_t size);
+
+		void close();
+
+		bool isOpen() const;
+
+	private:
+		// SOCKET on Windows, file descriptor on POSIX - kInvalid when closed
+		intptr_t handle;
+
+		static const intptr_t kInvalid = -1;
+	};
+}
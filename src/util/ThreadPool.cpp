@@ -0,0 +1,139 @@
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+
+namespace util {
+	ThreadPool::ThreadPool(size_t numThreads) :
+		generation(0),
+		isStopping(false),
+		numPendingRanges(0),
+		numSteals(0)
+	{
+		if (numThreads == 0) {
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		for (size_t i = 0; i < numThreads; i++) {
+			queues.push_back(std::unique_ptr<Queue>(new Queue()));
+		}
+
+		for (size_t i = 0; i < numThreads; i++) {
+			threads.push_back(std::thread(&ThreadPool::runWorker, this, i));
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		conditionWork.notify_all();
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	size_t ThreadPool::getNumThreads() const {
+		return threads.size();
+	}
+
+	uint64_t ThreadPool::getNumSteals() const {
+		return numSteals;
+	}
+
+	void ThreadPool::parallelFor(size_t count, size_t grainSize, const Task& inTask) {
+		if (count == 0) {
+			return;
+		}
+
+		grainSize = std::max<size_t>(grainSize, 1);
+
+		const size_t numRanges = (count + grainSize - 1) / grainSize;
+		const size_t numQueues = queues.size();
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		numPendingRanges = numRanges;
+
+		// deal contiguous blocks of chunks to each queue, so that workers start on neighbouring data
+		for (size_t i = 0; i < numRanges; i++) {
+			const size_t queueIndex = (i * numQueues) / numRanges;
+
+			Range range;
+			range.task = &inTask;
+			range.begin = i * grainSize;
+			range.end = std::min(count, range.begin + grainSize);
+
+			Queue& queue = *queues[queueIndex];
+			std::lock_guard<std::mutex> queueLock(queue.mutex);
+			queue.ranges.push_back(range);
+		}
+
+		generation++;
+		conditionWork.notify_all();
+
+		conditionDone.wait(lock, [this] { return numPendingRanges == 0; });
+	}
+
+	bool ThreadPool::popRange(size_t workerIndex, Range& outRange) {
+		Queue& queue = *queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.ranges.empty()) {
+			return false;
+		}
+
+		outRange = queue.ranges.back();
+		queue.ranges.pop_back();
+
+		return true;
+	}
+
+	bool ThreadPool::stealRange(size_t workerIndex, Range& outRange) {
+		const size_t numQueues = queues.size();
+
+		for (size_t i = 1; i < numQueues; i++) {
+			Queue& queue = *queues[(workerIndex + i) % numQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (!queue.ranges.empty()) {
+				outRange = queue.ranges.front();
+				queue.ranges.pop_front();
+
+				numSteals++;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::runWorker(size_t workerIndex) {
+		uint64_t lastGeneration = 0;
+
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				conditionWork.wait(lock, [&] { return isStopping || (generation != lastGeneration); });
+
+				if (isStopping) {
+					return;
+				}
+
+				lastGeneration = generation;
+			}
+
+			Range range;
+			while (popRange(workerIndex, range) || stealRange(workerIndex, range)) {
+				(*range.task)(range.begin, range.end);
+
+				if (--numPendingRanges == 0) {
+					// take the lock, so the notify can not be missed between the waiter's check and its wait
+					std::lock_guard<std::mutex> lock(mutex);
+					conditionDone.notify_all();
+				}
+			}
+		}
+	}
+}
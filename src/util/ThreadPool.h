@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+	/// @class ThreadPool
+	/// @brief Fixed set of worker threads that split a range of work between them
+	/// @note each worker has its own queue of chunks. A worker takes chunks from the back of its own
+	///       queue, and when that is empty steals chunks from the front of other workers' queues, so
+	///       uneven chunks (i.e. machines that take longer to run a frame) are balanced between workers.
+	class ThreadPool {
+	public:
+		// numThreads of 0 uses one thread per hardware thread
+		explicit ThreadPool(size_t numThreads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t getNumThreads() const;
+
+		// Task - invoked with a range [begin, end) of indices to process
+		typedef std::function<void(size_t begin, size_t end)> Task;
+
+		// split [0, count) into chunks of grainSize indices, and run task on every chunk
+		// - blocks until all chunks have completed
+		void parallelFor(size_t count, size_t grainSize, const Task& task);
+
+		// number of chunks that were stolen from another worker's queue, since construction
+		uint64_t getNumSteals() const;
+
+	private:
+		// each range carries its task, so a worker that wakes late never pairs a range with a stale task
+		struct Range {
+			const Task* task;
+			size_t begin;
+			size_t end;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Range> ranges;
+		};
+
+		bool popRange(size_t workerIndex, Range& outRange);
+		bool stealRange(size_t workerIndex, Range& outRange);
+		void runWorker(size_t workerIndex);
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable conditionWork;
+		std::condition_variable conditionDone;
+
+		uint64_t generation;
+		bool isStopping;
+
+		std::atomic<size_t> numPendingRanges;
+		std::atomic<uint64_t> numSteals;
+	};
+}
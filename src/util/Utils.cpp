@@ -1,6 +1,7 @@
 #include "util/Utils.h"
 
 #include <cassert>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 
@@ -41,4 +42,39 @@ namespace util {
 
 		return size;
 	}
+
+	bool readFile(const char* filename, std::vector<uint8_t>& outData) {
+		std::ifstream file;
+		file.open(filename, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			printf("unable to open %s\n", filename);
+			return false;
+		}
+
+		outData.resize(static_cast<size_t>(file.tellg()));
+
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(outData.data()), outData.size());
+
+		return file.good();
+	}
+
+	uint64_t hash(const uint8_t* data, size_t size) {
+		uint64_t value = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i < size; i++) {
+			value ^= data[i];
+			value *= 0x100000001b3ull;
+		}
+
+		return value;
+	}
+
+	uint64_t mix(uint64_t value) {
+		value += 0x9e3779b97f4a7c15ull;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+
+		return value ^ (value >> 31);
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 namespace util {
 	// make a 16bit word from two bytes
@@ -14,4 +15,13 @@ namespace util {
 
 	// measure size of file
 	size_t getFileSize(const char* filename);
+
+	// read the entire contents of a file into outData
+	bool readFile(const char* filename, std::vector<uint8_t>& outData);
+
+	// 64bit FNV-1a hash of a block of data
+	uint64_t hash(const uint8_t* data, size_t size);
+
+	// scramble the bits of a 64bit value (splitmix64 finaliser) - i.e. to derive a random looking key from an index
+	uint64_t mix(uint64_t value);
 }
\ No newline at end of file